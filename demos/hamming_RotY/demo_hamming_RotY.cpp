@@ -11,6 +11,7 @@
 
 #include "IntelSimulator.cpp"  
 #include "Simulator.hpp"  
+#include "Ensemble.hpp"
 #include <map>
 #include <iterator>
 #include <string>
@@ -63,7 +64,7 @@ int main(int argc, char **argv){
         len_reg_memory = atoi(argv[4]);
     }
     else{
-        std::cerr << "Error: " << argc << " arguments supplied, expected 1, 2, 3 or 4 (verbosity [bool], test pattern [unsigned integer], number of shots [unsigned integer], length of binary states to encode [unsigned integer]). " << std::endl;
+        std::cerr << "Error: " << argc << " arguments supplied, expected 1, 2, 3, 4 or 5 (verbosity [bool], test pattern [unsigned integer], number of shots [unsigned integer], length of binary states to encode [unsigned integer], seed [unsigned integer]). " << std::endl;
     }
 
     // Set up length of each quantum register.
@@ -71,15 +72,30 @@ int main(int argc, char **argv){
     std::size_t num_qubits = len_reg_memory + len_reg_auxiliary;;
     std::size_t num_bin_pattern = pow(2,len_reg_memory);    // It is possible to encode less binary patters if desired.
 
-    SimulatorGeneral<IntelSimulator> *sim = new IntelSimulator(num_qubits);
-
     int rank;
 #if ENABLE_MPI
+    // The ensemble only constructs its simulators on the first run, so MPI is initialised here
+    int mpi_is_init;
+    MPI_Initialized(&mpi_is_init);
+    if(! mpi_is_init){
+        MPI_Init(&argc, &argv);
+    }
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 #else
     rank = 0;
 #endif
 
+    // The shots must be drawn from the same seed on every rank; without a given seed, that of rank 0 is used
+    std::uint64_t seed = PhiloxStream::randomSeed();
+    if(argc > 5){
+        seed = std::stoull(argv[5]);
+    }
+#if ENABLE_MPI
+    else{
+        MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    }
+#endif
+
 
     // Set up vectors to store indices within general register
     std::vector<std::size_t> reg_auxiliary(len_reg_auxiliary);
@@ -97,19 +113,21 @@ int main(int argc, char **argv){
         vec_to_encode[i] = i;
     }
 
-    std::size_t val;
-
     // Init counter to store distribution of measured states.
     std::map<std::size_t, std::size_t> count;
     for(std::size_t i = 0; i < num_bin_pattern; i++){
         count.insert(pair<std::size_t, std::size_t>(vec_to_encode[i],0));
     }
 
-    // Repeated shots of experiment
-    for(int exp = 0; exp < num_exps; exp++){
+    // Repeated shots of experiment, each on a simulator re-initialised by the ensemble. Shots are spread over one single-threaded simulator per OpenMP thread; printed states and logged gates need a single simulator.
+    int num_workers = verbose ? 1 : 0;
+    #ifdef GATE_LOGGING
+    num_workers = 1;
+    #endif
+    Ensemble<IntelSimulator> ensemble(num_qubits, num_workers);
 
-        // Re-initialise register before each experiemnt
-        sim->initRegister();
+    auto experiment = [&](IntelSimulator& s) -> std::size_t {
+        SimulatorGeneral<IntelSimulator> *sim = &s;
 
         // Encode binary vectors
         #ifdef GATE_LOGGING
@@ -142,18 +160,24 @@ int main(int argc, char **argv){
         }
 
         // Measure a single state
-        val = sim->applyMeasurementToRegister(reg_memory);
+        std::size_t val = sim->applyMeasurementToRegister(reg_memory);
 
         // Print final measured state.
         if(verbose){
             sim->PrintStates("After Measurement: ");
         }
 
-        // Increment count of measured state
-        count[val] += 1;
+        return val;
+    };
+    auto result = ensemble.run(experiment, num_exps, seed);
+
+    // Increment count of measured states
+    for(auto& measured : result.counts){
+        count[measured.first] += measured.second;
     }
 
     if(rank == 0){
+        cout << "Shots: " << result.num_shots << " on " << result.num_workers << " simulators, " << result.shots_per_second << " shots/s" << endl;
         cout << "Measure:" << endl;
         int i = 0;
         for(map<std::size_t, std::size_t>::iterator it = count.begin(); it !=count.end(); ++it){
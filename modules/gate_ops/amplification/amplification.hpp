@@ -0,0 +1,117 @@
+/**
+ * @file amplification.hpp
+ * @brief Functions for applying Grover amplitude amplification to the states flagged by the Hamming distance target qubit
+ * @version 0.1
+ */
+
+#ifndef QNLP_AMPLIFICATION
+#define QNLP_AMPLIFICATION
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace QNLP{
+    /**
+     * @brief Class definition for applying amplitude amplification to the similarity-encoded state. The states with the Hamming target qubit in |1> are amplified, increasing the probability of a successful post-selection.
+     * 
+     * @tparam SimulatorType Class Simulator type
+     */
+    template <class SimulatorType>
+    class AmplitudeAmplification{
+        public:
+        /**
+         * @brief Construct a new Amplitude Amplification object
+         * 
+         */
+        AmplitudeAmplification(){};
+
+        /**
+         * @brief Destroy the Amplitude Amplification object
+         * 
+         */
+        ~AmplitudeAmplification(){};
+
+        /**
+         * @brief Number of Grover iterations maximising the probability of the good states, sin^2((2k+1)theta), given their initial probability sin^2(theta)
+         * 
+         * @param probability Initial probability of the good states
+         * @return std::size_t Optimal number of iterations; 0 if the good states have zero or unit probability
+         */
+        static std::size_t optimalIterations(double probability){
+            if(probability <= 0. || probability >= 1.){
+                return 0;
+            }
+            const double theta = std::asin(std::sqrt(probability));
+            return static_cast<std::size_t>(std::floor(M_PI / (4.*theta)));
+        }
+
+        /**
+         * @brief Apply a single Grover iterate (up to global phase), flipping the phase of the states with the target qubit in |1> and reflecting about the stored prepared state.
+         * 
+         * @param sim Simulator object holding a state snapshot
+         * @param target Good state flag qubit
+         */
+        static void applyGroverIterate(SimulatorType& sim, std::size_t target){
+            sim.applyGateZ(target);
+            sim.applyStateReflection();
+        }
+
+        /**
+         * @brief Probability of the Hamming target qubit being in |1> after the encoding and Hamming distance routines. Each matching bit of a pattern and the test pattern rotates the target by pi/len_bin_pattern, so a pattern at Hamming distance d contributes sin^2((len_bin_pattern - d) pi/(2 len_bin_pattern)), averaged over the equally weighted patterns.
+         * 
+         * @param patterns Encoded memory patterns
+         * @param test_pattern Test pattern of the Hamming distance
+         * @param len_bin_pattern Length of the patterns
+         * @return double Probability of the good states
+         */
+        static double similarityProbability(const std::vector<std::size_t>& patterns, std::size_t test_pattern, std::size_t len_bin_pattern){
+            if(patterns.empty() || len_bin_pattern == 0){
+                return 0.;
+            }
+            const double theta = M_PI / (double) len_bin_pattern;
+
+            double probability = 0.;
+            for(auto p : patterns){
+                std::size_t matches = 0;
+                for(std::size_t i = 0; i < len_bin_pattern; i++){
+                    matches += ((p >> i) & 0b1) == ((test_pattern >> i) & 0b1);
+                }
+                probability += std::pow(std::sin(0.5*theta*matches), 2);
+            }
+            return probability / patterns.size();
+        }
+
+        /**
+         * @brief Amplify the states with the Hamming target qubit in |1>. Must be called on the state prepared by the encoding and Hamming distance routines, prior to the post-selection of the target qubit. The prepared state is stored by the simulator for the duration of the call.
+         * 
+         * @param sim Simulator object
+         * @param reg_memory Memory register qubit indices; the pattern length is its size
+         * @param reg_auxiliary Auxiliary register qubit indices; the second last qubit is the Hamming target
+         * @param patterns Memory patterns encoded in the state
+         * @param test_pattern Test pattern of the Hamming distance
+         * @param iterations Number of Grover iterations; if 0, the optimal number is determined from the target probability of the encoded patterns
+         * @return std::size_t Number of Grover iterations applied
+         */
+        static std::size_t amplifySimilarity(SimulatorType& sim, const std::vector<std::size_t>& reg_memory, const std::vector<std::size_t>& reg_auxiliary, const std::vector<std::size_t>& patterns, std::size_t test_pattern, std::size_t iterations = 0){
+            // Require length of auxiliary register to have n+2 qubits
+            assert(reg_memory.size() + 1 < reg_auxiliary.size());
+
+            const std::size_t target = *(reg_auxiliary.end()-2);
+            if(iterations == 0){
+                iterations = optimalIterations(similarityProbability(patterns, test_pattern, reg_memory.size()));
+            }
+            if(iterations == 0){
+                return 0;
+            }
+
+            sim.storeStateSnapshot();
+            for(std::size_t k = 0; k < iterations; k++){
+                applyGroverIterate(sim, target);
+            }
+            sim.releaseStateSnapshot();
+            return iterations;
+        }
+    };
+};
+#endif
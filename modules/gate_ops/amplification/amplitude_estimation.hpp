@@ -0,0 +1,202 @@
+/**
+ * @file amplitude_estimation.hpp
+ * @brief Maximum likelihood amplitude estimation (without QFT) of the post-selection and per-pattern similarity probabilities of the Hamming-encoded state
+ * @version 0.1
+ */
+
+#ifndef QNLP_AMPLITUDE_ESTIMATION
+#define QNLP_AMPLITUDE_ESTIMATION
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Philox.hpp"
+
+namespace QNLP{
+    /**
+     * @brief Result of an amplitude estimation, along with the shot and circuit budget used to obtain it
+     * 
+     */
+    struct AmplitudeEstimate{
+        double probability = 0.;                //Maximum likelihood estimate of the marked state probability
+        double std_error = 0.;                  //Standard error of the estimate (Cramer-Rao bound)
+        double ci_lower = 0.;                   //Lower bound of the confidence interval
+        double ci_upper = 1.;                   //Upper bound of the confidence interval
+        std::size_t num_shots = 0;              //Total number of measurements
+        std::size_t num_oracle_queries = 0;     //Total Grover iterates applied over all shots
+        std::size_t num_state_preparations = 0; //Total applications of the state preparation or its inverse over all shots
+        std::size_t max_grover_power = 0;       //Largest number of Grover iterates in a single circuit
+    };
+
+    /**
+     * @brief Class definition for maximum likelihood amplitude estimation (MLAE, https://arxiv.org/abs/1904.10246). Circuits with Q^m applied to the prepared state, for m = 0, 1, 2, 4, ..., are each sampled for a fixed number of shots, and the amplitude maximising the combined likelihood is taken as the estimate. This reaches the same error as sampling the prepared state with quadratically fewer state preparations, and requires no QFT.
+     * 
+     * The Grover iterates reflect about a snapshot of the prepared state held by the simulator (see AmplitudeAmplification). Each shot of a circuit is a Bernoulli draw of the exact marked probability from a Philox stream, so the reported shot counts and errors correspond to running the circuits on a device, and the outcomes are reproducible from the seed.
+     * 
+     * @tparam SimulatorType Class Simulator type
+     */
+    template <class SimulatorType>
+    class AmplitudeEstimation{
+        public:
+        /**
+         * @brief Construct a new Amplitude Estimation object
+         * 
+         * @param num_powers Number of circuits in the schedule m = 0, 1, 2, 4, ..., 2^(num_powers-2)
+         * @param shots_per_power Number of shots per circuit
+         * @param z_score Number of standard errors spanned by the confidence interval (1.96 for 95%)
+         * @param seed Seed of the shot sampling; must agree over all MPI ranks
+         */
+        AmplitudeEstimation(std::size_t num_powers = 6, std::size_t shots_per_power = 100, double z_score = 1.96, std::uint64_t seed = 0) : 
+            shots_per_power(shots_per_power), z_score(z_score), rng(seed) {
+            assert(num_powers > 0);
+            powers.push_back(0);
+            for(std::size_t k = 1; k < num_powers; k++){
+                powers.push_back(0b1UL << (k-1));
+            }
+        };
+
+        /**
+         * @brief Destroy the Amplitude Estimation object
+         * 
+         */
+        ~AmplitudeEstimation(){};
+
+        /**
+         * @brief Estimate the probability of the sub-register defined by marker_qubits matching any of the marked patterns. The simulator must hold the prepared state, which is restored on return.
+         * 
+         * @param sim Simulator object
+         * @param marker_qubits Indices of the qubits forming the marker sub-register
+         * @param marked_patterns Marker sub-register values flagging the good states
+         * @return AmplitudeEstimate Estimate, confidence interval and budget
+         */
+        AmplitudeEstimate estimate(SimulatorType& sim, const std::vector<std::size_t>& marker_qubits, const std::vector<std::size_t>& marked_patterns){
+            std::vector<std::size_t> hits;
+            sim.storeStateSnapshot();
+
+            // Each power extends the previous circuit by the additional Grover iterates
+            std::size_t applied = 0;
+            for(auto m : powers){
+                for(; applied < m; applied++){
+                    sim.applyPatternPhaseFlip(marker_qubits, marked_patterns);
+                    sim.applyStateReflection();
+                }
+                const double p = std::min(std::max(sim.getPatternProbability(marker_qubits, marked_patterns), 0.), 1.);
+                std::size_t h = 0;
+                for(std::size_t shot = 0; shot < shots_per_power; shot++){
+                    h += (rng.uniform() < p);
+                }
+                hits.push_back(h);
+            }
+
+            sim.restoreStateSnapshot();
+            sim.releaseStateSnapshot();
+
+            AmplitudeEstimate result;
+            const double theta = maximumLikelihood(powers, hits, shots_per_power);
+            result.probability = std::pow(std::sin(theta), 2);
+
+            // Fisher information of theta; da/dtheta = sin(2 theta)
+            double fisher = 0.;
+            for(auto m : powers){
+                fisher += 4. * shots_per_power * (2*m + 1) * (2*m + 1);
+                result.num_shots += shots_per_power;
+                result.num_oracle_queries += shots_per_power * m;
+                result.num_state_preparations += shots_per_power * (2*m + 1);
+            }
+            result.std_error = std::abs(std::sin(2.*theta)) / std::sqrt(fisher);
+            result.ci_lower = std::max(result.probability - z_score*result.std_error, 0.);
+            result.ci_upper = std::min(result.probability + z_score*result.std_error, 1.);
+            result.max_grover_power = powers.back();
+            return result;
+        }
+
+        /**
+         * @brief Estimate the post-selection probability of the Hamming target qubit (second last auxiliary qubit) being in |1>
+         * 
+         * @param sim Simulator object holding the state prepared by the encoding and Hamming distance routines
+         * @param reg_auxiliary Auxiliary register qubit indices
+         * @return AmplitudeEstimate Estimate, confidence interval and budget
+         */
+        AmplitudeEstimate estimatePostSelection(SimulatorType& sim, const std::vector<std::size_t>& reg_auxiliary){
+            assert(reg_auxiliary.size() > 1);
+            return estimate(sim, { *(reg_auxiliary.end()-2) }, { 0b1 });
+        }
+
+        /**
+         * @brief Estimate the per-pattern similarity, as the joint probability of the memory register holding each given pattern and the Hamming target qubit being in |1>
+         * 
+         * @param sim Simulator object holding the state prepared by the encoding and Hamming distance routines
+         * @param reg_memory Memory register qubit indices
+         * @param reg_auxiliary Auxiliary register qubit indices
+         * @param patterns Memory register patterns to estimate
+         * @return std::vector<AmplitudeEstimate> Estimate, confidence interval and budget for each pattern
+         */
+        std::vector<AmplitudeEstimate> estimateSimilarity(SimulatorType& sim, const std::vector<std::size_t>& reg_memory, const std::vector<std::size_t>& reg_auxiliary, const std::vector<std::size_t>& patterns){
+            assert(reg_memory.size() + 1 < reg_auxiliary.size());
+
+            std::vector<std::size_t> marker_qubits(reg_memory);
+            marker_qubits.push_back( *(reg_auxiliary.end()-2) );
+
+            std::vector<AmplitudeEstimate> results;
+            for(auto p : patterns){
+                results.push_back( estimate(sim, marker_qubits, { p | (0b1UL << reg_memory.size()) }) );
+            }
+            return results;
+        }
+
+        /**
+         * @brief Maximise the likelihood of the observed hits, prod_k sin^2((2m_k+1)theta)^h_k cos^2((2m_k+1)theta)^(N-h_k), over theta in [0, pi/2]. A grid resolving the fastest oscillation is searched, followed by a golden-section refinement.
+         * 
+         * @param powers Number of Grover iterates m_k of each circuit
+         * @param hits Number of marked outcomes h_k of each circuit
+         * @param shots Number of shots N per circuit
+         * @return double Maximum likelihood angle theta, with the marked probability sin^2(theta)
+         */
+        static double maximumLikelihood(const std::vector<std::size_t>& powers, const std::vector<std::size_t>& hits, std::size_t shots){
+            const double eps = 1e-300;
+            auto logLikelihood = [&](double theta){
+                double l = 0.;
+                for(std::size_t k = 0; k < powers.size(); k++){
+                    const double s2 = std::pow(std::sin((2*powers[k] + 1) * theta), 2);
+                    l += hits[k] * std::log(std::max(s2, eps)) + (shots - hits[k]) * std::log(std::max(1. - s2, eps));
+                }
+                return l;
+            };
+
+            const std::size_t num_grid = 100 * (2 * *std::max_element(powers.begin(), powers.end()) + 1);
+            const double step = 0.5 * M_PI / num_grid;
+            double theta_best = 0., l_best = logLikelihood(0.);
+            for(std::size_t i = 1; i <= num_grid; i++){
+                const double l = logLikelihood(i*step);
+                if(l > l_best){
+                    l_best = l;
+                    theta_best = i*step;
+                }
+            }
+
+            const double golden = 0.5 * (std::sqrt(5.) - 1.);
+            double a = std::max(theta_best - step, 0.), b = std::min(theta_best + step, 0.5*M_PI);
+            for(std::size_t i = 0; i < 60; i++){
+                const double c = b - golden*(b - a), d = a + golden*(b - a);
+                if(logLikelihood(c) > logLikelihood(d)){
+                    b = d;
+                }
+                else{
+                    a = c;
+                }
+            }
+            const double theta = 0.5*(a + b);
+            return (logLikelihood(theta) > l_best) ? theta : theta_best;
+        }
+
+        private:
+        std::vector<std::size_t> powers;
+        std::size_t shots_per_power;
+        double z_score;
+        PhiloxStream rng;
+    };
+};
+#endif
@@ -0,0 +1,186 @@
+#include "amplification.hpp"
+#include "amplitude_estimation.hpp"
+
+#include "Simulator.hpp"
+#include "IntelSimulator.cpp"
+#include "catch2/catch.hpp"
+
+#include <cmath>
+
+using namespace QNLP;
+
+template class QNLP::AmplitudeAmplification<IntelSimulator>;
+template class QNLP::AmplitudeEstimation<IntelSimulator>;
+
+/**
+ * @brief Prepare the similarity-encoded state of the given patterns against the test pattern, prior to post-selection
+ * 
+ */
+void prepareSimilarityState(IntelSimulator& sim, const std::vector<std::size_t>& reg_memory, const std::vector<std::size_t>& reg_auxiliary, std::vector<std::size_t>& patterns, std::size_t test_pattern){
+    sim.initRegister();
+    sim.encodeBinToSuperpos_unique(reg_memory, reg_auxiliary, patterns, reg_memory.size());
+    sim.applyHammingDistanceRotY(test_pattern, reg_memory, reg_auxiliary, reg_memory.size());
+}
+
+/**
+ * @brief Test amplification of the Hamming target qubit; the target probability must follow sin^2((2k+1)theta) and the post-selected state must be unchanged.
+ * 
+ */
+TEST_CASE("Amplitude amplification of similarity-encoded state","[amplification]"){
+    const std::size_t len_reg_memory = 4;
+    const std::size_t len_reg_auxiliary = len_reg_memory + 2;
+    const std::size_t num_qubits = len_reg_memory + len_reg_auxiliary;
+
+    std::vector<std::size_t> reg_memory(len_reg_memory);
+    for(std::size_t i = 0; i < len_reg_memory; i++){
+        reg_memory[i] = i;
+    }
+    std::vector<std::size_t> reg_auxiliary(len_reg_auxiliary);
+    for(std::size_t i = 0; i < len_reg_auxiliary; i++){
+        reg_auxiliary[i] = i + len_reg_memory;
+    }
+    const std::size_t target = reg_auxiliary[len_reg_auxiliary-2];
+
+    // Patterns mostly dissimilar to the test pattern give a small target probability
+    std::vector<std::size_t> patterns {0b0110, 0b0111, 0b1110, 0b0100, 0b0010, 0b1001};
+    const std::size_t test_pattern = 0b1001;
+
+    IntelSimulator sim_ref(num_qubits), sim_amp(num_qubits);
+    prepareSimilarityState(sim_ref, reg_memory, reg_auxiliary, patterns, test_pattern);
+    const double p_initial = sim_ref.getStateProbability(target);
+    const double theta = std::asin(std::sqrt(p_initial));
+    REQUIRE(p_initial < 0.5);
+    REQUIRE(AmplitudeAmplification<IntelSimulator>::similarityProbability(patterns, test_pattern, len_reg_memory) == Approx(p_initial).margin(1e-12));
+
+    SECTION("Explicit iteration count"){
+        for(std::size_t k = 1; k <= 3; k++){
+            prepareSimilarityState(sim_amp, reg_memory, reg_auxiliary, patterns, test_pattern);
+            REQUIRE(sim_amp.amplifySimilarity(reg_memory, reg_auxiliary, patterns, test_pattern, k) == k);
+
+            CAPTURE(k, p_initial);
+            REQUIRE(sim_amp.getStateProbability(target) == Approx(std::pow(std::sin((2*k+1)*theta), 2)).margin(1e-12));
+        }
+    }
+
+    SECTION("Optimal iteration count"){
+        prepareSimilarityState(sim_amp, reg_memory, reg_auxiliary, patterns, test_pattern);
+        const std::size_t k = sim_amp.amplifySimilarity(reg_memory, reg_auxiliary, patterns, test_pattern);
+
+        CAPTURE(k, p_initial);
+        REQUIRE(k > 0);
+        REQUIRE(sim_amp.getStateProbability(target) > p_initial);
+        REQUIRE(sim_amp.getStateProbability(target) > 0.9);
+
+        // Amplification scales the good states uniformly: post-selected states agree up to the global phase (-1)^k
+        sim_ref.collapseToBasisZ(target, 1);
+        sim_amp.collapseToBasisZ(target, 1);
+
+        const double sign = (k % 2) ? -1. : 1.;
+        auto& r_ref = sim_ref.getQubitRegister();
+        auto& r_amp = sim_amp.getQubitRegister();
+        for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+            CAPTURE(i);
+            REQUIRE(r_amp[i].real() == Approx(sign*r_ref[i].real()).margin(1e-12));
+            REQUIRE(r_amp[i].imag() == Approx(sign*r_ref[i].imag()).margin(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Test maximum likelihood amplitude estimation of the post-selection and per-pattern similarity probabilities against the exact values
+ * 
+ */
+TEST_CASE("Amplitude estimation of similarity-encoded state","[amplification]"){
+    const std::size_t len_reg_memory = 4;
+    const std::size_t len_reg_auxiliary = len_reg_memory + 2;
+    const std::size_t num_qubits = len_reg_memory + len_reg_auxiliary;
+
+    std::vector<std::size_t> reg_memory(len_reg_memory);
+    for(std::size_t i = 0; i < len_reg_memory; i++){
+        reg_memory[i] = i;
+    }
+    std::vector<std::size_t> reg_auxiliary(len_reg_auxiliary);
+    for(std::size_t i = 0; i < len_reg_auxiliary; i++){
+        reg_auxiliary[i] = i + len_reg_memory;
+    }
+    const std::size_t target = reg_auxiliary[len_reg_auxiliary-2];
+
+    std::vector<std::size_t> patterns {0b0110, 0b0111, 0b1110, 0b0100, 0b0010, 0b1001};
+    const std::size_t test_pattern = 0b1001;
+
+    IntelSimulator sim(num_qubits), sim_ref(num_qubits);
+    prepareSimilarityState(sim, reg_memory, reg_auxiliary, patterns, test_pattern);
+    prepareSimilarityState(sim_ref, reg_memory, reg_auxiliary, patterns, test_pattern);
+    auto& r = sim.getQubitRegister();
+    auto& r_ref = sim_ref.getQubitRegister();
+
+    SECTION("Pattern probability"){
+        std::vector<std::size_t> marker_qubits(reg_memory);
+        marker_qubits.push_back(target);
+
+        for(auto p : patterns){
+            const std::size_t marked = p | (0b1UL << len_reg_memory);
+            double expected = 0.;
+            for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+                if( (i & 0b1111) == p && IS_SET(i, target) ){
+                    expected += std::norm(r[i]);
+                }
+            }
+            CAPTURE(p);
+            REQUIRE(sim.getPatternProbability(marker_qubits, {marked}) == Approx(expected).margin(1e-12));
+        }
+        REQUIRE(sim.getPatternProbability({target}, {1}) == Approx(sim.getStateProbability(target)).margin(1e-12));
+    }
+
+    SECTION("Post-selection probability"){
+        AmplitudeEstimation<IntelSimulator> estimator(6, 100);
+        const double p_exact = sim.getStateProbability(target);
+        auto result = estimator.estimatePostSelection(sim, reg_auxiliary);
+
+        CAPTURE(p_exact, result.probability, result.std_error);
+        REQUIRE(result.ci_lower <= p_exact);
+        REQUIRE(result.ci_upper >= p_exact);
+        REQUIRE(result.num_shots == 600);
+        REQUIRE(result.num_oracle_queries == 100*(1 + 2 + 4 + 8 + 16));
+        REQUIRE(result.num_state_preparations == 100*(1 + 3 + 5 + 9 + 17 + 33));
+        REQUIRE(result.max_grover_power == 16);
+
+        // Quadratically smaller error than sampling the prepared state for the same number of state preparations
+        REQUIRE(result.std_error < std::sqrt(p_exact*(1. - p_exact) / result.num_state_preparations));
+
+        // Prepared state is restored
+        for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+            CAPTURE(i);
+            REQUIRE(r[i].real() == Approx(r_ref[i].real()).margin(1e-12));
+            REQUIRE(r[i].imag() == Approx(r_ref[i].imag()).margin(1e-12));
+        }
+    }
+
+    SECTION("Simulator interface"){
+        AmplitudeEstimation<IntelSimulator> estimator(5, 50, 1.96, 1234);
+        auto expected = estimator.estimatePostSelection(sim_ref, reg_auxiliary);
+        auto result = sim.estimatePostSelection(reg_auxiliary, 5, 50, 1.96, 1234);
+
+        // Shots are drawn from the seeded stream, so equal seeds give equal estimates
+        REQUIRE(result.probability == expected.probability);
+        REQUIRE(result.num_shots == 250);
+        REQUIRE(sim.estimatePostSelection(reg_auxiliary, 5, 50, 1.96, 1234).probability == result.probability);
+
+        auto results = sim.estimateSimilarity(reg_memory, reg_auxiliary, {patterns[0], patterns[5]}, 5, 50, 1.96, 1234);
+        REQUIRE(results.size() == 2);
+    }
+
+    SECTION("Per-pattern similarity"){
+        AmplitudeEstimation<IntelSimulator> estimator(6, 100);
+        auto results = estimator.estimateSimilarity(sim, reg_memory, reg_auxiliary, patterns);
+        REQUIRE(results.size() == patterns.size());
+
+        std::vector<std::size_t> marker_qubits(reg_memory);
+        marker_qubits.push_back(target);
+        for(std::size_t i = 0; i < patterns.size(); i++){
+            const double p_exact = sim.getPatternProbability(marker_qubits, {patterns[i] | (0b1UL << len_reg_memory)});
+            CAPTURE(patterns[i], p_exact, results[i].probability, results[i].std_error);
+            REQUIRE(results[i].probability == Approx(p_exact).margin(5.*results[i].std_error + 1e-6));
+        }
+    }
+}
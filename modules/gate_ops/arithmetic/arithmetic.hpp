@@ -12,6 +12,12 @@
 #ifndef QNLP_ARITHMETIC
 #define QNLP_ARITHMETIC
 
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "qft.hpp"
+#include "OpBuffer.hpp"
+
 namespace QNLP{
     /**
      * @brief Class definition for bit-wise summation and subtraction of qubits.
@@ -30,26 +36,52 @@ namespace QNLP{
          * @param r1_max The highest bounded r1 index to perform Fourier transform on.
          * @param r2_min The lowest bounded r2 index to perform Fourier transform on.
          * @param r2_max The highest bounded r2 index to perform Fourier transform on.
+         * @param k_max Approximate QFT cutoff; controlled rotations by 2pi/2^k with k > k_max are omitted from the QFT, IQFT and phase addition. 0 applies the exact operations.
          */
-        static void sum_reg(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, CST r2_max){
+        static void sum_reg(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, CST r2_max, std::size_t k_max = 0){
             std::size_t num_qubits_r1 = r1_max - r1_min;
             std::size_t num_qubits_r2 = r2_max - r2_min;
 
             assert( num_qubits_r1 == num_qubits_r2 );
 
-            qSim.applyQFT(r2_min, r2_max);
+            qSim.applyQFT(r2_min, r2_max, k_max);
             double theta = 0.0;
 
             //Targets
             for(int i = r2_max; i >= (int) r2_min; i--){
                 //Controls
                 for(int j = r1_max - (r2_max - i); j >= (int) r1_min; j--){
+                    if(QFT<SimulatorType>::isOmitted(1 + (i-j), k_max)){
+                        continue;
+                    }
                     theta = 2.0*M_PI / (std::size_t) (1<<(1 + (i-j)));
                     qSim.applyGateCPhaseShift(theta, j, i);
                 }
             }
 
-            qSim.applyIQFT(r2_min, r2_max);
+            qSim.applyIQFT(r2_min, r2_max, k_max);
+        }
+
+        /**
+         * @brief Operator norm bound on the error of sum_reg (and sub_reg) with the given approximate QFT cutoff, summing the bounds of the omitted rotations in the QFT, phase addition and IQFT. The fidelity bound follows from QFT<SimulatorType>::fidelityBound.
+         * 
+         * @param r1_min The lowest bounded r1 index
+         * @param r1_max The highest bounded r1 index
+         * @param r2_min The lowest bounded r2 index
+         * @param r2_max The highest bounded r2 index
+         * @param k_max Approximate QFT cutoff; 0 omits no rotations
+         * @return double Error bound epsilon
+         */
+        static double approximationError(CST r1_min, CST r1_max, CST r2_min, CST r2_max, std::size_t k_max){
+            double epsilon = 2.0 * QFT<SimulatorType>::approximationError(r2_max - r2_min + 1, k_max);
+            for(int i = r2_max; i >= (int) r2_min; i--){
+                for(int j = r1_max - (r2_max - i); j >= (int) r1_min; j--){
+                    if(QFT<SimulatorType>::isOmitted(1 + (i-j), k_max)){
+                        epsilon += 2.0 * std::sin(M_PI / std::pow(2.0, 1 + (i-j)));
+                    }
+                }
+            }
+            return epsilon;
         }
         
         /**
@@ -60,8 +92,9 @@ namespace QNLP{
          * @param r1_max The highest bounded r1 index to perform Fourier transform on.
          * @param r2_min The lowest bounded r2 index to perform Fourier transform on.
          * @param r2_max The highest bounded r2 index to perform Fourier transform on.
+         * @param k_max Approximate QFT cutoff, as for sum_reg. 0 applies the exact operations.
          */
-        static void sub_reg(SimulatorType& qReg, const unsigned int r1_min, const unsigned int r1_max, const unsigned int r2_min, const unsigned int r2_max){
+        static void sub_reg(SimulatorType& qReg, const unsigned int r1_min, const unsigned int r1_max, const unsigned int r2_min, const unsigned int r2_max, std::size_t k_max = 0){
             std::size_t num_qubits_r1 = r1_max - r1_min;
             std::size_t num_qubits_r2 = r2_max - r2_min;
 
@@ -71,7 +104,7 @@ namespace QNLP{
             for(int i = r1_min; i < r1_max; i++){
                 qReg.applyGateX(i);
             }
-            sum_reg(qReg, r1_min, r1_max, r2_min, r2_max);
+            sum_reg(qReg, r1_min, r1_max, r2_min, r2_max, k_max);
             //Flip states to return the sum
             for(int i = r2_min; i < r2_max; i++){
                 qReg.applyGateX(i);
@@ -81,6 +114,152 @@ namespace QNLP{
                 qReg.applyGateX(i);
             }
         }
+
+        /**
+         * @brief Implements |r1>|r2>|c> -> |r1>|r1+r2+c>|c> (modulo 2^n) using the ripple-carry adder of Cuccaro et al. (arXiv:quant-ph/0410184), built from CX and CCX gates with a single ancilla qubit as carry-in. With the ancilla in |0>, this computes the same sum as sum_reg with no controlled phase gates.
+         * 
+         * @param qSim The quantum register holding the bitstrings r1,r2
+         * @param r1_min The lowest bounded r1 index.
+         * @param r1_max The highest bounded r1 index.
+         * @param r2_min The lowest bounded r2 index.
+         * @param r2_max The highest bounded r2 index.
+         * @param ancilla Ancilla qubit index (carry-in), returned to its initial state.
+         */
+        static void sum_reg_ripple(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, [[maybe_unused]] CST r2_max, CST ancilla){
+            assert( r1_max - r1_min == r2_max - r2_min );
+            qSim.applyOps(rippleAdderOps(r1_min, r2_min, r1_max - r1_min + 1, ancilla, false));
+        }
+
+        /**
+         * @brief Implements |r1>|r2>|c> -> |r1>|r1-r2-c>|c> (modulo 2^n) using the ripple-carry adder. With the ancilla in |0>, this computes the same difference as sub_reg.
+         * 
+         * @param qSim The quantum register holding the bitstrings r1,r2
+         * @param r1_min The lowest bounded r1 index.
+         * @param r1_max The highest bounded r1 index.
+         * @param r2_min The lowest bounded r2 index.
+         * @param r2_max The highest bounded r2 index.
+         * @param ancilla Ancilla qubit index (carry-in), returned to its initial state.
+         */
+        static void sub_reg_ripple(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, [[maybe_unused]] CST r2_max, CST ancilla){
+            assert( r1_max - r1_min == r2_max - r2_min );
+            qSim.applyOps(rippleAdderOps(r1_min, r2_min, r1_max - r1_min + 1, ancilla, true));
+        }
+
+        /**
+         * @brief Implements |r1>|r2>|c> -> |r1>|r1+r2+c>|c> (modulo 2^n) as a single permutation of the basis states. Equivalent to sum_reg_ripple, whose gates are still counted.
+         * 
+         * @param qSim The quantum register holding the bitstrings r1,r2
+         * @param r1_min The lowest bounded r1 index.
+         * @param r1_max The highest bounded r1 index.
+         * @param r2_min The lowest bounded r2 index.
+         * @param r2_max The highest bounded r2 index.
+         * @param ancilla Ancilla qubit index (carry-in).
+         */
+        static void sum_reg_native(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, [[maybe_unused]] CST r2_max, CST ancilla){
+            assert( r1_max - r1_min == r2_max - r2_min );
+            const std::size_t n = r1_max - r1_min + 1;
+            const std::size_t mask = (0b1UL << n) - 1;
+
+            qSim.applyRegisterPermutation(adderQubits(r1_min, r2_min, n, ancilla), [n, mask](std::size_t val){
+                const std::size_t a = val & mask, b = (val >> n) & mask, c = val >> (2*n);
+                return a | (((a + b + c) & mask) << n) | (c << (2*n));
+            }, rippleAdderOps(r1_min, r2_min, n, ancilla, false));
+        }
+
+        /**
+         * @brief Implements |r1>|r2>|c> -> |r1>|r1-r2-c>|c> (modulo 2^n) as a single permutation of the basis states. Equivalent to sub_reg_ripple, whose gates are still counted.
+         * 
+         * @param qSim The quantum register holding the bitstrings r1,r2
+         * @param r1_min The lowest bounded r1 index.
+         * @param r1_max The highest bounded r1 index.
+         * @param r2_min The lowest bounded r2 index.
+         * @param r2_max The highest bounded r2 index.
+         * @param ancilla Ancilla qubit index (carry-in).
+         */
+        static void sub_reg_native(SimulatorType& qSim, CST r1_min, CST r1_max, CST r2_min, [[maybe_unused]] CST r2_max, CST ancilla){
+            assert( r1_max - r1_min == r2_max - r2_min );
+            const std::size_t n = r1_max - r1_min + 1;
+            const std::size_t mask = (0b1UL << n) - 1;
+
+            qSim.applyRegisterPermutation(adderQubits(r1_min, r2_min, n, ancilla), [n, mask](std::size_t val){
+                const std::size_t a = val & mask, b = (val >> n) & mask, c = val >> (2*n);
+                return a | (((a - b - c) & mask) << n) | (c << (2*n));
+            }, rippleAdderOps(r1_min, r2_min, n, ancilla, true));
+        }
+
+        private:
+        /**
+         * @brief Gate sequence of the ripple-carry adder (sum_reg_ripple), or of the subtractor (sub_reg_ripple)
+         *
+         * @param r1_min The lowest bounded r1 index.
+         * @param r2_min The lowest bounded r2 index.
+         * @param n Number of qubits of each register.
+         * @param ancilla Ancilla qubit index (carry-in).
+         * @param subtract Sequence of the subtractor if true
+         */
+        static OpBuffer rippleAdderOps(CST r1_min, CST r2_min, CST n, CST ancilla, bool subtract){
+            OpBuffer ops;
+            // r1 - r2 - c = ~(~r1 + r2 + c)
+            if(subtract){
+                for(std::size_t i = 0; i < n; i++){
+                    ops.add(OpCode::X, {r1_min + i});
+                }
+            }
+
+            // MAJ ladder: the carry into bit i is left on r1[i-1]
+            addMAJ(ops, ancilla, r2_min, r1_min);
+            for(std::size_t i = 1; i < n; i++){
+                addMAJ(ops, r1_min + i - 1, r2_min + i, r1_min + i);
+            }
+            // UMA ladder: undo the carries and write the sum bits to r2
+            for(std::size_t i = n - 1; i > 0; i--){
+                addUMA(ops, r1_min + i - 1, r2_min + i, r1_min + i);
+            }
+            addUMA(ops, ancilla, r2_min, r1_min);
+
+            if(subtract){
+                for(std::size_t i = 0; i < n; i++){
+                    ops.add(OpCode::X, {r2_min + i});
+                }
+                for(std::size_t i = 0; i < n; i++){
+                    ops.add(OpCode::X, {r1_min + i});
+                }
+            }
+            return ops;
+        }
+
+        /**
+         * @brief Majority gate of the ripple-carry adder; leaves the carry out of (c, b, a) on a, and b^a, c^a on b, c
+         */
+        static void addMAJ(OpBuffer& ops, CST c, CST b, CST a){
+            ops.add(OpCode::CX, {a, b})
+               .add(OpCode::CX, {a, c})
+               .add(OpCode::CCX, {c, b, a});
+        }
+
+        /**
+         * @brief UnMajority and Add gate of the ripple-carry adder; inverts addMAJ, leaving the sum bit on b
+         */
+        static void addUMA(OpBuffer& ops, CST c, CST b, CST a){
+            ops.add(OpCode::CCX, {c, b, a})
+               .add(OpCode::CX, {a, c})
+               .add(OpCode::CX, {c, b});
+        }
+
+        /**
+         * @brief Sub-register of the native adder kernels: bits [0,n) r1, [n,2n) r2, 2n ancilla
+         */
+        static std::vector<std::size_t> adderQubits(CST r1_min, CST r2_min, CST n, CST ancilla){
+            std::vector<std::size_t> qubits;
+            for(std::size_t i = 0; i < n; i++){
+                qubits.push_back(r1_min + i);
+            }
+            for(std::size_t i = 0; i < n; i++){
+                qubits.push_back(r2_min + i);
+            }
+            qubits.push_back(ancilla);
+            return qubits;
+        }
     };
 }
 
@@ -12,6 +12,7 @@
 //#define CATCH_CONFIG_MAIN
 
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
 #include <memory>
@@ -28,7 +29,6 @@ TEST_CASE("Arithmetic subtraction","[arithmetic]"){
     std::size_t num_qubits = 6;
     IntelSimulator sim(num_qubits);
     Arithmetic<decltype(sim)> arr;
-    auto& r = sim.getQubitRegister();
     
     SECTION("OLD_TEST"){
         unsigned int r1_min = 0, r1_max=(num_qubits/2)-1, r2_min = r1_max+1, r2_max = num_qubits-1;
@@ -38,6 +38,7 @@ TEST_CASE("Arithmetic subtraction","[arithmetic]"){
             unsigned int bitmask = 0x1;
             unsigned int a = 0;
             sim.initRegister();
+            auto& r = sim.getQubitRegister();
             for (unsigned int i=0; i <= r1_max -1; i++){
                 sim.applyGateX(i);
                 a += (unsigned int) pow(2,i);
@@ -74,7 +75,6 @@ TEST_CASE("Arithmetic summation","[arithmetic]"){
     std::size_t num_qubits = max_idx - min_idx +1;
     IntelSimulator sim(num_qubits);
     Arithmetic<decltype(sim)> arr;
-    auto& r = sim.getQubitRegister();
     
     SECTION("OLD_TEST","[arithmetic]"){
         unsigned int r1_min = 0, r1_max=(num_qubits/2)-1, r2_min = r1_max+1, r2_max = num_qubits-1;
@@ -82,6 +82,7 @@ TEST_CASE("Arithmetic summation","[arithmetic]"){
             unsigned int bitmask = 0x1;
             unsigned int a = 0;
             sim.initRegister();
+            auto& r = sim.getQubitRegister();
             for (unsigned int i=0; i <= r1_max -1; i++){
                 sim.applyGateX(i);
                 a += (unsigned int) pow(2,i);
@@ -104,3 +105,64 @@ TEST_CASE("Arithmetic summation","[arithmetic]"){
         }
     }
 }
+
+/**
+ * @brief Test Arithmetic: ripple-carry and native adders over all basis states
+ * 
+ */
+TEST_CASE("Ripple-carry summation and subtraction","[arithmetic]"){
+    std::size_t n = 3;
+    std::size_t num_qubits = 2*n + 1;
+    std::size_t r1_min = 0, r1_max = n-1, r2_min = n, r2_max = 2*n-1, ancilla = 2*n;
+    std::size_t mask = (0b1UL << n) - 1;
+    IntelSimulator sim(num_qubits);
+
+    for(bool subtract : {false, true}){
+        for(bool native : {false, true}){
+            DYNAMIC_SECTION( (subtract ? "Subtraction" : "Summation") << (native ? " (native)" : " (ripple)") ){
+                for(std::size_t c = 0; c < 2; c++){
+                    for(std::size_t a = 0; a <= mask; a++){
+                        for(std::size_t b = 0; b <= mask; b++){
+                            sim.initRegister();
+                            std::size_t in = a | (b << n) | (c << 2*n);
+                            for(std::size_t q = 0; q < num_qubits; q++){
+                                if( (in >> q) & 0b1 ){
+                                    sim.applyGateX(q);
+                                }
+                            }
+                            if(subtract){
+                                native ? Arithmetic<decltype(sim)>::sub_reg_native(sim, r1_min, r1_max, r2_min, r2_max, ancilla)
+                                       : Arithmetic<decltype(sim)>::sub_reg_ripple(sim, r1_min, r1_max, r2_min, r2_max, ancilla);
+                            }
+                            else{
+                                native ? Arithmetic<decltype(sim)>::sum_reg_native(sim, r1_min, r1_max, r2_min, r2_max, ancilla)
+                                       : Arithmetic<decltype(sim)>::sum_reg_ripple(sim, r1_min, r1_max, r2_min, r2_max, ancilla);
+                            }
+                            std::size_t res = (subtract ? (a - b - c) : (a + b + c)) & mask;
+                            std::size_t out = a | (res << n) | (c << 2*n);
+                            CAPTURE(a, b, c, out);
+                            // Basis states may be tracked classically, so the register is fetched after the gates are applied
+                            auto& r = sim.getQubitRegister();
+                            REQUIRE(std::norm(r[out]) == Approx(1.0).margin(1e-12));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Native kernel matches ripple-carry gates on superposition"){
+        IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+        // The ancilla is left in |0>
+        test::prepareDistinctState(sim_gates, 2*n);
+        test::prepareDistinctState(sim_native, 2*n);
+        Arithmetic<IntelSimulator>::sum_reg_ripple(sim_gates, r1_min, r1_max, r2_min, r2_max, ancilla);
+        Arithmetic<IntelSimulator>::sum_reg_native(sim_native, r1_min, r1_max, r2_min, r2_max, ancilla);
+        Arithmetic<IntelSimulator>::sub_reg_ripple(sim_gates, r1_min, r1_max, r2_min, r2_max, ancilla);
+        Arithmetic<IntelSimulator>::sub_reg_native(sim_native, r1_min, r1_max, r2_min, r2_max, ancilla);
+
+        test::requireEqualStates(sim_native, sim_gates);
+        REQUIRE(sim_native.getGateCounts() == sim_gates.getGateCounts());
+        REQUIRE(sim_native.getQubitUsage() == sim_gates.getQubitUsage());
+    }
+}
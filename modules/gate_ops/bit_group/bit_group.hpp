@@ -41,8 +41,7 @@ namespace QNLP{
             qSim.applyGateCSwap(qaux_idx[1], qreg_idx0, qreg_idx1);
 
             //Reset Aux gate to |0>
-            qSim.applyGateH(qaux_idx[1]);
-            qSim.collapseToBasisZ(qaux_idx[1], 0);
+            qSim.resetQubit(qaux_idx[1]);
         }
 
 
@@ -34,10 +34,10 @@ TEST_CASE("Test bit grouping","[bitgroup]"){
     std::cout << reg.size() << "    | "<< aux.size() << std::endl;
     IntelSimulator sim(num_qubits);
     BitGroup<decltype(sim)> bg;
-    auto& r = sim.getQubitRegister();
     /*
     SECTION("Group to right |010100>|10> -> |000011>|10>"){
         sim.initRegister();
+        auto& r = sim.getQubitRegister();
         sim.applyGateX(reg[1]);
         sim.applyGateX(reg[3]);
 
@@ -48,6 +48,7 @@ TEST_CASE("Test bit grouping","[bitgroup]"){
     }*/
     SECTION("Group to right |010000>|10> + |011000>|10> -> |000001>|10> + |000011>|10>"){
         sim.initRegister();
+        auto& r = sim.getQubitRegister();
         sim.applyGateX(reg[1]);
         sim.applyGateH(reg[2]);
 
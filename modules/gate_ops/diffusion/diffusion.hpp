@@ -65,6 +65,19 @@ namespace QNLP{
                 sim.applyGateH(ctrl);
             }
         }
+
+        /**
+         * @brief Application of the Grover diffusion operator to already marked register, as a native reflection about the uniform superposition of the control and target qubits. Equivalent to applyOpDiffusion, but avoids the nCZ decomposition.
+         * 
+         * @param sim The quantum simulator object to apply the operator.
+         * @param ctrlIndices Vector of qubit indices on ctrl lines (non NCU target)
+         * @param target Target for application of the nCZ op
+         */
+        void applyOpDiffusionNative( SimulatorType& sim, const std::vector<std::size_t>& ctrlIndices, const std::size_t target){
+            std::vector<std::size_t> reg_qubits(ctrlIndices);
+            reg_qubits.push_back(target);
+            sim.applyUniformReflection(reg_qubits);
+        }
     };
 }
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 
 #include <bitset>
 
@@ -17,7 +18,6 @@ typedef ComplexDP Type;
 TEST_CASE("4 qubit diffusion using module","[diffusion]"){
     std::size_t num_qubits = 4;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     double previous_prob = 0.;
 
     SECTION("2^4 bit patterns (16)"){
@@ -42,6 +42,7 @@ TEST_CASE("4 qubit diffusion using module","[diffusion]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -80,7 +81,6 @@ TEST_CASE("4 qubit diffusion using module","[diffusion]"){
 TEST_CASE("8 qubit diffusion using module","[diffusion]"){
     std::size_t num_qubits = 8;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     double previous_prob = 0.;
 
     SECTION("2^8 bit patterns (256)"){
@@ -105,6 +105,7 @@ TEST_CASE("8 qubit diffusion using module","[diffusion]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -144,7 +145,6 @@ TEST_CASE("8 qubit diffusion using module","[diffusion]"){
 TEST_CASE("4 qubit diffusion using Simulator method","[diffusion]"){
     std::size_t num_qubits = 4;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     double previous_prob = 0.;
 
     SECTION("2^4 bit patterns (16)"){
@@ -164,6 +164,7 @@ TEST_CASE("4 qubit diffusion using Simulator method","[diffusion]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -200,7 +201,6 @@ TEST_CASE("4 qubit diffusion using Simulator method","[diffusion]"){
 TEST_CASE("8 qubit diffusion using Simulator method","[diffusion]"){
     std::size_t num_qubits = 8;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     double previous_prob = 0.;
 
     SECTION("2^8 bit patterns (256)"){
@@ -220,6 +220,7 @@ TEST_CASE("8 qubit diffusion using Simulator method","[diffusion]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -249,4 +250,35 @@ TEST_CASE("8 qubit diffusion using Simulator method","[diffusion]"){
             }
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Test the native diffusion reflection against the gate decomposition, for the full register and for sub-registers, acting on an arbitrary (non-uniform) superposition.
+ * 
+ */
+TEST_CASE("Native diffusion reflection","[diffusion]"){
+    std::size_t num_qubits = 7;
+
+    std::vector<std::pair<std::vector<std::size_t>, std::size_t>> reg_targets {
+        { {0, 1, 2, 3, 4, 5}, 6 },  // Full register
+        { {0, 1, 2}, 3 },           // Low qubits
+        { {1, 4, 6}, 5 },           // Non-adjacent qubits
+        { {2}, 0 }                  // Two qubits
+    };
+
+    for(auto& [ctrl_indices, target] : reg_targets){
+        DYNAMIC_SECTION("Diffusion on " << ctrl_indices.size() + 1 << " qubits with target " << target){
+            IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+            Diffusion<IntelSimulator> diffusion;
+
+            test::prepareDistinctState(sim_gates);
+            test::prepareDistinctState(sim_native);
+
+            diffusion.applyOpDiffusion(sim_gates, ctrl_indices, target);
+            diffusion.applyOpDiffusionNative(sim_native, ctrl_indices, target);
+
+            test::requireEqualStates(sim_native, sim_gates);
+            REQUIRE(sim_native.getGateCounts() == sim_gates.getGateCounts());
+            REQUIRE(sim_native.getQubitUsage() == sim_gates.getQubitUsage());
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file layout.hpp
+ * @brief Functions for choosing the qubit layout of a circuit from the gate usage of each qubit
+ * @version 0.1
+ */
+
+#ifndef QNLP_LAYOUT
+#define QNLP_LAYOUT
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace QNLP{
+    /**
+     * @brief Class definition for assigning qubit indices from the number of gates targeting each qubit. Gates targeting low qubit indices act on amplitudes close in memory, and with a distributed state-vector the highest log2(#ranks) qubit indices are held across ranks, so gates targeting them require an inter-rank exchange (gates controlled on them do not). Assigning the most used qubits to the lowest indices therefore both improves locality and minimises the gates on distributed qubits, for any number of ranks.
+     * 
+     * @tparam SimulatorType Class Simulator type
+     */
+    template <class SimulatorType>
+    class QubitLayout{
+        public:
+        /**
+         * @brief Construct a new Qubit Layout object
+         * 
+         */
+        QubitLayout(){};
+
+        /**
+         * @brief Destroy the Qubit Layout object
+         * 
+         */
+        ~QubitLayout(){};
+
+        /**
+         * @brief Assign qubit indices in decreasing order of usage; qubits with equal usage keep their relative order
+         * 
+         * @param usage Number of gates targeting each qubit index; missing entries count as 0
+         * @param num_qubits Number of qubits to lay out
+         * @return std::vector<std::size_t> layout, where layout[q] is the new index of qubit q
+         */
+        static std::vector<std::size_t> fromUsage(const std::vector<std::size_t>& usage, std::size_t num_qubits){
+            auto count = [&usage](std::size_t q){ return (q < usage.size()) ? usage[q] : 0; };
+
+            std::vector<std::size_t> order(num_qubits);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&count](std::size_t q0, std::size_t q1){ return count(q0) > count(q1); });
+
+            std::vector<std::size_t> layout(num_qubits);
+            for(std::size_t i = 0; i < num_qubits; i++){
+                layout[order[i]] = i;
+            }
+            return layout;
+        }
+
+        /**
+         * @brief Apply the layout to the qubit indices of a register
+         * 
+         * @param reg Qubit indices of the register
+         * @param layout New index of each qubit, as returned by fromUsage
+         * @return std::vector<std::size_t> Remapped qubit indices of the register
+         */
+        static std::vector<std::size_t> remapRegister(const std::vector<std::size_t>& reg, const std::vector<std::size_t>& layout){
+            std::vector<std::size_t> remapped(reg.size());
+            for(std::size_t i = 0; i < reg.size(); i++){
+                remapped[i] = layout[reg[i]];
+            }
+            return remapped;
+        }
+
+        /**
+         * @brief Number of gates targeting the highest num_distributed qubit indices under the given layout, which require an inter-rank exchange when the state-vector is distributed over 2^num_distributed ranks
+         * 
+         * @param usage Number of gates targeting each qubit index
+         * @param layout New index of each qubit
+         * @param num_distributed Number of distributed qubits
+         * @return std::size_t Number of gates targeting distributed qubits
+         */
+        static std::size_t countDistributedTargets(const std::vector<std::size_t>& usage, const std::vector<std::size_t>& layout, std::size_t num_distributed){
+            std::size_t count = 0;
+            for(std::size_t q = 0; q < layout.size() && q < usage.size(); q++){
+                if(layout[q] + num_distributed >= layout.size()){
+                    count += usage[q];
+                }
+            }
+            return count;
+        }
+
+        /**
+         * @brief Remap the memory and auxiliary registers from the gate usage recorded by the simulator over a run of the circuit (or a resource estimation run, which records usage without simulating the state). The circuit must then be run on the returned registers.
+         * 
+         * @param qSim Simulator having run the circuit on reg_memory and reg_auxiliary
+         * @param reg_memory Qubit indices of the memory register
+         * @param reg_auxiliary Qubit indices of the auxiliary register
+         * @return std::pair<std::vector<std::size_t>, std::vector<std::size_t>> Remapped memory and auxiliary registers
+         */
+        static std::pair<std::vector<std::size_t>, std::vector<std::size_t>> optimiseRegisters(SimulatorType& qSim, const std::vector<std::size_t>& reg_memory, const std::vector<std::size_t>& reg_auxiliary){
+            std::size_t num_qubits = 0;
+            for(auto q : reg_memory){
+                num_qubits = std::max(num_qubits, q + 1);
+            }
+            for(auto q : reg_auxiliary){
+                num_qubits = std::max(num_qubits, q + 1);
+            }
+
+            const auto layout = fromUsage(qSim.getQubitUsage(), num_qubits);
+            return std::make_pair(remapRegister(reg_memory, layout), remapRegister(reg_auxiliary, layout));
+        }
+    };
+}
+
+#endif
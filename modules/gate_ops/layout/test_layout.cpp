@@ -0,0 +1,130 @@
+#include "layout.hpp"
+
+#include "Simulator.hpp"
+#include "IntelSimulator.cpp"
+#include "catch2/catch.hpp"
+
+#include <numeric>
+
+using namespace QNLP;
+
+template class QNLP::QubitLayout<IntelSimulator>;
+
+/**
+ * @brief Test the layout assigns the lowest indices to the most used qubits
+ * 
+ */
+TEST_CASE("Qubit layout from usage","[layout]"){
+    std::vector<std::size_t> usage {3, 10, 0, 7};
+    auto layout = QubitLayout<IntelSimulator>::fromUsage(usage, 5);
+
+    REQUIRE(layout == std::vector<std::size_t>{2, 0, 3, 1, 4});
+    REQUIRE(QubitLayout<IntelSimulator>::remapRegister({3, 1}, layout) == std::vector<std::size_t>{1, 0});
+
+    std::vector<std::size_t> identity(5);
+    std::iota(identity.begin(), identity.end(), 0);
+    REQUIRE(QubitLayout<IntelSimulator>::countDistributedTargets(usage, identity, 2) == 7);
+    REQUIRE(QubitLayout<IntelSimulator>::countDistributedTargets(usage, layout, 2) == 0);
+    REQUIRE(QubitLayout<IntelSimulator>::countDistributedTargets(usage, layout, 3) == 3);
+}
+
+/**
+ * @brief Test the layout of the encoding and Hamming distance circuit; the remapped circuit must prepare the same state, with usage non-increasing in the qubit index.
+ * 
+ */
+TEST_CASE("Qubit layout of similarity-encoded state","[layout]"){
+    const std::size_t len_reg_memory = 4;
+    const std::size_t len_reg_auxiliary = len_reg_memory + 2;
+    const std::size_t num_qubits = len_reg_memory + len_reg_auxiliary;
+
+    // Data-aux-control layout
+    std::vector<std::size_t> reg_memory(len_reg_memory);
+    for(std::size_t i = 0; i < len_reg_memory; i++){
+        reg_memory[i] = i;
+    }
+    std::vector<std::size_t> reg_auxiliary(len_reg_auxiliary);
+    for(std::size_t i = 0; i < len_reg_auxiliary; i++){
+        reg_auxiliary[i] = i + len_reg_memory;
+    }
+
+    std::vector<std::size_t> patterns {0b0110, 0b0111, 0b1110, 0b0100, 0b0010, 0b1001};
+    const std::size_t test_pattern = 0b1001;
+
+    auto prepare = [&](IntelSimulator& sim, const std::vector<std::size_t>& reg_mem, const std::vector<std::size_t>& reg_aux){
+        sim.initRegister();
+        sim.encodeBinToSuperpos_unique(reg_mem, reg_aux, patterns, len_reg_memory);
+        sim.applyHammingDistanceRotY(test_pattern, reg_mem, reg_aux, len_reg_memory);
+    };
+
+    IntelSimulator sim_ref(num_qubits), sim_opt(num_qubits);
+    prepare(sim_ref, reg_memory, reg_auxiliary);
+    const auto usage_ref = sim_ref.getQubitUsage();
+
+    auto [reg_memory_opt, reg_auxiliary_opt] = sim_ref.optimiseQubitLayout(reg_memory, reg_auxiliary);
+
+    std::vector<std::size_t> all_qubits(reg_memory_opt);
+    all_qubits.insert(all_qubits.end(), reg_auxiliary_opt.begin(), reg_auxiliary_opt.end());
+    std::sort(all_qubits.begin(), all_qubits.end());
+    for(std::size_t i = 0; i < num_qubits; i++){
+        REQUIRE(all_qubits[i] == i);
+    }
+
+    prepare(sim_opt, reg_memory_opt, reg_auxiliary_opt);
+    const auto usage_opt = sim_opt.getQubitUsage();
+
+    SECTION("Usage ordered by qubit index"){
+        REQUIRE(std::accumulate(usage_opt.begin(), usage_opt.end(), 0UL) == std::accumulate(usage_ref.begin(), usage_ref.end(), 0UL));
+        for(std::size_t i = 1; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(usage_opt[i] <= usage_opt[i-1]);
+        }
+        std::vector<std::size_t> identity(num_qubits);
+        std::iota(identity.begin(), identity.end(), 0);
+        for(std::size_t num_distributed = 1; num_distributed <= 3; num_distributed++){
+            REQUIRE(QubitLayout<IntelSimulator>::countDistributedTargets(usage_opt, identity, num_distributed) <= QubitLayout<IntelSimulator>::countDistributedTargets(usage_ref, identity, num_distributed));
+        }
+    }
+    SECTION("Same state on remapped registers"){
+        REQUIRE(sim_opt.getStateProbability(reg_auxiliary_opt[len_reg_auxiliary-2]) == Approx(sim_ref.getStateProbability(reg_auxiliary[len_reg_auxiliary-2])).margin(1e-12));
+        for(auto p : patterns){
+            CAPTURE(p);
+            REQUIRE(sim_opt.getPatternProbability(reg_memory_opt, {p}) == Approx(sim_ref.getPatternProbability(reg_memory, {p})).margin(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Test the usage counted by the native kernels matches that of the gate sequences they replace, so that the layout does not depend on whether the native kernels are used.
+ * 
+ */
+TEST_CASE("Qubit usage of native operations","[layout]"){
+    const std::size_t num_qubits = 6;
+    const std::vector<std::size_t> ctrl_indices {0, 2, 3};
+    const std::size_t target = 5;
+
+    IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+
+    SECTION("QFT"){
+        QFT<IntelSimulator>::applyQFT(sim_gates, 1, 4);
+        QFT<IntelSimulator>::applyQFTNative(sim_native, 1, 4);
+    }
+    SECTION("Diffusion"){
+        Diffusion<IntelSimulator> diffusion;
+        diffusion.applyOpDiffusion(sim_gates, ctrl_indices, target);
+        diffusion.applyOpDiffusionNative(sim_native, ctrl_indices, target);
+    }
+    SECTION("Phase oracle"){
+        Oracle<IntelSimulator>::bitStringPhaseOracle(sim_gates, {3, 9, 14}, ctrl_indices, target);
+        Oracle<IntelSimulator>::bitStringPhaseOracleNative(sim_native, {3, 9, 14}, ctrl_indices, target);
+    }
+    SECTION("Ripple-carry adder"){
+        Arithmetic<IntelSimulator>::sum_reg_ripple(sim_gates, 0, 1, 2, 3, 4);
+        Arithmetic<IntelSimulator>::sum_reg_native(sim_native, 0, 1, 2, 3, 4);
+    }
+
+    const auto usage_gates = sim_gates.getQubitUsage();
+    const auto usage_native = sim_native.getQubitUsage();
+    REQUIRE(std::accumulate(usage_native.begin(), usage_native.end(), 0UL) > 0);
+    REQUIRE(usage_native == usage_gates);
+    REQUIRE(QubitLayout<IntelSimulator>::fromUsage(usage_native, num_qubits) == QubitLayout<IntelSimulator>::fromUsage(usage_gates, num_qubits));
+}
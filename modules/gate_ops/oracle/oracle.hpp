@@ -14,6 +14,7 @@
 #include <complex>
 #include <cassert>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 
 namespace QNLP{
@@ -128,6 +129,53 @@ namespace QNLP{
             assert ( (1<<num_qubits) < bitstring );
             bitStringNCU(s, bitstring, ctrlIndices, target, s.getGateZ(), "Z");
         }
+
+        /**
+         * @brief Marks each of the given bitstrings by applying a separate phase oracle per pattern. Patterns are treated as a set: bits beyond the control and target lines are ignored, and duplicate patterns are marked once.
+         * 
+         * @param s Simulator object
+         * @param bitstrings Binary patterns to mark, each represented by a std::size_t bitstring
+         * @param ctrlIndices Indices of the control qubits in the register
+         * @param target Qubit acting as target
+         */
+        static void bitStringPhaseOracle(SimulatorType& s, const std::vector<std::size_t>& bitstrings, const std::vector<std::size_t>& ctrlIndices, std::size_t target ){
+            for(auto& bitstring : uniquePatterns(bitstrings, ctrlIndices.size() + 1)){
+                bitStringNCU(s, bitstring, ctrlIndices, target, s.getGateZ(), "Z");
+            }
+        }
+
+        /**
+         * @brief Marks each of the given bitstrings by negating the matching amplitudes in a single pass over the state-vector, rather than applying an NCU(Z) per pattern. Equivalent to the decomposed multi-pattern oracle.
+         * 
+         * @param s Simulator object
+         * @param bitstrings Binary patterns to mark, each represented by a std::size_t bitstring
+         * @param ctrlIndices Indices of the control qubits in the register
+         * @param target Qubit acting as target
+         */
+        static void bitStringPhaseOracleNative(SimulatorType& s, const std::vector<std::size_t>& bitstrings, const std::vector<std::size_t>& ctrlIndices, std::size_t target ){
+            std::vector<std::size_t> qubits(ctrlIndices);
+            qubits.push_back(target);
+            s.applyPatternPhaseFlip(qubits, bitstrings);
+        }
+
+        private:
+        /**
+         * @brief Mask the given patterns to num_bits and remove duplicates
+         * 
+         * @param bitstrings Binary patterns
+         * @param num_bits Number of significant bits per pattern
+         * @return std::vector<std::size_t> Sorted unique patterns
+         */
+        static std::vector<std::size_t> uniquePatterns(const std::vector<std::size_t>& bitstrings, std::size_t num_bits){
+            const std::size_t mask = (num_bits < 64) ? (0b1UL << num_bits) - 1 : ~0UL;
+            std::vector<std::size_t> patterns;
+            for(auto& bitstring : bitstrings){
+                patterns.push_back(bitstring & mask);
+            }
+            std::sort(patterns.begin(), patterns.end());
+            patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+            return patterns;
+        }
     };
 };
 #endif
\ No newline at end of file
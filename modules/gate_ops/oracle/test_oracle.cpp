@@ -3,6 +3,7 @@
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 
 #include <bitset>
 
@@ -19,7 +20,6 @@ template class QNLP::Oracle<IntelSimulator>;
 TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
     std::size_t num_qubits = 3;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     Oracle<decltype(sim)> oracle;
 
     SECTION("2^3 bit patterns (8)"){
@@ -36,6 +36,7 @@ TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -51,6 +52,7 @@ TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
 
             DYNAMIC_SECTION("bitStringPhaseOracle with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -80,6 +82,7 @@ TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -95,6 +98,7 @@ TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
 
             DYNAMIC_SECTION("bitStringPhaseOracle with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -118,7 +122,6 @@ TEST_CASE("3 qubit Oracle standalone class","[oracle]"){
 TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
     std::size_t num_qubits = 8;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
     Oracle<decltype(sim)> oracle;
 
     SECTION("2^8 bit patterns (256)"){
@@ -138,6 +141,7 @@ TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -153,6 +157,7 @@ TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
 
             DYNAMIC_SECTION("bitStringPhaseOracle with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -182,6 +187,7 @@ TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("bitStringNCU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -197,6 +203,7 @@ TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
 
             DYNAMIC_SECTION("bitStringPhaseOracle with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -220,7 +227,6 @@ TEST_CASE("8 qubit Oracle standalone class","[oracle]"){
 TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
     std::size_t num_qubits = 3;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
 
     SECTION("2^3 bit patterns (8)"){
         // Testing patterns 000 001 010 011, etc.
@@ -236,6 +242,7 @@ TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("applyOracleU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -252,6 +259,7 @@ TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
 
             DYNAMIC_SECTION("applyOraclePhase with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -281,6 +289,7 @@ TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("applyOracleU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -296,6 +305,7 @@ TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
 
             DYNAMIC_SECTION("applyOraclePhase with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -319,7 +329,6 @@ TEST_CASE("3 qubit Oracle simulator method","[oracle]"){
 TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
     std::size_t num_qubits = 8;
     IntelSimulator sim(num_qubits);
-    auto& reg = sim.getQubitRegister();
 
     SECTION("2^8 bit patterns (256)"){
         // Testing patterns 000 001 010 011, etc.
@@ -338,6 +347,7 @@ TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("applyOracleU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -353,6 +363,7 @@ TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
 
             DYNAMIC_SECTION("applyOraclePhase with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -382,6 +393,7 @@ TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
         for(auto &i : bit_patterns){
             DYNAMIC_SECTION("applyOracleU with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -397,6 +409,7 @@ TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
 
             DYNAMIC_SECTION("applyOraclePhase with pattern " << i){
                 sim.initRegister();
+                auto& reg = sim.getQubitRegister();
                 //Create initial superposition
                 for(std::size_t j = 0; j < num_qubits; ++j){
                     sim.applyGateH(j);
@@ -411,4 +424,39 @@ TEST_CASE("8 qubit Oracle simulator method","[oracle]"){
             }
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Test multi-pattern phase oracle against the decomposed per-pattern oracles
+ * 
+ */
+TEST_CASE("Multi-pattern phase oracle","[oracle]"){
+    std::size_t num_qubits = 7;
+
+    std::vector<std::size_t> ctrl_indices {0, 2, 3, 5};
+    std::size_t target = 6;
+
+    // Few patterns visit the marked amplitudes only; many patterns sweep the full state
+    std::vector<std::vector<std::size_t>> pattern_sets {
+        { 0 },
+        { 3, 17, 31 },
+        { 1, 1, 5, 5 + 32 },
+        { 0, 1, 2, 4, 7, 8, 11, 13, 14, 16, 19, 21, 22, 25, 26, 28, 31 }
+    };
+
+    for(std::size_t s = 0; s < pattern_sets.size(); s++){
+        DYNAMIC_SECTION("Pattern set " << s << " with " << pattern_sets[s].size() << " patterns"){
+            IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+            Oracle<IntelSimulator> oracle;
+
+            test::prepareDistinctState(sim_gates);
+            test::prepareDistinctState(sim_native);
+
+            oracle.bitStringPhaseOracle(sim_gates, pattern_sets[s], ctrl_indices, target);
+            oracle.bitStringPhaseOracleNative(sim_native, pattern_sets[s], ctrl_indices, target);
+
+            test::requireEqualStates(sim_native, sim_gates);
+            REQUIRE(sim_native.getGateCounts() == sim_gates.getGateCounts());
+            REQUIRE(sim_native.getQubitUsage() == sim_gates.getQubitUsage());
+        }
+    }
+}
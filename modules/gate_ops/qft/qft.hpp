@@ -28,8 +28,9 @@ namespace QNLP{
          * @param qSim The qubit register
          * @param minIdx the lower-bounded index in the register to transform
          * @param maxIdx the upper-bounded index in the register to transform
+         * @param k_max Approximate QFT cutoff; controlled rotations by 2pi/2^k with k > k_max are omitted. 0 applies the exact QFT.
          */
-        static void applyQFT(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx){
+        static void applyQFT(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx, std::size_t k_max = 0){
             double theta=0;
 
             //target lines
@@ -38,6 +39,9 @@ namespace QNLP{
 
                 //Control lines:
                 for(int j = i-1; j >= (int) minIdx; j--){
+                    if(isOmitted(1+(i-j), k_max)){
+                        continue;
+                    }
                     theta = 2.0*M_PI / (std::size_t) (0b1<<(1+(i-j)));
                     qSim.applyGateCPhaseShift(theta, j,  i);
                 }
@@ -51,8 +55,9 @@ namespace QNLP{
          * @param qSim The qubit register
          * @param minIdx the lower-bounded index in the register to transform
          * @param maxIdx the upper-bounded index in the register to transform
+         * @param k_max Approximate QFT cutoff; controlled rotations by 2pi/2^k with k > k_max are omitted. 0 applies the exact IQFT.
          */
-        static void applyIQFT(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx){
+        static void applyIQFT(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx, std::size_t k_max = 0){
             double theta=0;
             qSim.InvertRegister(minIdx, maxIdx);
 
@@ -61,12 +66,86 @@ namespace QNLP{
 
                 //Control lines:
                 for(int j = minIdx; j < i; j++){
+                    if(isOmitted(1+(i-j), k_max)){
+                        continue;
+                    }
                     theta = -2.0*M_PI / (std::size_t) (0b1<<(1+(i-j)));
                     qSim.applyGateCPhaseShift(theta, j,  i);
                 }
                 qSim.applyGateH( i );
             }
         }
+
+        /**
+         * @brief Applies the forward QFT on the given register as a single FFT pass over the state-vector, rather than via the decomposed gate sequence
+         * 
+         * @param qSim The qubit register
+         * @param minIdx the lower-bounded index in the register to transform
+         * @param maxIdx the upper-bounded index in the register to transform
+         */
+        static void applyQFTNative(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx){
+            qSim.applyFourierTransform(minIdx, maxIdx, false);
+        }
+
+        /**
+         * @brief Applies the inverse QFT on the given register as a single FFT pass over the state-vector, rather than via the decomposed gate sequence
+         * 
+         * @param qSim The qubit register
+         * @param minIdx the lower-bounded index in the register to transform
+         * @param maxIdx the upper-bounded index in the register to transform
+         */
+        static void applyIQFTNative(SimulatorType& qSim, const unsigned int minIdx, const unsigned int maxIdx){
+            qSim.applyFourierTransform(minIdx, maxIdx, true);
+        }
+
+        /**
+         * @brief Whether a controlled rotation by 2pi/2^k is omitted by the approximate QFT with the given cutoff
+         * 
+         * @param k Rotation order
+         * @param k_max Approximate QFT cutoff; 0 omits no rotations
+         */
+        static bool isOmitted(std::size_t k, std::size_t k_max){
+            return (k_max != 0) && (k > k_max);
+        }
+
+        /**
+         * @brief Whether the approximate QFT over num_qubits qubits with the given cutoff omits any rotations
+         * 
+         * @param num_qubits Number of qubits in the transformed register
+         * @param k_max Approximate QFT cutoff; 0 omits no rotations
+         */
+        static bool isApproximate(std::size_t num_qubits, std::size_t k_max){
+            return isOmitted(num_qubits, k_max);
+        }
+
+        /**
+         * @brief Operator norm bound on the error of the approximate QFT, as the sum of |1 - exp(2pi i/2^k)| = 2 sin(pi/2^k) over the omitted controlled rotations. The number of rotations applied is O(n k_max) rather than O(n^2).
+         * 
+         * @param num_qubits Number of qubits in the transformed register
+         * @param k_max Approximate QFT cutoff; 0 omits no rotations
+         * @return double Error bound epsilon
+         */
+        static double approximationError(std::size_t num_qubits, std::size_t k_max){
+            double epsilon = 0.;
+            // Rotation of order k = d+1 acts between qubits a distance d apart, of which there are n-d pairs
+            for(std::size_t d = 1; d < num_qubits; d++){
+                if(isOmitted(d+1, k_max)){
+                    epsilon += (num_qubits - d) * 2.0 * std::sin(M_PI / std::pow(2.0, d+1));
+                }
+            }
+            return epsilon;
+        }
+
+        /**
+         * @brief Lower bound on the fidelity |<psi|phi>|^2 between states produced by the exact and approximate operations, given the operator norm error bound epsilon, (1 - epsilon^2/2)^2
+         * 
+         * @param epsilon Operator norm error bound, e.g. from approximationError
+         * @return double Fidelity bound
+         */
+        static double fidelityBound(double epsilon){
+            const double overlap = 1.0 - 0.5*epsilon*epsilon;
+            return (overlap > 0.) ? overlap*overlap : 0.;
+        }
     };
 }
 #endif
@@ -12,6 +12,7 @@
 //#define CATCH_CONFIG_MAIN
 
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
 #include <memory>
@@ -113,4 +114,80 @@ TEST_CASE("QFT forward and inverse","[qft]"){
             REQUIRE( r.GetProbability(idx) == 0.0 );
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Test: native QFT and IQFT kernels against the decomposed gate sequences
+ * 
+ */
+TEST_CASE("Native QFT and IQFT","[qft]"){
+    std::size_t num_qubits = 8;
+
+    std::vector<std::pair<std::size_t, std::size_t>> ranges {
+        {0, 7}, {0, 2}, {3, 5}, {5, 7}, {4, 4}, {1, 6}
+    };
+
+    for(auto& [min_idx, max_idx] : ranges){
+        for(bool inverse : {false, true}){
+            DYNAMIC_SECTION( (inverse ? "IQFT" : "QFT") << " on qubits " << min_idx << " to " << max_idx ){
+                IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+
+                test::prepareDistinctState(sim_gates);
+                test::prepareDistinctState(sim_native);
+
+                if(inverse){
+                    QFT<IntelSimulator>::applyIQFT(sim_gates, min_idx, max_idx);
+                    QFT<IntelSimulator>::applyIQFTNative(sim_native, min_idx, max_idx);
+                }
+                else{
+                    QFT<IntelSimulator>::applyQFT(sim_gates, min_idx, max_idx);
+                    QFT<IntelSimulator>::applyQFTNative(sim_native, min_idx, max_idx);
+                }
+
+                test::requireEqualStates(sim_native, sim_gates);
+                REQUIRE(sim_native.getGateCounts() == sim_gates.getGateCounts());
+                REQUIRE(sim_native.getQubitUsage() == sim_gates.getQubitUsage());
+            }
+        }
+    }
+}
+
+/**
+ * @brief Test: approximate QFT omits the rotations beyond the cutoff, and satisfies the reported fidelity bound
+ * 
+ */
+TEST_CASE("Approximate QFT","[qft]"){
+    std::size_t num_qubits = 7;
+    std::size_t min_idx = 1, max_idx = 6;
+    std::size_t n = max_idx - min_idx + 1;
+
+    for(std::size_t k_max : {2, 3, 4, 6}){
+        DYNAMIC_SECTION("Cutoff k_max = " << k_max){
+            IntelSimulator sim_exact(num_qubits), sim_approx(num_qubits);
+
+            test::prepareDistinctState(sim_exact);
+            test::prepareDistinctState(sim_approx);
+            auto counts_exact = sim_exact.getGateCounts();
+            auto counts_approx = sim_approx.getGateCounts();
+
+            QFT<IntelSimulator>::applyQFT(sim_exact, min_idx, max_idx);
+            QFT<IntelSimulator>::applyQFT(sim_approx, min_idx, max_idx, k_max);
+
+            // Each omitted rotation order k = d+1 acts on n-d qubit pairs
+            std::size_t num_omitted = 0;
+            for(std::size_t d = k_max; d < n; d++){
+                num_omitted += n - d;
+            }
+            REQUIRE( QFT<IntelSimulator>::isApproximate(n, k_max) == (num_omitted > 0) );
+            REQUIRE( sim_exact.getGateCounts().second - counts_exact.second == sim_approx.getGateCounts().second - counts_approx.second + num_omitted );
+
+            const std::complex<double> overlap = sim_exact.overlap(sim_approx);
+            const double fidelity_bound = QFT<IntelSimulator>::fidelityBound(QFT<IntelSimulator>::approximationError(n, k_max));
+            CAPTURE(std::norm(overlap), fidelity_bound);
+            REQUIRE( std::norm(overlap) >= fidelity_bound - 1e-12 );
+            if(num_omitted == 0){
+                REQUIRE( fidelity_bound == 1.0 );
+                test::requireEqualStates(sim_approx, sim_exact);
+            }
+        }
+    }
+}
@@ -16,6 +16,8 @@
 #include<vector>
 #include<complex>
 
+#include "OpBuffer.hpp"
+
 namespace QNLP{
     /**
      * @brief Class definition for implementing the Hamming distance routine along with controlled Y rotations to encode the Hamming distance into the states' amplitudes. 
@@ -106,12 +108,65 @@ namespace QNLP{
                 // Require length of auxiliary register to have n+2 qubits
                 assert(reg_memory.size() + 1 < reg_auxiliary.size());
 
+                qSim.applyOps(overwriteAuxOps(reg_memory, reg_auxiliary));
+            }
+
+            /**
+             * @brief Get the X, CCX and CSwap gate sequence of computeHammingDistanceOverwriteAux
+             *
+             * @param reg_memory A vector containing the indices of the qubits of the memory register. 
+             * @param reg_auxiliary A vector containing the indices of the qubits of the auxiliary register. 
+             * @return OpBuffer The gate sequence
+             */
+            static OpBuffer overwriteAuxOps(const std::vector<std::size_t>& reg_memory,
+                    const std::vector<std::size_t>& reg_auxiliary){
+                OpBuffer ops;
+                ops.reserve(4*reg_memory.size());
                 for(std::size_t i = 0; i < reg_memory.size(); i++){
-                    qSim.applyGateX(reg_auxiliary[i]);
-                    qSim.applyGateCCX(reg_memory[i], reg_auxiliary[i], *(reg_auxiliary.end()-2) );
-                    qSim.applyGateX(reg_auxiliary[i]);
-                    qSim.applyGateCSwap(reg_memory[i], reg_auxiliary[i], *(reg_auxiliary.end()-2) );
+                    ops.add(OpCode::X, {reg_auxiliary[i]})
+                       .add(OpCode::CCX, {reg_memory[i], reg_auxiliary[i], *(reg_auxiliary.end()-2)})
+                       .add(OpCode::X, {reg_auxiliary[i]})
+                       .add(OpCode::CSwap, {reg_memory[i], reg_auxiliary[i], *(reg_auxiliary.end()-2)});
                 }
+                return ops;
+            }
+
+            /**
+             * @brief Computes Hamming Distance; Overwrites the pattern in reg_auxiliary to track bit differences from reg_memory. Equivalent to computeHammingDistanceOverwriteAux, but as the X, CCX and CSwap sequence is a classical reversible function of (reg_memory, reg_auxiliary) it is applied as a single permutation of the basis states. The gates of the sequence are still counted.
+             *
+             * @param qSim Quantum simulator instance.
+             * @param reg_memory A vector containing the indices of the qubits of the memory register. 
+             * @param reg_auxiliary A vector containing the indices of the qubits of the auxiliary register. 
+             */
+            static void computeHammingDistanceOverwriteAuxNative(SimulatorType& qSim, 
+                    const std::vector<std::size_t>& reg_memory,
+                    const std::vector<std::size_t>& reg_auxiliary){
+
+                // Require length of auxiliary register to have n+2 qubits
+                assert(reg_memory.size() + 1 < reg_auxiliary.size());
+
+                // Sub-register layout: bits [0,n) memory, [n,2n) auxiliary, 2n target
+                const std::size_t n = reg_memory.size();
+                std::vector<std::size_t> reg_qubits(reg_memory);
+                reg_qubits.insert(reg_qubits.end(), reg_auxiliary.begin(), reg_auxiliary.begin() + n);
+                reg_qubits.push_back( *(reg_auxiliary.end()-2) );
+
+                qSim.applyRegisterPermutation(reg_qubits, [n](std::size_t val){
+                    for(std::size_t i = 0; i < n; i++){
+                        const std::size_t mem = (val >> i) & 0b1;
+                        const std::size_t aux = (val >> (n + i)) & 0b1;
+
+                        // X, CCX, X: target ^= mem & !aux
+                        val ^= (mem & (aux ^ 0b1)) << (2*n);
+
+                        // CSwap(mem; aux, target)
+                        const std::size_t tgt = (val >> (2*n)) & 0b1;
+                        if(mem && (aux != tgt)){
+                            val ^= (0b1UL << (n + i)) | (0b1UL << (2*n));
+                        }
+                    }
+                    return val;
+                }, overwriteAuxOps(reg_memory, reg_auxiliary));
             }
 
 
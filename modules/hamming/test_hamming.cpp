@@ -4,6 +4,7 @@
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 
 #include <bitset>
 
@@ -155,3 +156,39 @@ TEST_CASE("Test Hamming distance with Roatation about y axis routine","[hammingr
         }
     }
 }
+
+/**
+ * @brief Test the single pass permutation kernel for the Hamming distance overwrite routine against the gate decomposition, acting on an arbitrary (non-uniform) superposition of all qubits.
+ * 
+ */
+TEST_CASE("Test Hamming distance overwrite permutation kernel","[hamming]"){
+    const std::size_t max_qubits = 6;
+
+    for(std::size_t len_reg_memory = 1; len_reg_memory < max_qubits; len_reg_memory++){
+        DYNAMIC_SECTION("Testing " << len_reg_memory << " memory qubits"){
+            const std::size_t len_reg_auxiliary = len_reg_memory + 2;
+            const std::size_t num_qubits = len_reg_memory + len_reg_auxiliary;
+
+            IntelSimulator sim_gates(num_qubits), sim_native(num_qubits);
+
+            std::vector<std::size_t> reg_memory(len_reg_memory);
+            for(std::size_t i = 0; i < len_reg_memory; i++){
+                reg_memory[i] = i;
+            }
+            std::vector<std::size_t> reg_auxiliary(len_reg_auxiliary);
+            for(std::size_t i = 0; i < len_reg_auxiliary; i++){
+                reg_auxiliary[i] = i + len_reg_memory;
+            }
+
+            test::prepareDistinctState(sim_gates);
+            test::prepareDistinctState(sim_native);
+
+            HammingDistance<IntelSimulator>::computeHammingDistanceOverwriteAux(sim_gates, reg_memory, reg_auxiliary);
+            HammingDistance<IntelSimulator>::computeHammingDistanceOverwriteAuxNative(sim_native, reg_memory, reg_auxiliary);
+
+            test::requireEqualStates(sim_native, sim_gates);
+            REQUIRE(sim_native.getGateCounts() == sim_gates.getGateCounts());
+            REQUIRE(sim_native.getQubitUsage() == sim_gates.getQubitUsage());
+        }
+    }
+}
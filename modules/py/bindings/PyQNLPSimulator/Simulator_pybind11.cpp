@@ -16,7 +16,8 @@ using DCM = qhipster::TinyMatrix<std::complex<double>, 2u, 2u, 32u>;
 class IntelSimPy : public IntelSimulator{
     public:
 
-    IntelSimPy(int numQubits, bool useFusion=false) : IntelSimulator(numQubits,  useFusion) { }
+    IntelSimPy(int numQubits, bool useFusion=false, bool realAmplitudes=false) : IntelSimulator(numQubits,  useFusion, realAmplitudes) { }
+    IntelSimPy(int numQubits, bool useFusion, bool realAmplitudes, int numThreads, bool bindThreads, MemoryPlacement memory, std::optional<std::uint64_t> seed) : IntelSimulator(numQubits,  useFusion, realAmplitudes, PlacementOptions{numThreads, bindThreads, memory}, seed) { }
     IntelSimPy(std::unique_ptr<IntelSimulator, std::default_delete<IntelSimulator> > iSim) : IntelSimulator(iSim->getNumQubits(), false) {}
     ~IntelSimPy(){}
 
@@ -32,6 +33,20 @@ class IntelSimPy : public IntelSimulator{
     void applyOracle_Opt(std::size_t bit_pattern, const DCM& U, std::vector<std::size_t>& ctrl_indices, std::vector<std::size_t>& aux_indices, std::size_t target, std::string label){
         this->applyOracleU( bit_pattern, ctrl_indices, aux_indices, target, U, label);
     }
+    void applyOracle_Phase(std::size_t bit_pattern, std::vector<std::size_t>& ctrl_indices, std::size_t target){
+        this->applyOraclePhase( bit_pattern, ctrl_indices, target);
+    }
+    void applyOracle_PhaseMulti(std::vector<std::size_t>& bit_patterns, std::vector<std::size_t>& ctrl_indices, std::size_t target){
+        this->applyOraclePhase( bit_patterns, ctrl_indices, target);
+    }
+
+    void applyGate_2U(std::vector<std::complex<double>>& values, std::size_t qubit_idx0, std::size_t qubit_idx1, std::string label){
+        TM4DP U;
+        for(std::size_t k = 0; k < 16; k++){
+            U(k / 4, k % 4) = values[k];
+        }
+        this->applyGate2U(U, qubit_idx0, qubit_idx1, label);
+    }
 
     void addUToCache_U(const DCM& U, std::string label){
         this->addUToCache(label, U);
@@ -45,8 +60,93 @@ class IntelSimPy : public IntelSimulator{
 template <class SimulatorType>
 void intel_simulator_binding(py::module &m){
 
+    //Packed operations, also accepted in place as numpy structured arrays of dtype OpDtype
+    PYBIND11_NUMPY_DTYPE(Op, code, q0, q1, q2, param);
+    m.attr("OpDtype") = py::dtype::of<Op>();
+
+    py::enum_<OpCode>(m, "OpCode")
+        .value("I", OpCode::I)
+        .value("X", OpCode::X)
+        .value("Y", OpCode::Y)
+        .value("Z", OpCode::Z)
+        .value("H", OpCode::H)
+        .value("SqrtX", OpCode::SqrtX)
+        .value("RotX", OpCode::RotX)
+        .value("RotY", OpCode::RotY)
+        .value("RotZ", OpCode::RotZ)
+        .value("PhaseShift", OpCode::PhaseShift)
+        .value("CX", OpCode::CX)
+        .value("CY", OpCode::CY)
+        .value("CZ", OpCode::CZ)
+        .value("CH", OpCode::CH)
+        .value("CRotX", OpCode::CRotX)
+        .value("CRotY", OpCode::CRotY)
+        .value("CRotZ", OpCode::CRotZ)
+        .value("CPhaseShift", OpCode::CPhaseShift)
+        .value("Swap", OpCode::Swap)
+        .value("SqrtSwap", OpCode::SqrtSwap)
+        .value("CCX", OpCode::CCX)
+        .value("CSwap", OpCode::CSwap)
+        .value("Reset", OpCode::Reset);
+
+    py::enum_<MemoryPlacement>(m, "MemoryPlacement")
+        .value("Default", MemoryPlacement::Default)
+        .value("FirstTouch", MemoryPlacement::FirstTouch)
+        .value("Interleave", MemoryPlacement::Interleave);
+
+    py::class_<PlacementInfo>(m, "PlacementInfo")
+        .def_readonly("num_threads", &PlacementInfo::num_threads)
+        .def_readonly("thread_cpus", &PlacementInfo::thread_cpus)
+        .def_readonly("node_bytes", &PlacementInfo::node_bytes);
+
+    //Process-wide arena of state-vector buffers; freed registers are recycled across simulators
+    py::enum_<HugePages>(m, "HugePages")
+        .value("Regular", HugePages::Regular)
+        .value("Transparent", HugePages::Transparent)
+        .value("Huge2MB", HugePages::Huge2MB)
+        .value("Huge1GB", HugePages::Huge1GB);
+
+    py::class_<ArenaStats>(m, "ArenaStats")
+        .def_readonly("num_allocated", &ArenaStats::num_allocated)
+        .def_readonly("num_reused", &ArenaStats::num_reused)
+        .def_readonly("retained_bytes", &ArenaStats::retained_bytes)
+        .def_readonly("huge_bytes", &ArenaStats::huge_bytes);
+
+    m.def("setHugePages", [](HugePages pages){ Arena::getInstance().setHugePages(pages); });
+    m.def("setArenaCapacity", [](std::size_t bytes){ Arena::getInstance().setCapacity(bytes); });
+    m.def("releaseArena", [](){ Arena::getInstance().release(); });
+    m.def("getArenaStats", [](){ return Arena::getInstance().getStats(); });
+
+    py::class_<AmplitudeEstimate>(m, "AmplitudeEstimate")
+        .def_readonly("probability", &AmplitudeEstimate::probability)
+        .def_readonly("std_error", &AmplitudeEstimate::std_error)
+        .def_readonly("ci_lower", &AmplitudeEstimate::ci_lower)
+        .def_readonly("ci_upper", &AmplitudeEstimate::ci_upper)
+        .def_readonly("num_shots", &AmplitudeEstimate::num_shots)
+        .def_readonly("num_oracle_queries", &AmplitudeEstimate::num_oracle_queries)
+        .def_readonly("num_state_preparations", &AmplitudeEstimate::num_state_preparations)
+        .def_readonly("max_grover_power", &AmplitudeEstimate::max_grover_power);
+
+    py::class_<OpBuffer>(m, "OpBuffer")
+        .def(py::init<>())
+        .def("add", [](OpBuffer& buf, OpCode code, const std::vector<std::size_t>& qubits, double param) -> OpBuffer& {
+                if(qubits.size() != getNumOpQubits(code)){
+                    throw py::value_error("Wrong number of qubits for the operation");
+                }
+                switch(qubits.size()){
+                    case 1: return buf.add(code, {qubits[0]}, param);
+                    case 2: return buf.add(code, {qubits[0], qubits[1]}, param);
+                    default: return buf.add(code, {qubits[0], qubits[1], qubits[2]}, param);
+                }
+            }, py::arg("code"), py::arg("qubits"), py::arg("param") = 0., py::return_value_policy::reference_internal)
+        .def("clear", &OpBuffer::clear)
+        .def("reserve", &OpBuffer::reserve)
+        .def("__len__", &OpBuffer::size);
+
     py::class_<SimulatorType>(m, "PyQNLPSimulator")
         .def(py::init<const std::size_t &, const bool &>())
+        .def(py::init<const std::size_t &, const bool &, const bool &>())
+        .def(py::init<int, bool, bool, int, bool, MemoryPlacement, std::optional<std::uint64_t>>(), py::arg("numQubits"), py::arg("useFusion"), py::arg("realAmplitudes"), py::arg("numThreads") = 0, py::arg("bindThreads") = false, py::arg("memory") = MemoryPlacement::Default, py::arg("seed") = py::none())
         .def("getGateX", &SimulatorType::getGateX, py::return_value_policy::reference)
         .def("getGateY", &SimulatorType::getGateY, py::return_value_policy::reference)
         .def("getGateZ", &SimulatorType::getGateZ, py::return_value_policy::reference)
@@ -68,14 +168,18 @@ void intel_simulator_binding(py::module &m){
         .def("applyGateCU", &SimulatorType::applyGateCU)
         .def("applyGateSwap", &SimulatorType::applyGateSwap)
         .def("applyGateSqrtSwap", &SimulatorType::applyGateSqrtSwap)
+        .def("applyGate2U", &SimulatorType::applyGate_2U)
+        .def("isRealAmplitudes", &SimulatorType::isRealAmplitudes)
+        .def("promoteToComplex", &SimulatorType::promoteToComplex)
+        .def("applyGateKU", &SimulatorType::applyGateKU, py::arg("U"), py::arg("qubits"), py::arg("label") = "U")
         .def("applyGatePhaseShift", &SimulatorType::applyGatePhaseShift)
         .def("applyGateCPhaseShift", &SimulatorType::applyGateCPhaseShift)
         .def("applyGateCX", &SimulatorType::applyGateCX)
         .def("applyGateCCX", &SimulatorType::applyGateCCX)
         .def("applyGateCSwap", &SimulatorType::applyGateCSwap)
         .def("getNumQubits", &SimulatorType::getNumQubits)
-        .def("applyQFT", &SimulatorType::applyQFT)
-        .def("applyIQFT", &SimulatorType::applyIQFT)
+        .def("applyQFT", &SimulatorType::applyQFT, py::arg("minIdx"), py::arg("maxIdx"), py::arg("k_max") = 0)
+        .def("applyIQFT", &SimulatorType::applyIQFT, py::arg("minIdx"), py::arg("maxIdx"), py::arg("k_max") = 0)
         .def("applyDiffusion", &SimulatorType::applyDiffusion)
         .def("encodeToRegister", &SimulatorType::encodeToRegister)
         .def("encodeBinToSuperpos_unique", &SimulatorType::encodeBinToSuperpos_unique)
@@ -83,20 +187,52 @@ void intel_simulator_binding(py::module &m){
         .def("applyMeasurement", &SimulatorType::applyMeasurement)
         .def("applyMeasurementToRegister", &SimulatorType::applyMeasurementToRegister)
         .def("collapseToBasisZ", &SimulatorType::collapseToBasisZ)
-        .def("initRegister", &SimulatorType::initRegister)
+        .def("resetQubit", &SimulatorType::resetQubit)
+        .def("releaseQubit", &SimulatorType::releaseQubit)
+        .def("allocateQubit", py::overload_cast<std::size_t>(&SimulatorType::allocateQubit))
+        .def("allocateQubit", py::overload_cast<>(&SimulatorType::allocateQubit))
+        .def("isQubitReleased", &SimulatorType::isQubitReleased)
+        .def("isClassicalQubit", &SimulatorType::isClassicalQubit)
+        .def("setRandomSeed", &SimulatorType::setRandomSeed, py::arg("seed"), py::arg("shot") = 0)
+        .def("getRandomSeed", &SimulatorType::getRandomSeed)
+        .def("setClassicalTracking", &SimulatorType::setClassicalTracking)
+        .def("initRegister", py::overload_cast<>(&SimulatorType::initRegister))
+        .def("initRegister", py::overload_cast<std::uint64_t, std::uint64_t>(&SimulatorType::initRegister), py::arg("seed"), py::arg("shot") = 0)
         .def("printStates", &SimulatorType::PrintStates, py::call_guard<py::scoped_ostream_redirect,py::scoped_estream_redirect>())
         .def("applyGateNCU", &SimulatorType::applyGateNCU_nonlinear)
         .def("applyGateNCU", &SimulatorType::applyGateNCU_5CX_Opt)
         .def("addUToCache", &SimulatorType::addUToCache_U)
-        .def("subReg", &SimulatorType::subReg)
-        .def("sumReg", &SimulatorType::sumReg)
+        .def("subReg", &SimulatorType::subReg, py::arg("r0_minIdx"), py::arg("r0_maxIdx"), py::arg("r1_minIdx"), py::arg("r1_maxIdx"), py::arg("k_max") = 0)
+        .def("sumReg", &SimulatorType::sumReg, py::arg("r0_minIdx"), py::arg("r0_maxIdx"), py::arg("r1_minIdx"), py::arg("r1_maxIdx"), py::arg("k_max") = 0)
+        .def("subRegRipple", &SimulatorType::subRegRipple)
+        .def("sumRegRipple", &SimulatorType::sumRegRipple)
         .def("applyOracleU", &SimulatorType::applyOracle_U)
         .def("applyOracleU", &SimulatorType::applyOracle_Opt)
         .def("getGateCounts", &SimulatorType::getGateCounts)
-        .def("applyOraclePhase", &SimulatorType::applyOraclePhase)
+        .def("applyOraclePhase", &SimulatorType::applyOracle_Phase)
+        .def("applyOraclePhase", &SimulatorType::applyOracle_PhaseMulti)
         .def("groupQubits", &SimulatorType::groupQubits)
         .def("overlap", &SimulatorType::computeOverlap)
-        .def("applyHammingDistanceOverwrite", &SimulatorType::applyHammingDistanceOverwrite);
+        .def("applyHammingDistanceOverwrite", &SimulatorType::applyHammingDistanceOverwrite)
+        .def("amplifySimilarity", &SimulatorType::amplifySimilarity, py::arg("reg_mem"), py::arg("reg_aux"), py::arg("patterns"), py::arg("test_pattern"), py::arg("iterations") = 0)
+        .def("estimatePostSelection", &SimulatorType::estimatePostSelection, py::arg("reg_aux"), py::arg("num_powers") = 6, py::arg("shots_per_power") = 100, py::arg("z_score") = 1.96, py::arg("seed") = py::none())
+        .def("estimateSimilarity", &SimulatorType::estimateSimilarity, py::arg("reg_mem"), py::arg("reg_aux"), py::arg("patterns"), py::arg("num_powers") = 6, py::arg("shots_per_power") = 100, py::arg("z_score") = 1.96, py::arg("seed") = py::none())
+        .def("getStateProbability", &SimulatorType::getStateProbability)
+        .def("getPatternProbability", &SimulatorType::getPatternProbability)
+        .def("getQubitMap", &SimulatorType::getQubitMap)
+        .def("materializeQubitMap", &SimulatorType::materializeQubitMap)
+        .def("materializeState", &SimulatorType::materializeState)
+        .def("getQubitUsage", &SimulatorType::getQubitUsage)
+        .def("optimiseQubitLayout", &SimulatorType::optimiseQubitLayout)
+        .def("setGateBlockQubits", &SimulatorType::setGateBlockQubits)
+        .def("getBytesMovedPerGate", &SimulatorType::getBytesMovedPerGate)
+        .def("getPlacement", &SimulatorType::getPlacement)
+        .def("applyOps", py::overload_cast<const OpBuffer&>(&SimulatorType::applyOps))
+        // The array is read in place if it is C-contiguous with dtype OpDtype, and is otherwise rejected rather than copied
+        .def("applyOps", [](SimulatorType& sim, py::array_t<Op, py::array::c_style> ops){
+                // Codes and qubits are validated before any operation is applied; std::invalid_argument is raised as ValueError
+                sim.applyOps(ops.data(), static_cast<std::size_t>(ops.size()));
+            }, py::arg("ops").noconvert());
 /*
         .def("adjointMatrix", &SimulatorType::adjointMatrix)
         .def("matrixSqrt", &SimulatorType::matrixSqrt)
@@ -0,0 +1,1062 @@
+//##############################################################################
+/**
+ *  @file    BatchSimulator.cpp
+ *  @version 0.1
+ *
+ *  @brief Batched state-vector simulator backend for small registers.
+ *
+ *  @section DESCRIPTION
+ *  This class implements the CRTP simulator interface on a batch of
+ *  independent state-vectors of the same register, held in structure of
+ *  arrays layout so that each gate is applied to all states at once across
+ *  the SIMD lanes.
+ *
+ */
+//##############################################################################
+
+#include "Simulator.hpp"
+#include "GateWriter.hpp"
+#include "include/qureg.hpp"
+#include "include/tinymatrix.hpp"
+#include "Arena.hpp"
+#include "Philox.hpp"
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string>
+
+#ifdef ENABLE_MPI
+    #include "mpi.h"
+#endif
+
+namespace QNLP{
+
+class BatchSimulator;
+
+/**
+ * @brief The batch is not held in an Intel-QS register, and so applies the decomposed gate sequences in place of the native kernels
+ */
+template<>
+struct HasNativeKernels<BatchSimulator> : std::false_type {};
+
+/**
+ * @brief Class definition for BatchSimulator. A batch of K independent states of n qubits is held in structure of arrays layout: the real and imaginary parts of amplitude i of state k are held at index i*L + k of separate arrays, where the row length L is K padded to a multiple of the SIMD width. Each gate is applied to every state in one pass, with the loop over states vectorised, so that registers too small to fill the SIMD lanes along their own amplitudes still do so across the batch.
+ *
+ * Gates are applied to all states alike. Measurements draw a random number per state, state k drawing from the stream of shot s + k for the shot s set by setRandomSeed, so that each state measures as an IntelSimulator shot of the same seed would, and collapse each state to its own outcome in a single masked pass; the per-state outcomes are returned by applyMeasurementBatch and applyMeasurementToRegisterBatch. The interface methods returning a single value, applyMeasurement and getStateProbability, give that of state 0. Test patterns may differ per state, for parameter sweeps, with encodeToRegisterBatch and the per-state overload of applyHammingDistanceRotY.
+ *
+ * If built with MPI enabled, the batch is replicated on every rank, and every rank draws the same random numbers in measurement from the counter-based streams, with no communication.
+ */
+class BatchSimulator : public SimulatorGeneral<BatchSimulator> {
+    public:
+    using TMDP = qhipster::TinyMatrix<ComplexDP, 2, 2, 32>;
+    using TM4DP = qhipster::TinyMatrix<ComplexDP, 4, 4, 32>;
+    using CST = const std::size_t;
+    using SimulatorGeneral<BatchSimulator>::applyHammingDistanceRotY;
+
+    /**
+     * @brief Construct a new Batch Simulator object, with every state initialised to |0...0>. The batch holds 16*L*2^n bytes, for L the number of states rounded up to a multiple of 8.
+     *
+     * @param numQubits Number of qubits in each state
+     * @param numStates Number of states K in the batch; multiples of 8 fill the SIMD lanes
+     * @param seed Seed of the measurement random streams (default draws a seed from the system entropy source; see getRandomSeed)
+     */
+    BatchSimulator(int numQubits, std::size_t numStates, const std::optional<std::uint64_t>& seed=std::nullopt) : SimulatorGeneral<BatchSimulator>(),
+                                    numQubits(numQubits), num_states(numStates),
+                                    lane_stride((numStates + simd_lanes - 1) / simd_lanes * simd_lanes),
+                                    gates(5){
+        assert(numStates > 0);
+
+        //Define Pauli X
+        gates[0](0,0) = ComplexDP(0.,0.);       gates[0](0,1) = ComplexDP(1.,0.);
+        gates[0](1,0) = ComplexDP(1.,0.);       gates[0](1,1) = ComplexDP(0.,0.);
+
+        //Define Pauli Y
+        gates[1](0,0) = ComplexDP(0.,0.);       gates[1](0,1) = -ComplexDP(0.,1.);
+        gates[1](1,0) = ComplexDP(0.,1.);       gates[1](1,1) = ComplexDP(0.,0.);
+
+        //Define Pauli Z
+        gates[2](0,0) = ComplexDP(1.,0.);       gates[2](0,1) = ComplexDP(0.,0.);
+        gates[2](1,0) = ComplexDP(0.,0.);       gates[2](1,1) = ComplexDP(-1.,0.);
+
+        //Define I
+        gates[3](0,0) = ComplexDP(1.,0.);       gates[3](0,1) = ComplexDP(0.,0.);
+        gates[3](1,0) = ComplexDP(0.,0.);       gates[3](1,1) = ComplexDP(1.,0.);
+
+        //Define Pauli H
+        double coeff = (1./sqrt(2.));
+        gates[4](0,0) = ComplexDP(coeff,0.);     gates[4](0,1) = ComplexDP(coeff,0.);
+        gates[4](1,0) = ComplexDP(coeff,0.);     gates[4](1,1) = ComplexDP(-coeff,0.);
+
+        //Ensure the cache maps are populated before use.
+        this->initCaches();
+
+        //An unseeded simulator takes the seed of rank 0, so that every rank draws the same stream
+        std::uint64_t rng_seed = seed ? *seed : PhiloxStream::randomSeed();
+        #ifdef ENABLE_MPI
+            if(!seed){
+                MPI_Bcast(&rng_seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+            }
+        #endif
+        rng.seed(rng_seed);
+
+        gate_count_1qubit = 0;
+        gate_count_2qubit = 0;
+        target_usage.assign(numQubits, 0);
+        #ifndef RESOURCE_ESTIMATE
+        state_re.resize(lane_stride << numQubits);
+        state_im.resize(lane_stride << numQubits);
+        #endif
+        resetState();
+    }
+
+    /**
+     * @brief Destroy the Batch Simulator object
+     *
+     */
+    ~BatchSimulator(){ }
+
+    // 1 qubit
+    /**
+     * @brief Apply arbitrary user-defined unitary gate to qubit at qubit_idx of every state
+     *
+     * @param U User-defined unitary 2x2 matrix
+     * @param qubitIndex Index of qubit to apply gate upon
+     * @param label Label for the gate U
+     */
+    inline void applyGateU(const TMDP& U, CST qubitIndex, std::string label="U"){
+        applyNamedGate(U, qubitIndex, label);
+    }
+
+    /**
+     * @brief Apply the Identity gate to the given qubit. The state is unchanged.
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateI(std::size_t qubitIndex){
+        gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall("I", getGateI().tostr(), qubitIndex);
+        #endif
+    }
+
+    /**
+     * @brief Apply phase shift to given Qubit; [[1 0] [0 exp(i*angle)]]
+     *
+     * @param qubit_idx Qubit index to perform phase shift upon
+     * @param angle Angle of phase shift in rads
+     */
+    inline void applyGatePhaseShift(std::size_t qubit_idx, double angle){
+        TMDP U(gates[3]);
+        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+        applyNamedGate(U, qubit_idx, "PShift(theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Apply the Pauli X gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateX(CST qubitIndex){
+        applyNamedGate(getGateX(), qubitIndex, "X");
+    }
+
+    /**
+     * @brief Apply the Pauli Y gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateY(CST qubitIndex){
+        applyNamedGate(getGateY(), qubitIndex, "Y");
+    }
+
+    /**
+     * @brief Apply the Pauli Z gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateZ(CST qubitIndex){
+        applyNamedGate(getGateZ(), qubitIndex, "Z");
+    }
+
+    /**
+     * @brief Apply the Hadamard gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateH(CST qubitIndex){
+        applyNamedGate(getGateH(), qubitIndex, "H");
+    }
+
+    /**
+     * @brief Apply the Sqrt{Pauli X} gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateSqrtX(CST qubitIndex){
+        applyNamedGate(getGateSqrtX(), qubitIndex, "\\sqrt[2]{X}");
+    }
+
+    /**
+     * @brief Apply the given Rotation about X-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about X-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotX(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('X', angle), qubitIndex, "R_X(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Apply the given Rotation about Y-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about Y-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotY(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('Y', angle), qubitIndex, "R_Y(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Apply the given Rotation about Z-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about Z-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotZ(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('Z', angle), qubitIndex, "R_Z(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Get the Pauli-X gate
+     * @return TMDP return type of Pauli-X gate
+     */
+    inline TMDP getGateX(){ return gates[0]; }
+
+    /**
+     * @brief Get the Pauli-Y gate
+     * @return TMDP return type of Pauli-Y gate
+     */
+    inline TMDP getGateY(){ return gates[1]; }
+
+    /**
+     * @brief Get the Pauli-Z gate
+     * @return TMDP return type of Pauli-Z gate
+     */
+    inline TMDP getGateZ(){ return gates[2]; }
+
+    /**
+     * @brief Get the Identity
+     * @return TMDP return type of the Identity
+     */
+    inline TMDP getGateI(){ return gates[3]; }
+
+    /**
+     * @brief Get the Hadamard gate
+     * @return TMDP return type of Hadamard gate
+     */
+    inline TMDP getGateH(){ return gates[4]; }
+
+    /**
+     * @brief Get the Sqrt{Pauli X} gate
+     * @return TMDP return type of Sqrt{Pauli X} gate
+     */
+    inline TMDP getGateSqrtX(){
+        TMDP U;
+        U(0,0) = {0.5,  0.5};   U(0,1) = {0.5, -0.5};
+        U(1,0) = {0.5, -0.5};   U(1,1) = {0.5,  0.5};
+        return U;
+    }
+
+    /**
+     * @brief Get the rotation gate exp(-i angle/2 P) about the given axis P
+     * @param axis Rotation axis; one of 'X', 'Y' or 'Z'
+     * @param angle Rotation angle
+     * @return TMDP return type of the rotation gate
+     */
+    inline TMDP getGateRotation(char axis, double angle){
+        const double c = std::cos(0.5*angle), s = std::sin(0.5*angle);
+        TMDP U;
+        switch(axis){
+            case 'X':
+                U(0,0) = {c, 0.};   U(0,1) = {0., -s};
+                U(1,0) = {0., -s};  U(1,1) = {c, 0.};
+                break;
+            case 'Y':
+                U(0,0) = {c, 0.};   U(0,1) = {-s, 0.};
+                U(1,0) = {s, 0.};   U(1,1) = {c, 0.};
+                break;
+            default:
+                U(0,0) = {c, -s};   U(0,1) = {0., 0.};
+                U(1,0) = {0., 0.};  U(1,1) = {c, s};
+                break;
+        }
+        return U;
+    }
+
+    // 2 qubit
+    /**
+     * @brief Apply arbitrary user-defined two-qubit unitary gate to the given qubits. Row and column k = 2*b1 + b0 of U correspond to the basis state with b0 the value of qubit_idx0 and b1 the value of qubit_idx1.
+     *
+     * @param U User-defined unitary 4x4 matrix
+     * @param qubit_idx0 Index of qubit 0 (low bit of the matrix index)
+     * @param qubit_idx1 Index of qubit 1 (high bit of the matrix index)
+     * @param label Label for the gate U
+     */
+    inline void applyGate2U(const TM4DP& U, CST qubit_idx0, CST qubit_idx1, std::string label="U"){
+        assert(qubit_idx0 != qubit_idx1);
+
+        #ifndef RESOURCE_ESTIMATE
+        applyTwoQubitMatrix(U, qubit_idx0, qubit_idx1);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(qubit_idx0);
+        countTargetUsage(qubit_idx1);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( label, U.tostr(), qubit_idx0, qubit_idx1 );
+        #endif
+    }
+
+    /**
+     * @brief Performs Sqrt SWAP gate between two given qubits (half way SWAP)
+     *
+     * @param qubit_idx0 Qubit index 0
+     * @param qubit_idx1 Qubit index 1
+     */
+    inline void applyGateSqrtSwap(std::size_t qubit_idx0, std::size_t qubit_idx1){
+        TM4DP U;
+        for(std::size_t i = 0; i < 4; i++){
+            for(std::size_t j = 0; j < 4; j++){
+                U(i,j) = ComplexDP(i == j ? 1. : 0., 0.);
+            }
+        }
+        U(1,1) = {0.5,  0.5};   U(1,2) = {0.5, -0.5};
+        U(2,1) = {0.5, -0.5};   U(2,2) = {0.5,  0.5};
+        applyGate2U(U, qubit_idx0, qubit_idx1, "\\sqrt[2]{SWAP}");
+    }
+
+    /**
+     * @brief Apply the given controlled unitary gate on target qubit
+     *
+     * @param U User-defined arbitrary 2x2 unitary gate (matrix)
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     * @param label Optional parameter to label the gate U
+     */
+    inline void applyGateCU(const TMDP& U, CST control, CST target, std::string label="U"){
+        applyNamedControlledGate(U, control, target, label);
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-X (CNOT) on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCX(CST control, CST target){
+        applyNamedControlledGate(getGateX(), control, target, "X");
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-Y on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCY(CST control, CST target){
+        applyNamedControlledGate(getGateY(), control, target, "Y");
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-Z on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCZ(CST control, CST target){
+        applyNamedControlledGate(getGateZ(), control, target, "Z");
+    }
+
+    /**
+     * @brief Apply Controlled Hadamard on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCH(CST control, CST target){
+        applyNamedControlledGate(getGateH(), control, target, "H");
+    }
+
+    /**
+     * @brief Perform controlled phase shift gate
+     *
+     * @param angle Angle of phase shift in rads
+     * @param control Index of control qubit
+     * @param target Index of target qubit
+     */
+    inline void applyGateCPhaseShift(double angle, unsigned int control, unsigned int target){
+        TMDP U(gates[3]);
+        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+        applyNamedControlledGate(U, control, target, "CPhase");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about X-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about X-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotX(CST control, CST target, const double theta){
+        applyNamedControlledGate(getGateRotation('X', theta), control, target, "CR_X");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about Y-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about Y-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotY(CST control, CST target, double theta){
+        applyNamedControlledGate(getGateRotation('Y', theta), control, target, "CR_Y");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about Z-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about Z-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotZ(CST control, CST target, const double theta){
+        applyNamedControlledGate(getGateRotation('Z', theta), control, target, "CR_Z");
+    }
+
+    /**
+     * @brief Swap the qubits at the given indices
+     *
+     * @param qubit_idx0 Index of qubit 0 to swap &(0 -> 1)
+     * @param qubit_idx1 Index of qubit 1 to swap &(1 -> 0)
+     */
+    inline void applyGateSwap(CST qubit_idx0, CST qubit_idx1){
+        #ifndef RESOURCE_ESTIMATE
+        applyControlledSwap(0, qubit_idx0, qubit_idx1);
+        #endif
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( "SWAP", getGateI().tostr(), qubit_idx0, qubit_idx1 );
+        #endif
+    }
+
+    // 3 qubit
+    /**
+     * @brief Controlled controlled NOT (CCNOT, CCX) gate, applied as a single pass over the batch
+     *
+     * @param ctrl_qubit0 Control qubit 0
+     * @param ctrl_qubit1 Control qubit 1
+     * @param target_qubit Target qubit
+     */
+    inline void applyGateCCX(std::size_t ctrl_qubit0, std::size_t ctrl_qubit1, std::size_t target_qubit){
+        #ifndef RESOURCE_ESTIMATE
+        applyMatrix(getGateX(), (0b1UL << ctrl_qubit0) | (0b1UL << ctrl_qubit1), target_qubit);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(target_qubit);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( "X", getGateX().tostr(), ctrl_qubit0, target_qubit );
+        this->writer.twoQubitGateCall( "X", getGateX().tostr(), ctrl_qubit1, target_qubit );
+        #endif
+    }
+
+    /**
+     * @brief Controlled SWAP gate, applied as a single pass over the batch
+     *
+     * @param ctrl_qubit Control qubit
+     * @param qubit_swap0 Swap qubit 0
+     * @param qubit_swap1 Swap qubit 1
+     */
+    inline void applyGateCSwap(std::size_t ctrl_qubit, std::size_t qubit_swap0, std::size_t qubit_swap1){
+        #ifndef RESOURCE_ESTIMATE
+        applyControlledSwap(0b1UL << ctrl_qubit, qubit_swap0, qubit_swap1);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(qubit_swap0);
+        countTargetUsage(qubit_swap1);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( "CSWAP", getGateI().tostr(), ctrl_qubit, qubit_swap0 );
+        #endif
+    }
+
+    /**
+     * @brief Get the number of Qubits
+     *
+     * @return std::size_t Number of qubits in register
+     */
+    std::size_t getNumQubits() {
+        return numQubits;
+    }
+
+    /**
+     * @brief Get the number of states K in the batch
+     *
+     * @return std::size_t Number of states
+     */
+    std::size_t getNumStates() const {
+        return num_states;
+    }
+
+    /**
+     * @brief (Re)Initialise every state of the batch to |0....0>
+     *
+     */
+    void initRegister(){
+        resetState();
+        this->initCaches();
+        gate_count_1qubit = 0;
+        gate_count_2qubit = 0;
+        std::fill(target_usage.begin(), target_usage.end(), 0);
+    }
+
+    /**
+     * @brief (Re)Initialise every state of the batch to |0....0>, and restart the measurement random stream at the given seed and shot; see setRandomSeed
+     *
+     * @param seed Seed of the stream
+     * @param shot Index of the stream under the seed
+     */
+    void initRegister(std::uint64_t seed, std::uint64_t shot=0){
+        initRegister();
+        setRandomSeed(seed, shot);
+    }
+
+    /**
+     * @brief Apply normalization to the amplitudes of each state. States of zero norm, as left by a collapse to a value of zero probability, are left as zero.
+     *
+     */
+    inline void applyAmplitudeNorm(){
+        #ifndef RESOURCE_ESTIMATE
+        std::vector<double> norm = getNorms(0, 0);
+        for(auto& n : norm){
+            n = (n > 0.) ? 1. / std::sqrt(n) : 0.;
+        }
+        scaleRows(0, norm, norm);
+        #endif
+    }
+
+    /**
+     * @brief Apply measurement to a target qubit of every state, each randomly collapsing to its own value. The interface returns a single value, so that of state 0 is returned; see applyMeasurementBatch.
+     *
+     * @return bool Value that qubit of state 0 is randomly collapsed to
+     * @param target The index of the qubit being collapsed
+     * @param normalize Optional argument specifying whether amplitudes should be normalized (true) or not (false). Default value is true.
+     */
+    bool applyMeasurement(CST target, bool normalize=true){
+        return applyMeasurementBatch(target, normalize)[0];
+    }
+
+    /**
+     * @brief Apply measurement to a target qubit of every state, drawing a random number per state. Each state is collapsed to its own value, in a single pass over the batch with the kept half of each state selected by a per-state mask.
+     *
+     * @param target The index of the qubit being collapsed
+     * @param normalize Optional argument specifying whether amplitudes should be normalized (true) or not (false). Default value is true.
+     * @return std::vector<bool> Value that the qubit of each state is collapsed to
+     */
+    std::vector<bool> applyMeasurementBatch(CST target, bool normalize=true){
+        std::vector<double> rand = randomUniforms();
+        std::vector<bool> bit_vals(num_states);
+        #ifndef RESOURCE_ESTIMATE
+        const std::vector<double> p1 = getNorms(0b1UL << target, 0b1UL << target), total = getNorms(0, 0);
+        // Padding lanes are left unscaled
+        std::vector<double> scale0(lane_stride, 1.), scale1(lane_stride, 1.);
+        for(std::size_t k = 0; k < num_states; k++){
+            bit_vals[k] = rand[k] * total[k] < p1[k];
+            const double kept = bit_vals[k] ? p1[k] : total[k] - p1[k];
+            const double scale = (normalize && kept > 0.) ? 1. / std::sqrt(kept) : 1.;
+            scale0[k] = bit_vals[k] ? 0. : scale;
+            scale1[k] = bit_vals[k] ? scale : 0.;
+        }
+        scaleRows(target + 1, scale0, scale1);
+        #endif
+        return bit_vals;
+    }
+
+    /**
+     * @brief Apply measurement to a set of target qubits of every state, returning the bit string of each state as for applyMeasurementToRegister
+     *
+     * @param target_qubits Vector of indices of qubits being collapsed
+     * @param normalize Optional argument specifying whether amplitudes should be normalized (true) or not (false). Default value is true.
+     * @return std::vector<std::size_t> Integer representing the binary string of the collapsed qubits of each state, ordered by least significant digit corresponding to first qubit in target vector of indices
+     */
+    std::vector<std::size_t> applyMeasurementToRegisterBatch(const std::vector<std::size_t>& target_qubits, bool normalize=true){
+        std::vector<std::size_t> vals(num_states, 0);
+        for(int j = target_qubits.size() - 1; j > -1; j--){
+            const std::vector<bool> bit_vals = applyMeasurementBatch(target_qubits[j], normalize);
+            for(std::size_t k = 0; k < num_states; k++){
+                vals[k] |= static_cast<std::size_t>(bit_vals[k]) << j;
+            }
+        }
+        return vals;
+    }
+
+    /**
+     * @brief Seed the random streams used by measurements, making subsequent measurement outcomes reproducible. Measurement d after seeding draws the Philox counter-based number of (seed, shot + k, d) for state k, so that the batch runs the shots shot to shot + K - 1 of the seed.
+     *
+     * @param seed Seed of the streams
+     * @param shot Index of the stream of state 0 under the seed
+     */
+    void setRandomSeed(std::uint64_t seed, std::uint64_t shot=0){
+        rng.seed(seed, shot);
+    }
+
+    /**
+     * @brief Get the seed of the measurement random streams, as given to the constructor or setRandomSeed or drawn from the system entropy source
+     *
+     * @return std::uint64_t Seed of the streams
+     */
+    std::uint64_t getRandomSeed() const {
+        return rng.getSeed();
+    }
+
+    /**
+     * @brief Apply measurement to a target qubit with respect to the Z-basis, collapsing every state to the specified value (0 or 1). Amplitudes are r-normalized afterwards per state.
+     *
+     * @param target The index of the qubit being collapsed
+     * @param collapseValue The value that the register will be collapsed to (either 0 ro 1).
+     */
+    void collapseToBasisZ(CST target, bool collapseValue){
+        #ifndef RESOURCE_ESTIMATE
+        const std::vector<double> kept = getNorms(0b1UL << target, collapseValue ? (0b1UL << target) : 0);
+        std::vector<double> scale(lane_stride, 0.), zero(lane_stride, 0.);
+        for(std::size_t k = 0; k < lane_stride; k++){
+            scale[k] = (kept[k] > 0.) ? 1. / std::sqrt(kept[k]) : 0.;
+        }
+        scaleRows(target + 1, collapseValue ? zero : scale, collapseValue ? scale : zero);
+        #endif
+    }
+
+    /**
+     * @brief Get the probability of the specified qubit of state 0 being in the state |1>; see getStateProbabilities
+     *
+     * @param target Target qubit
+     * @return double Probability that the target qubit of state 0 is in the state |1>
+     */
+    inline double getStateProbability(CST target){
+        return getStateProbabilities(target)[0];
+    }
+
+    /**
+     * @brief Get the probability of the specified qubit of each state being in the state |1>
+     *
+     * @param target Target qubit
+     * @return std::vector<double> Probability that the target qubit of each state is in the state |1>
+     */
+    std::vector<double> getStateProbabilities(CST target){
+        std::vector<double> p1 = getNorms(0b1UL << target, 0b1UL << target);
+        p1.resize(num_states);
+        return p1;
+    }
+
+    /**
+     * @brief Encode a value per state into the given register, applying an X gate to the qubits of each state whose bit is set in its value. The register must be in the state |0...0>.
+     *
+     * @param values Value encoded into each state
+     * @param reg Indices of the register qubits, the first holding the least significant bit
+     * @param len_bin_pattern Number of bits encoded
+     */
+    void encodeToRegisterBatch(const std::vector<std::size_t>& values, const std::vector<std::size_t>& reg, std::size_t len_bin_pattern){
+        assert(values.size() == num_states);
+        std::vector<unsigned char> lanes(lane_stride, 0);
+        for(std::size_t i = 0; i < len_bin_pattern; i++){
+            bool any = false;
+            for(std::size_t k = 0; k < num_states; k++){
+                lanes[k] = IS_SET(values[k], i);
+                any |= static_cast<bool>(lanes[k]);
+            }
+            if(!any){
+                continue;
+            }
+            #ifndef RESOURCE_ESTIMATE
+            applyMaskedX(reg[i], lanes);
+            #endif
+            gate_count_1qubit++;
+            countTargetUsage(reg[i]);
+            #ifdef GATE_LOGGING
+            this->writer.oneQubitGateCall("X", getGateX().tostr(), reg[i]);
+            #endif
+        }
+    }
+
+    /**
+     * @brief Computes the Hamming distance between a test pattern per state and the patterns encoded in that state, adjusting the amplitudes with Y rotations as for applyHammingDistanceRotY with a single test pattern. This allows a sweep over test patterns to be run as one batch.
+     *
+     * @param test_patterns Test pattern of each state
+     * @param reg_mem Vector containing the indices of the register qubits that contain the training patterns
+     * @param reg_auxiliary Vector containing the indices of the register qubits which the first len_bin_pattern qubits will store the test pattern
+     * @param len_bin_pattern Length of the binary patterns
+     */
+    void applyHammingDistanceRotY(const std::vector<std::size_t>& test_patterns,
+            const std::vector<std::size_t>& reg_mem,
+            const std::vector<std::size_t>& reg_auxiliary,
+            std::size_t len_bin_pattern){
+        assert(len_bin_pattern < reg_auxiliary.size()-1);
+
+        encodeToRegisterBatch(test_patterns, reg_auxiliary, len_bin_pattern);
+        HammingDistance<BatchSimulator>::computeHammingDistanceRotY(*this, reg_mem, reg_auxiliary, len_bin_pattern);
+        encodeToRegisterBatch(test_patterns, reg_auxiliary, len_bin_pattern);
+    }
+
+    /**
+     * @brief Get the amplitude of the given basis state of the given state of the batch. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience and debugging/testing.
+     *
+     * @param basis_state Basis state, with bit q the value of qubit q
+     * @param state Index of the state in the batch
+     * @return ComplexDP Amplitude of the basis state
+     */
+    ComplexDP getAmplitude(std::size_t basis_state, std::size_t state){
+        assert(state < num_states);
+        const std::size_t idx = basis_state * lane_stride + state;
+        return ComplexDP(state_re[idx], state_im[idx]);
+    }
+
+    /**
+     * @brief Prints the string x and then, for each state of the batch, each basis state with non-negligible probability, followed by its amplitude and probability. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience and debugging/testing.
+     *
+     * @param x String to be printed to stdout
+     * @param qubits Indices of qubits printed in each basis state; all qubits if empty
+     */
+    inline void PrintStates(std::string x, std::vector<std::size_t> qubits = {}){
+        if(qubits.empty()){
+            qubits.resize(numQubits);
+            std::iota(qubits.begin(), qubits.end(), 0);
+        }
+        std::cout << x << std::endl;
+        for(std::size_t k = 0; k < num_states; k++){
+            std::cout << "State " << k << std::endl;
+            for(std::size_t i = 0; i < (0b1UL << numQubits); i++){
+                const ComplexDP amp = getAmplitude(i, k);
+                if(std::norm(amp) < 1e-12){
+                    continue;
+                }
+                std::cout << "|";
+                for(auto q = qubits.rbegin(); q != qubits.rend(); ++q){
+                    std::cout << IS_SET(i, *q);
+                }
+                std::cout << ">\t" << amp << "\t" << std::norm(amp) << std::endl;
+            }
+        }
+    }
+
+    #ifdef GATE_LOGGING
+    /**
+     * @brief Get the Gate Writer object
+     *
+     * @return GateWriter& Returns reference to the writer member in the class
+     */
+    GateWriter& getGateWriter(){
+        return this->writer;
+    }
+    #endif
+
+    /**
+     * @brief Print 1 and 2 qubit gate call counts. Each gate is counted once for the whole batch.
+     *
+     */
+    std::pair<std::size_t, std::size_t> getGateCounts(){
+        std::cout << "######### Gate counts #########" << std::endl;
+        std::cout << "1 qubit = " << gate_count_1qubit << std::endl;
+        std::cout << "2 qubit = " << gate_count_2qubit << std::endl;
+        std::cout << "total = " << gate_count_1qubit + gate_count_2qubit << std::endl;
+        std::cout << "###############################" << std::endl;
+        return std::make_pair(gate_count_1qubit, gate_count_2qubit);
+    }
+
+    /**
+     * @brief Get the number of gates applied with each qubit as target since the register was (re)initialised. These may be passed to QubitLayout to choose a qubit layout.
+     *
+     * @return const std::vector<std::size_t>& Number of gates targeting each qubit index
+     */
+    const std::vector<std::size_t>& getQubitUsage() const {
+        return target_usage;
+    }
+
+    private:
+    //States per SIMD row; 8 doubles fill an AVX-512 register
+    static constexpr std::size_t simd_lanes = 8;
+    //Amplitudes per pass below which the batch is updated by a single thread
+    static constexpr std::size_t parallel_threshold = 1UL << 16;
+
+    std::size_t numQubits = 0;
+    std::size_t num_states;
+    std::size_t lane_stride;
+    std::vector<TMDP> gates;
+
+    //Real and imaginary parts of amplitude i of state k, at index i*lane_stride + k
+    std::vector<double, ArenaAllocator<double>> state_re;
+    std::vector<double, ArenaAllocator<double>> state_im;
+
+    std::size_t gate_count_1qubit;
+    std::size_t gate_count_2qubit;
+    std::vector<std::size_t> target_usage;
+
+    //Measurement random streams, keyed by (seed, shot, draw index); state k draws from the stream of shot rng.getStream() + k
+    PhiloxStream rng;
+
+    /**
+     * @brief Reset every state of the batch, including the padding lanes, to |0...0>
+     */
+    void resetState(){
+        #ifndef RESOURCE_ESTIMATE
+        std::fill(state_re.begin(), state_re.end(), 0.);
+        std::fill(state_im.begin(), state_im.end(), 0.);
+        std::fill(state_re.begin(), state_re.begin() + lane_stride, 1.);
+        #endif
+    }
+
+    /**
+     * @brief Add a gate targeting the given qubit to the usage counts
+     */
+    inline void countTargetUsage(std::size_t qubit){
+        target_usage[qubit]++;
+    }
+
+    /**
+     * @brief Draw a uniform random number in [0,1) per state, from the next draw of the stream of each state; every rank draws the same numbers
+     */
+    std::vector<double> randomUniforms(){
+        const std::uint64_t draw = rng.getDrawIndex();
+        rng.setDrawIndex(draw + 1);
+        std::vector<double> rand(num_states);
+        for(std::size_t k = 0; k < num_states; k++){
+            rand[k] = PhiloxStream::uniform(rng.getSeed(), rng.getStream() + k, draw);
+        }
+        return rand;
+    }
+
+    /**
+     * @brief Apply a single qubit gate with the given label, counting and logging it
+     */
+    inline void applyNamedGate(const TMDP& U, CST qubitIndex, const std::string& label){
+        #ifndef RESOURCE_ESTIMATE
+        applyMatrix(U, 0, qubitIndex);
+        #endif
+
+        gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall(label, U.tostr(), qubitIndex);
+        #endif
+    }
+
+    /**
+     * @brief Apply a controlled single qubit gate with the given label, counting and logging it
+     */
+    inline void applyNamedControlledGate(const TMDP& U, CST control, CST target, const std::string& label){
+        assert(control != target);
+
+        #ifndef RESOURCE_ESTIMATE
+        applyMatrix(U, 0b1UL << control, target);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(target);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( label, U.tostr(), control, target );
+        #endif
+    }
+
+    /**
+     * @brief Get the index of the p-th amplitude with the target bit 0, inserting a zero bit at the target position of p
+     */
+    static inline std::size_t insertZeroBit(std::size_t p, std::size_t target){
+        const std::size_t low = (0b1UL << target) - 1;
+        return ((p & ~low) << 1) | (p & low);
+    }
+
+    /**
+     * @brief Apply the 2x2 matrix U to the target qubit of every state, on the amplitudes whose control_mask bits are all set
+     */
+    void applyMatrix(const TMDP& U, std::size_t control_mask, std::size_t target){
+        const double u00r = U(0,0).real(), u00i = U(0,0).imag(), u01r = U(0,1).real(), u01i = U(0,1).imag();
+        const double u10r = U(1,0).real(), u10i = U(1,0).imag(), u11r = U(1,1).real(), u11i = U(1,1).imag();
+        const std::size_t L = lane_stride;
+        const std::size_t stride = (0b1UL << target) * L;
+        const std::size_t num_pairs = 0b1UL << (numQubits - 1);
+        double* re = state_re.data();
+        double* im = state_im.data();
+
+        #pragma omp parallel for schedule(static) if(num_pairs * L >= parallel_threshold)
+        for(std::size_t p = 0; p < num_pairs; p++){
+            const std::size_t i0 = insertZeroBit(p, target);
+            if((i0 & control_mask) != control_mask){
+                continue;
+            }
+            double* __restrict__ r0 = re + i0*L;
+            double* __restrict__ m0 = im + i0*L;
+            double* __restrict__ r1 = r0 + stride;
+            double* __restrict__ m1 = m0 + stride;
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                const double a0r = r0[k], a0i = m0[k], a1r = r1[k], a1i = m1[k];
+                r0[k] = u00r*a0r - u00i*a0i + u01r*a1r - u01i*a1i;
+                m0[k] = u00r*a0i + u00i*a0r + u01r*a1i + u01i*a1r;
+                r1[k] = u10r*a0r - u10i*a0i + u11r*a1r - u11i*a1i;
+                m1[k] = u10r*a0i + u10i*a0r + u11r*a1i + u11i*a1r;
+            }
+        }
+    }
+
+    /**
+     * @brief Apply the 4x4 matrix U to the given qubits of every state, with matrix index k = 2*b1 + b0
+     */
+    void applyTwoQubitMatrix(const TM4DP& U, CST qubit_idx0, CST qubit_idx1){
+        double ur[4][4], ui[4][4];
+        for(std::size_t i = 0; i < 4; i++){
+            for(std::size_t j = 0; j < 4; j++){
+                ur[i][j] = U(i,j).real();
+                ui[i][j] = U(i,j).imag();
+            }
+        }
+        const std::size_t L = lane_stride;
+        const std::size_t m0 = 0b1UL << qubit_idx0, m1 = 0b1UL << qubit_idx1;
+        const std::size_t lo = std::min(qubit_idx0, qubit_idx1), hi = std::max(qubit_idx0, qubit_idx1);
+        const std::size_t num_quads = 0b1UL << (numQubits - 2);
+        double* re = state_re.data();
+        double* im = state_im.data();
+
+        #pragma omp parallel for schedule(static) if(num_quads * L >= parallel_threshold)
+        for(std::size_t p = 0; p < num_quads; p++){
+            const std::size_t i00 = insertZeroBit(insertZeroBit(p, lo), hi);
+            const std::size_t idx[4] = {i00*L, (i00 | m0)*L, (i00 | m1)*L, (i00 | m0 | m1)*L};
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                double ar[4], ai[4];
+                for(std::size_t j = 0; j < 4; j++){
+                    ar[j] = re[idx[j] + k];
+                    ai[j] = im[idx[j] + k];
+                }
+                for(std::size_t i = 0; i < 4; i++){
+                    double sr = 0., si = 0.;
+                    for(std::size_t j = 0; j < 4; j++){
+                        sr += ur[i][j]*ar[j] - ui[i][j]*ai[j];
+                        si += ur[i][j]*ai[j] + ui[i][j]*ar[j];
+                    }
+                    re[idx[i] + k] = sr;
+                    im[idx[i] + k] = si;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Swap the given qubits of every state, on the amplitudes whose control_mask bits are all set
+     */
+    void applyControlledSwap(std::size_t control_mask, CST qubit_idx0, CST qubit_idx1){
+        const std::size_t L = lane_stride;
+        const std::size_t m0 = 0b1UL << qubit_idx0, m1 = 0b1UL << qubit_idx1;
+        const std::size_t size = 0b1UL << numQubits;
+        double* re = state_re.data();
+        double* im = state_im.data();
+
+        #pragma omp parallel for schedule(static) if(size * L >= 2*parallel_threshold)
+        for(std::size_t i = 0; i < size; i++){
+            if((i & m0) == 0 || (i & m1) != 0 || (i & control_mask) != control_mask){
+                continue;
+            }
+            const std::size_t j = i ^ m0 ^ m1;
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                std::swap(re[i*L + k], re[j*L + k]);
+                std::swap(im[i*L + k], im[j*L + k]);
+            }
+        }
+    }
+
+    /**
+     * @brief Apply the X gate to the target qubit of the states selected by lanes
+     */
+    void applyMaskedX(std::size_t target, const std::vector<unsigned char>& lanes){
+        const std::size_t L = lane_stride;
+        const std::size_t stride = (0b1UL << target) * L;
+        const std::size_t num_pairs = 0b1UL << (numQubits - 1);
+        const unsigned char* mask = lanes.data();
+        double* re = state_re.data();
+        double* im = state_im.data();
+
+        #pragma omp parallel for schedule(static) if(num_pairs * L >= parallel_threshold)
+        for(std::size_t p = 0; p < num_pairs; p++){
+            const std::size_t i0 = insertZeroBit(p, target);
+            double* __restrict__ r0 = re + i0*L;
+            double* __restrict__ m0 = im + i0*L;
+            double* __restrict__ r1 = r0 + stride;
+            double* __restrict__ m1 = m0 + stride;
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                const double a0r = r0[k], a0i = m0[k], a1r = r1[k], a1i = m1[k];
+                const bool flip = mask[k];
+                r0[k] = flip ? a1r : a0r;
+                m0[k] = flip ? a1i : a0i;
+                r1[k] = flip ? a0r : a1r;
+                m1[k] = flip ? a0i : a1i;
+            }
+        }
+    }
+
+    /**
+     * @brief Get the squared norm per lane of the amplitudes whose bits under mask equal value
+     */
+    std::vector<double> getNorms(std::size_t mask, std::size_t value){
+        const std::size_t L = lane_stride;
+        std::vector<double> norms(L, 0.);
+        double* norm = norms.data();
+        const double* re = state_re.data();
+        const double* im = state_im.data();
+        for(std::size_t i = 0; i < (0b1UL << numQubits); i++){
+            if((i & mask) != value){
+                continue;
+            }
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                norm[k] += re[i*L + k]*re[i*L + k] + im[i*L + k]*im[i*L + k];
+            }
+        }
+        return norms;
+    }
+
+    /**
+     * @brief Scale each lane of the amplitudes by scale0 if their bit target_plus_one - 1 is 0, and by scale1 otherwise; with target_plus_one = 0 all amplitudes are scaled by scale0
+     */
+    void scaleRows(std::size_t target_plus_one, const std::vector<double>& scale0, const std::vector<double>& scale1){
+        const std::size_t L = lane_stride;
+        const std::size_t mask = target_plus_one ? (0b1UL << (target_plus_one - 1)) : 0;
+        const std::size_t size = 0b1UL << numQubits;
+        double* re = state_re.data();
+        double* im = state_im.data();
+
+        #pragma omp parallel for schedule(static) if(size * L >= 2*parallel_threshold)
+        for(std::size_t i = 0; i < size; i++){
+            const double* __restrict__ s = (i & mask) ? scale1.data() : scale0.data();
+            #pragma omp simd
+            for(std::size_t k = 0; k < L; k++){
+                re[i*L + k] *= s[k];
+                im[i*L + k] *= s[k];
+            }
+        }
+    }
+};
+
+};
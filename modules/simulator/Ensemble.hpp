@@ -0,0 +1,171 @@
+/**
+ * @file Ensemble.hpp
+ * @brief Shot runner distributing independent shots of a circuit over a pool of single-threaded simulators, one per OpenMP thread. Suited to small registers, for which parallelism within a gate does not pay off.
+ * @version 0.1
+ */
+
+#ifndef QNLP_ENSEMBLE
+#define QNLP_ENSEMBLE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+namespace QNLP{
+    /**
+     * @brief Histogram and throughput of a run of an Ensemble
+     */
+    struct EnsembleResult {
+        std::map<std::size_t, std::size_t> counts; ///< Number of shots giving each outcome
+        std::size_t num_shots = 0;                 ///< Number of shots run
+        int num_workers = 1;                       ///< Number of simulators the shots were run on
+        double seconds = 0.;                       ///< Wall-clock time of the run
+        double shots_per_second = 0.;              ///< Throughput of the run
+    };
+
+    /**
+     * @brief Class definition of a shot runner over a pool of simulators, one per worker thread. The shots are split evenly over the workers; a worker finishing its share steals chunks of the remaining shots of the others. The measurement random stream of each shot is keyed by the run seed and the shot index only, so the histogram of a run does not depend on the number of workers or on the schedule. Histograms are counted per worker and merged once the run completes.
+     *
+     * Each simulator runs on a single thread; its OpenMP regions are run by the worker alone. Under MPI a simulator spans all ranks, so the shots are run on a single worker.
+     *
+     * @tparam SimulatorType Simulator type, e.g. IntelSimulator
+     */
+    template<class SimulatorType>
+    class Ensemble{
+        public:
+        using Factory = std::function<std::unique_ptr<SimulatorType>()>;
+        using Circuit = std::function<std::size_t(SimulatorType&)>;
+
+        /**
+         * @brief Construct a new Ensemble object of simulators created by the given factory. Each worker creates its simulator on its own thread on first use, so that the state is first touched by that thread.
+         *
+         * @param factory Creates a simulator
+         * @param num_workers Number of workers; 0 uses the number of OpenMP threads
+         */
+        Ensemble(Factory factory, int num_workers = 0) : factory(factory), num_workers(num_workers) {
+            if(this->num_workers <= 0){
+                this->num_workers = 1;
+                #ifdef _OPENMP
+                this->num_workers = omp_get_max_threads();
+                #endif
+            }
+            #if defined(ENABLE_MPI) || !defined(_OPENMP)
+            this->num_workers = 1;
+            #endif
+            simulators.resize(this->num_workers);
+        }
+
+        /**
+         * @brief Construct a new Ensemble object of simulators of the given number of qubits
+         *
+         * @param num_qubits Number of qubits of each simulator
+         * @param num_workers Number of workers; 0 uses the number of OpenMP threads
+         */
+        Ensemble(std::size_t num_qubits, int num_workers = 0) :
+            Ensemble([num_qubits]{ return std::unique_ptr<SimulatorType>(new SimulatorType(num_qubits)); }, num_workers) {}
+
+        /**
+         * @brief Run the given circuit for num_shots shots. Each shot runs on a simulator reinitialised to |0...0>.
+         *
+         * @param circuit Applies the circuit to the simulator and returns the measured outcome of the shot; called concurrently by the workers
+         * @param num_shots Number of shots
+         * @param seed Seed of the measurement random streams of the run
+         * @return EnsembleResult Histogram of the outcomes and throughput of the run
+         */
+        EnsembleResult run(const Circuit& circuit, std::size_t num_shots, std::uint64_t seed = 0){
+            EnsembleResult result;
+            result.num_shots = num_shots;
+            result.num_workers = num_workers;
+
+            //Shots claimed so far and the end of the share of each worker; each on its own cache line
+            std::vector<ShotRange> ranges(num_workers);
+            for(int w = 0; w < num_workers; w++){
+                ranges[w].next.store(num_shots * w / num_workers, std::memory_order_relaxed);
+                ranges[w].end = num_shots * (w + 1) / num_workers;
+            }
+            const std::size_t chunk = std::max<std::size_t>(1, num_shots / (num_workers * chunks_per_worker));
+
+            std::vector<std::map<std::size_t, std::size_t>> counts(num_workers);
+            std::vector<std::exception_ptr> errors(num_workers);
+
+            const auto start = std::chrono::steady_clock::now();
+            #pragma omp parallel num_threads(num_workers)
+            {
+                int w = 0;
+                #ifdef _OPENMP
+                w = omp_get_thread_num();
+                //Serialise the OpenMP regions of the worker's simulator
+                omp_set_num_threads(1);
+                #endif
+                try{
+                    if(simulators[w] == nullptr){
+                        simulators[w] = factory();
+                    }
+                    SimulatorType& sim = *simulators[w];
+                    //Own share first, then steal from the following workers in turn
+                    for(int v = 0; v < num_workers; v++){
+                        ShotRange& range = ranges[(w + v) % num_workers];
+                        for(std::size_t begin; (begin = range.next.fetch_add(chunk, std::memory_order_relaxed)) < range.end; ){
+                            const std::size_t end = std::min(begin + chunk, range.end);
+                            for(std::size_t shot = begin; shot < end; shot++){
+                                sim.initRegister(seed, shot);
+                                counts[w][circuit(sim)]++;
+                            }
+                        }
+                    }
+                }
+                catch(...){
+                    errors[w] = std::current_exception();
+                }
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            for(auto& error : errors){
+                if(error){
+                    std::rethrow_exception(error);
+                }
+            }
+            for(auto& worker_counts : counts){
+                for(auto& count : worker_counts){
+                    result.counts[count.first] += count.second;
+                }
+            }
+            result.seconds = elapsed.count();
+            result.shots_per_second = (result.seconds > 0.) ? num_shots / result.seconds : 0.;
+            return result;
+        }
+
+        /**
+         * @brief Get the number of workers, and so of simulators, of the ensemble
+         */
+        int getNumWorkers() const {
+            return num_workers;
+        }
+
+        private:
+        //Chunks each worker's share is claimed in, trading load balance against contention on the shared cursors
+        static constexpr std::size_t chunks_per_worker = 16;
+
+        struct alignas(64) ShotRange {
+            std::atomic<std::size_t> next;
+            std::size_t end;
+        };
+
+        Factory factory;
+        int num_workers;
+        std::vector<std::unique_ptr<SimulatorType>> simulators;
+    };
+};
+
+#endif
@@ -13,6 +13,7 @@
 #define QNLP_SIMULATOR_INTERFACE_H
 
 #include <cstdlib>
+#include "OpBuffer.hpp"
 namespace QNLP{
     /**
     * @class	The abstract interface for implementing the QNLP-quantum 
@@ -151,6 +152,13 @@ namespace QNLP{
          */
         virtual std::size_t getNumQubits() = 0;
 
+        /**
+         * @brief Apply the operations of the buffer back-to-back, with a single call through the interface
+         * 
+         * @param ops Buffer of operations to apply, in order
+         */
+        virtual void applyOps(const OpBuffer& ops) = 0;
+
         //virtual void applyGateCU(const std::array<complex<double>,4>& mat2x2, std::size_t control, std::size_t target);
     };
 }
@@ -18,9 +18,27 @@
 #include "GateWriter.hpp"
 #include "include/qureg.hpp"
 #include "include/tinymatrix.hpp"
+#include "Placement.hpp"
+#include "Arena.hpp"
+#include "Philox.hpp"
 #include <cstdlib>
+#include <cassert>
+#include <algorithm>
 #include <iostream>
 #include <limits>
+#include <vector>
+#include <unordered_set>
+#include <map>
+#include <cmath>
+#include <numeric>
+#include <memory>
+#include <type_traits>
+#include <optional>
+#include <cstdint>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 #ifdef ENABLE_MPI
     #include "mpi.h"
@@ -31,11 +49,20 @@ namespace QNLP{
 /**
  * @brief Class definition for IntelSimulator. The purpose of this class is to map the functionality of the underlying quantum simulator to this class so that it can be used as the template for the CRTP templated SimulatorGeneral class.
  * 
+ * @tparam Type Complex type of the state amplitudes (ComplexDP or ComplexSP)
+ * @tparam GateType Complex type of the gate matrices; a mixed-precision simulator holds a ComplexSP state with ComplexDP gates, applied and normalized in double precision
  */
-class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
+template<class Type, class GateType = Type>
+class IntelSimulatorT : public SimulatorGeneral<IntelSimulatorT<Type, GateType>> {
     public:
-    using TMDP = qhipster::TinyMatrix<ComplexDP, 2, 2, 32>;
-    using QRDP = QubitRegister<ComplexDP>;
+    //Gate matrices are held in the gate precision, and the state in the state precision
+    using TMDP = qhipster::TinyMatrix<GateType, 2, 2, 32>;
+    using TM4DP = qhipster::TinyMatrix<GateType, 4, 4, 32>;
+    using QRDP = QubitRegister<Type>;
+    //State-vector sized buffers, pooled and huge-page backed by the arena
+    using StateBuffer = std::vector<Type, ArenaAllocator<Type>>;
+    using RealType = typename Type::value_type;
+    using GateRealType = typename GateType::value_type;
     using CST = const std::size_t;
 
     /**
@@ -43,32 +70,37 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * 
      * @param numQubits Number of qubits in quantum register
      * @param useFusion Implement gate fusion (default is False)
+     * @param realAmplitudes Hold the state with real amplitudes, halving its memory and bandwidth, for as long as only real gates are applied (default is False). See promoteToComplex.
+     * @param placement Number of OpenMP threads, thread binding and NUMA placement of the state-vector (default keeps the OpenMP and OS defaults). The thread count and binding apply to the parallel regions of the simulator only, the threads being unbound again on return. See getPlacement.
+     * @param seed Seed of the measurement random stream (default draws a seed from the system entropy source; see getRandomSeed)
      */
-    IntelSimulator(int numQubits, bool useFusion=false) : SimulatorGeneral<IntelSimulator>(), 
+    IntelSimulatorT(int numQubits, bool useFusion=false, bool realAmplitudes=false, const PlacementOptions& placement=PlacementOptions(), const std::optional<std::uint64_t>& seed=std::nullopt) : SimulatorGeneral<IntelSimulatorT<Type, GateType>>(), 
                                     numQubits(numQubits), 
-                                    qubitRegister(QubitRegister<ComplexDP> (numQubits, "base", 0)),
-                                    gates(5), uid( reinterpret_cast<std::size_t>(this) ){
+                                    qubitRegister(acquireRegister(realAmplitudes ? numQubits - 1 : numQubits)),
+                                    real_amplitudes(realAmplitudes), use_fusion(useFusion),
+                                    gates(5), uid( reinterpret_cast<std::size_t>(this) ), placement(placement){
+        assert(!realAmplitudes || numQubits > 1);
 
         //Define Pauli X
-        gates[0](0,0) = ComplexDP(0.,0.);       gates[0](0,1) = ComplexDP(1.,0.);
-        gates[0](1,0) = ComplexDP(1.,0.);       gates[0](1,1) = ComplexDP(0.,0.);
+        gates[0](0,0) = GateType(0.,0.);       gates[0](0,1) = GateType(1.,0.);
+        gates[0](1,0) = GateType(1.,0.);       gates[0](1,1) = GateType(0.,0.);
 
         //Define Pauli Y
-        gates[1](0,0) = ComplexDP(0.,0.);       gates[1](0,1) = -ComplexDP(0.,1.);
-        gates[1](1,0) = ComplexDP(0.,1.);       gates[1](1,1) = ComplexDP(0.,0.);
+        gates[1](0,0) = GateType(0.,0.);       gates[1](0,1) = -GateType(0.,1.);
+        gates[1](1,0) = GateType(0.,1.);       gates[1](1,1) = GateType(0.,0.);
 
         //Define Pauli Z
-        gates[2](0,0) = ComplexDP(1.,0.);       gates[2](0,1) = ComplexDP(0.,0.);
-        gates[2](1,0) = ComplexDP(0.,0.);       gates[2](1,1) = ComplexDP(-1.,0.);
+        gates[2](0,0) = GateType(1.,0.);       gates[2](0,1) = GateType(0.,0.);
+        gates[2](1,0) = GateType(0.,0.);       gates[2](1,1) = GateType(-1.,0.);
 
         //Define I
-        gates[3](0,0) = ComplexDP(1.,0.);       gates[3](0,1) = ComplexDP(0.,0.);
-        gates[3](1,0) = ComplexDP(0.,0.);       gates[3](1,1) = ComplexDP(1.,0.);
+        gates[3](0,0) = GateType(1.,0.);       gates[3](0,1) = GateType(0.,0.);
+        gates[3](1,0) = GateType(0.,0.);       gates[3](1,1) = GateType(1.,0.);
 
         //Define Pauli H
         double coeff = (1./sqrt(2.));
-        gates[4](0,0) = coeff*ComplexDP(1.,0.);   gates[4](0,1) = coeff*ComplexDP(1.,0.);
-        gates[4](1,0) = coeff*ComplexDP(1.,0.);   gates[4](1,1) = -coeff*ComplexDP(1.,0.);
+        gates[4](0,0) = GateType(coeff,0.);     gates[4](0,1) = GateType(coeff,0.);
+        gates[4](1,0) = GateType(coeff,0.);     gates[4](1,1) = GateType(-coeff,0.);
 
         //Ensure the cache maps are populated before use.
         this->initCaches();
@@ -86,29 +118,53 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
             MPI_Comm_rank(MPI_COMM_WORLD, &rank);
         #endif
 
-        /* Set up random number generator for randomly collapsing qubit to 0 or 1
+        /* Set up the random stream for randomly collapsing qubit to 0 or 1
          *
-         * Note: a random number will be generated on rank 0 and then broadcasted
-         * to all ranks so that each rank collapses the respective qubit to the
-         * same value.
+         * Note: each draw is a function of the seed and draw index only, so
+         * every rank computes the same number locally; only an unseeded
+         * simulator broadcasts its seed from rank 0, once.
          */
-        std::mt19937 mt_(rd()); 
-        std::uniform_real_distribution<double> dist_(0.0,1.0);
-        mt = mt_;
-        dist = dist_;
+        std::uint64_t rng_seed = seed ? *seed : PhiloxStream::randomSeed();
+        #ifdef ENABLE_MPI
+            if(!seed){
+                MPI_Bcast(&rng_seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+            }
+        #endif
+        rng.seed(rng_seed);
         if(useFusion == true){
-            qubitRegister.TurnOnFusion();
+            qubitRegister->TurnOnFusion();
             std::cerr << "Warning: enabling fusion may cause inconsistent results." << std::endl;
         }
         gate_count_1qubit = 0;
         gate_count_2qubit = 0;
+        target_usage.assign(numQubits, 0);
+        resetQubitMap();
+        classical_bits.assign(numQubits, 0);
+        flipped_bits.assign(numQubits, 0);
+
+        const ThreadScope scope = threadScope();
+        if(placement.bind_threads && !scope.isBound()){
+            std::cerr << "Warning: unable to bind threads to CPUs." << std::endl;
+        }
+        placeRegister();
     }
 
     /**
      * @brief Destroy the Intel Simulator object
      * 
      */
-    ~IntelSimulator(){ }
+    ~IntelSimulatorT(){
+        recycleRegister(std::move(qubitRegister));
+        #ifdef ENABLE_MPI
+        int mpi_is_final;
+        MPI_Finalized(&mpi_is_final);
+        if(!mpi_is_final){
+            for(auto& entry : reflect_comms){
+                MPI_Comm_free(&entry.second);
+            }
+        }
+        #endif
+    }
 
     // 1 qubit
     /**
@@ -120,13 +176,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateU(const TMDP& U, CST qubitIndex, std::string label="U"){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.Apply1QubitGate(qubitIndex, U);
+        if(!applyClassicalGate(U, qubitIndex) && !scheduleGate(U, qubit_map[qubitIndex])){
+            threadedRegister()->Apply1QubitGate(qubit_map[qubitIndex], stateMatrix(U));
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall(label, U.tostr(), qubitIndex);
+        this->writer.oneQubitGateCall(label, U.tostr(), qubitIndex);
         #endif
     }
 
@@ -141,9 +200,10 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("I", getGateI().tostr(), qubitIndex);
+        this->writer.oneQubitGateCall("I", getGateI().tostr(), qubitIndex);
         #endif
     }
 
@@ -156,21 +216,174 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
     inline void applyGatePhaseShift(std::size_t qubit_idx, double angle){
         //Phase gate is identity with 1,1 index modulated by angle
         TMDP U(gates[3]);
-        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+        U(1, 1) = GateType(cos(angle), sin(angle));
 
         #ifndef RESOURCE_ESTIMATE
         applyGateU(U, qubit_idx, "Phase:=" + std::to_string(angle));
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubit_idx);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("PShift(theta=" + std::to_string(angle) + ")", U.tostr(), qubit_idx);
+        this->writer.oneQubitGateCall("PShift(theta=" + std::to_string(angle) + ")", U.tostr(), qubit_idx);
         #endif
 
     }
 
     // 2 qubit
+    /**
+     * @brief Apply arbitrary user-defined two-qubit unitary gate to the given qubits as a single pass over the state-vector. Row and column k = 2*b1 + b0 of U correspond to the basis state with b0 the value of qubit_idx0 and b1 the value of qubit_idx1. If either qubit is distributed across MPI ranks, it is first relabelled onto a local qubit with an all-to-all exchange.
+     * 
+     * @param U User-defined unitary 4x4 matrix
+     * @param qubit_idx0 Index of qubit 0 (low bit of the matrix index)
+     * @param qubit_idx1 Index of qubit 1 (high bit of the matrix index)
+     * @param label Label for the gate U
+     */
+    inline void applyGate2U(const TM4DP& U, CST qubit_idx0, CST qubit_idx1, std::string label="U"){
+        assert(qubit_idx0 != qubit_idx1);
+
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        flushScheduledGates();
+        makeQubitsLocal({qubit_idx0, qubit_idx1});
+        const std::size_t flips = untrackQubits({qubit_idx0, qubit_idx1});
+        GateType U_flat[16];
+        for(std::size_t k = 0; k < 16; k++){
+            U_flat[k] = U(k / 4, (k % 4) ^ flips);
+        }
+        applyKQubitMatrix<2>(U_flat, {qubit_map[qubit_idx0], qubit_map[qubit_idx1]});
+        num_state_gates++;
+        bytes_moved += 2 * sizeof(Type) * qubitRegister->LocalSize();
+        keepRegisterCurrent();
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(qubit_idx0);
+        countTargetUsage(qubit_idx1);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( label, U.tostr(), qubit_idx0, qubit_idx1 );
+        #endif
+    }
+
+    /**
+     * @brief Apply arbitrary user-defined unitary gate on up to max_dense_gate_qubits qubits as a single pass over the state-vector, such as a fused block of gates. Row and column k of U correspond to the basis state with bit i of k the value of qubits[i]. The gate is counted as a single 1 or 2 qubit gate. If any of the qubits are distributed across MPI ranks, they are first relabelled onto local qubits with an all-to-all exchange.
+     * 
+     * @param U User-defined unitary 2^k x 2^k matrix in row-major order, k = qubits.size()
+     * @param qubits Indices of the qubits the gate acts upon
+     * @param label Label for the gate U
+     */
+    void applyGateKU(const std::vector<GateType>& U, const std::vector<std::size_t>& qubits, std::string label="U"){
+        assert(qubits.size() >= 1 && qubits.size() <= max_dense_gate_qubits);
+        assert(U.size() == (0b1UL << (2*qubits.size())));
+
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        flushScheduledGates();
+        makeQubitsLocal(qubits);
+        const std::vector<std::size_t> physical = physicalQubits(qubits);
+
+        // Deferred X gates of classical qubits are folded into the columns of U
+        const std::size_t flips = untrackQubits(qubits);
+        std::vector<GateType> U_folded;
+        const GateType* U_data = U.data();
+        if(flips != 0){
+            const std::size_t dim = 0b1UL << qubits.size();
+            U_folded.resize(U.size());
+            for(std::size_t k = 0; k < U.size(); k++){
+                U_folded[k] = U[(k / dim) * dim + ((k % dim) ^ flips)];
+            }
+            U_data = U_folded.data();
+        }
+        switch(qubits.size()){
+            case 1: applyKQubitMatrix<1>(U_data, physical); break;
+            case 2: applyKQubitMatrix<2>(U_data, physical); break;
+            case 3: applyKQubitMatrix<3>(U_data, physical); break;
+            case 4: applyKQubitMatrix<4>(U_data, physical); break;
+            case 5: applyKQubitMatrix<5>(U_data, physical); break;
+        }
+        num_state_gates++;
+        bytes_moved += 2 * sizeof(Type) * qubitRegister->LocalSize();
+        keepRegisterCurrent();
+        #endif
+
+        if(qubits.size() == 1){
+            gate_count_1qubit++;
+        }
+        else{
+            gate_count_2qubit++;
+        }
+        for(auto q : qubits){
+            countTargetUsage(q);
+        }
+
+        #ifdef GATE_LOGGING
+        std::string qubit_str;
+        for(auto q : qubits){
+            qubit_str += std::to_string(q) + ";";
+        }
+        this->writer.oneQubitGateCall( label + "(" + qubit_str + ")", "", qubits[0] );
+        #endif
+    }
+
+    /**
+     * @brief Apply packed operations as SimulatorGeneral::applyOps, fusing the single qubit gates acting on each qubit between multi-qubit operations into a single 2x2 gate. Gates on different qubits commute, so each fused gate is applied when an operation on more qubits (or a reset) next acts on its qubit, or at the end of the buffer. Each fused gate is counted as the number of gates it replaces.
+     * 
+     * @param ops Pointer to the first operation
+     * @param num_ops Number of operations to apply
+     */
+    void applyFusedOps(const Op* ops, std::size_t num_ops){
+        std::vector<TMDP> fused(numQubits);
+        std::vector<std::size_t> num_fused(numQubits, 0);
+        std::vector<std::size_t> fused_qubits;
+
+        auto applyFused = [&](std::size_t q){
+            if(num_fused[q] == 0){
+                return;
+            }
+            #ifndef RESOURCE_ESTIMATE
+            if(!applyClassicalGate(fused[q], q) && !scheduleGate(fused[q], qubit_map[q])){
+                threadedRegister()->Apply1QubitGate(qubit_map[q], stateMatrix(fused[q]));
+            }
+            #endif
+            gate_count_1qubit += num_fused[q];
+            for(std::size_t k = 0; k < num_fused[q]; k++){
+                countTargetUsage(q);
+            }
+            num_fused[q] = 0;
+        };
+
+        for(std::size_t i = 0; i < num_ops; i++){
+            const Op& op = ops[i];
+            const OpCode code = static_cast<OpCode>(op.code);
+            if(isSingleQubitGate(code)){
+                assert(op.q0 < numQubits);
+                const TMDP U = getOpGate(op);
+                if(num_fused[op.q0]++ == 0){
+                    fused[op.q0] = U;
+                    fused_qubits.push_back(op.q0);
+                }
+                else{
+                    fused[op.q0] = matrixProduct(U, fused[op.q0]);
+                }
+                continue;
+            }
+            const std::size_t num_op_qubits = getNumOpQubits(code);
+            applyFused(op.q0);
+            if(num_op_qubits > 1){
+                applyFused(op.q1);
+            }
+            if(num_op_qubits > 2){
+                applyFused(op.q2);
+            }
+            this->applyOp(op);
+        }
+        for(auto q : fused_qubits){
+            applyFused(q);
+        }
+    }
+
     /**
      * @brief Performs Sqrt SWAP gate between two given qubits (half way SWAP)
      * 
@@ -178,8 +391,12 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param qubit_idx1 Qubit index 1
      */
     inline void applyGateSqrtSwap(  std::size_t qubit_idx0, std::size_t qubit_idx1){    
-        std::cerr << "NOT YET IMPLEMENTED" << std::endl; 
-        std::abort();
+        TM4DP U;
+        U(0,0) = {1., 0.};
+        U(1,1) = {0.5,  0.5};   U(1,2) = {0.5, -0.5};
+        U(2,1) = {0.5, -0.5};   U(2,2) = {0.5,  0.5};
+        U(3,3) = {1., 0.};
+        applyGate2U(U, qubit_idx0, qubit_idx1, "\\sqrt[2]{SWAP}");
     }
 
     // 3 qubit
@@ -191,7 +408,15 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param target_qubit Target qubit
      */
     inline void applyGateCCX(std::size_t ctrl_qubit0, std::size_t ctrl_qubit1, std::size_t target_qubit){
+        #ifdef QNLP_NATIVE_KERNELS
+        // Swap |c0 c1 0> and |c0 c1 1> with both controls set
+        applyControlledPairSwap({ctrl_qubit0, ctrl_qubit1, target_qubit}, 0b011, 0b111);
+
+        // Counted as the 5 two-qubit gate NCU decomposition: CU(c1,t), CX(c0,c1), CU(c1,t), CX(c0,c1), CU(c0,t)
+        countNCUDecomposition({ctrl_qubit0, ctrl_qubit1}, target_qubit);
+        #else
         this->applyGateNCU(this->getGateX(), std::vector<std::size_t> {ctrl_qubit0, ctrl_qubit1}, target_qubit, "X");
+        #endif
     }
 
     /**
@@ -203,6 +428,13 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param qubit_swap1 Swap qubit 1
      */
     inline void applyGateCSwap(std::size_t ctrl_qubit, std::size_t qubit_swap0, std::size_t qubit_swap1){
+        #ifdef QNLP_NATIVE_KERNELS
+        // Swap |1 1 0> and |1 0 1> with the control set
+        applyControlledPairSwap({ctrl_qubit, qubit_swap0, qubit_swap1}, 0b011, 0b101);
+
+        // Counted as the 7 two-qubit gate decomposition below
+        countCSwapDecomposition(qubit_swap0, qubit_swap1);
+        #else
         //V = sqrt(X)
         TMDP V;
         V(0,0) = {0.5,  0.5};
@@ -224,6 +456,7 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
         applyGateCU(V_dag, qubit_swap0, qubit_swap1, "X");
         applyGateCX(qubit_swap1, qubit_swap0);
         applyGateCX(ctrl_qubit, qubit_swap0);
+        #endif
     }
 
     //#################################################
@@ -235,13 +468,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateX(CST qubitIndex){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyPauliX(qubitIndex);
+        if(!applyClassicalGate(getGateX(), qubitIndex) && !scheduleGate(getGateX(), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyPauliX(qubit_map[qubitIndex]);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("X", getGateX().tostr(), qubitIndex);
+        this->writer.oneQubitGateCall("X", getGateX().tostr(), qubitIndex);
         #endif
     }
 
@@ -252,13 +488,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateY(CST qubitIndex){ 
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyPauliY(qubitIndex);
+        if(!applyClassicalGate(getGateY(), qubitIndex) && !scheduleGate(getGateY(), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyPauliY(qubit_map[qubitIndex]);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("Y", getGateY().tostr(), qubitIndex);
+        this->writer.oneQubitGateCall("Y", getGateY().tostr(), qubitIndex);
         #endif
     }
 
@@ -269,13 +508,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateZ(CST qubitIndex){ 
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyPauliZ(qubitIndex);
+        if(!applyClassicalGate(getGateZ(), qubitIndex) && !scheduleGate(getGateZ(), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyPauliZ(qubit_map[qubitIndex]);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("Z", getGateZ().tostr(), qubitIndex);
+        this->writer.oneQubitGateCall("Z", getGateZ().tostr(), qubitIndex);
         #endif
     }
 
@@ -286,13 +528,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateH(CST qubitIndex){ 
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyHadamard(qubitIndex);
+        if(!applyClassicalGate(getGateH(), qubitIndex) && !scheduleGate(getGateH(), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyHadamard(qubit_map[qubitIndex]);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall("H", getGateH().tostr(), qubitIndex);
+        this->writer.oneQubitGateCall("H", getGateH().tostr(), qubitIndex);
         #endif
     }
 
@@ -303,13 +548,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
    inline void applyGateSqrtX(CST qubitIndex){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyPauliSqrtX(qubitIndex);
+        if(!applyClassicalGate(getGateSqrtX(), qubitIndex) && !scheduleGate(getGateSqrtX(), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyPauliSqrtX(qubit_map[qubitIndex]);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall(
+        this->writer.oneQubitGateCall(
             "\\sqrt[2]{X}", 
             matrixSqrt<decltype(getGateX())>(getGateX()).tostr(), 
             qubitIndex
@@ -325,13 +573,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateRotX(CST qubitIndex, double angle) {
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyRotationX(qubitIndex, angle);
+        if(!applyClassicalGate(getGateRotation('X', angle), qubitIndex) && !scheduleGate(getGateRotation('X', angle), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyRotationX(qubit_map[qubitIndex], angle);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall(
+        this->writer.oneQubitGateCall(
             "R_X(\\theta=" + std::to_string(angle) + ")", 
             getGateI().tostr(), 
             qubitIndex
@@ -347,13 +598,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateRotY(CST qubitIndex, double angle) {
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyRotationY(qubitIndex, angle);
+        if(!applyClassicalGate(getGateRotation('Y', angle), qubitIndex) && !scheduleGate(getGateRotation('Y', angle), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyRotationY(qubit_map[qubitIndex], angle);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall(
+        this->writer.oneQubitGateCall(
             "R_Y(\\theta=" + std::to_string(angle) + ")", 
             getGateI().tostr(), 
             qubitIndex
@@ -369,13 +623,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateRotZ(CST qubitIndex, double angle) {
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyRotationZ(qubitIndex, angle);
+        if(!applyClassicalGate(getGateRotation('Z', angle), qubitIndex) && !scheduleGate(getGateRotation('Z', angle), qubit_map[qubitIndex])){
+            threadedRegister()->ApplyRotationZ(qubit_map[qubitIndex], angle);
+        }
         #endif
 
         gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
 
         #ifdef GATE_LOGGING
-        writer.oneQubitGateCall(
+        this->writer.oneQubitGateCall(
             "R_Z(\\theta=" + std::to_string(angle) + ")", 
             getGateI().tostr(), 
             qubitIndex
@@ -413,6 +670,43 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline TMDP getGateH(){ return gates[4]; }
 
+    /**
+     * @brief Get the Sqrt{Pauli X} gate
+     * @return TMDP return type of Sqrt{Pauli X} gate
+     */
+    inline TMDP getGateSqrtX(){
+        TMDP U;
+        U(0,0) = {0.5,  0.5};   U(0,1) = {0.5, -0.5};
+        U(1,0) = {0.5, -0.5};   U(1,1) = {0.5,  0.5};
+        return U;
+    }
+
+    /**
+     * @brief Get the rotation gate exp(-i angle/2 P) about the given axis P, as applied by applyGateRotX/Y/Z
+     * @param axis Rotation axis; one of 'X', 'Y' or 'Z'
+     * @param angle Rotation angle
+     * @return TMDP return type of the rotation gate
+     */
+    inline TMDP getGateRotation(char axis, double angle){
+        const double c = std::cos(0.5*angle), s = std::sin(0.5*angle);
+        TMDP U;
+        switch(axis){
+            case 'X':
+                U(0,0) = GateType(c, 0.);   U(0,1) = GateType(0., -s);
+                U(1,0) = GateType(0., -s);  U(1,1) = GateType(c, 0.);
+                break;
+            case 'Y':
+                U(0,0) = GateType(c, 0.);   U(0,1) = GateType(-s, 0.);
+                U(1,0) = GateType(s, 0.);   U(1,1) = GateType(c, 0.);
+                break;
+            default:
+                U(0,0) = GateType(c, -s);   U(0,1) = GateType(0., 0.);
+                U(1,0) = GateType(0., 0.);  U(1,1) = GateType(c, s);
+                break;
+        }
+        return U;
+    }
+
     /**
      * @brief Apply the given controlled unitary gate on target qubit
      * 
@@ -423,13 +717,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCU(const TMDP& U, CST control, CST target, std::string label="U"){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyControlled1QubitGate(control, target, U);
+        if(!applyClassicalGate(U, target, control) && !scheduleGate(U, qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyControlled1QubitGate(qubit_map[control], qubit_map[target], stateMatrix(U));
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( label, U.tostr(), control, target );
+        this->writer.twoQubitGateCall( label, U.tostr(), control, target );
         #endif
     }
 
@@ -441,13 +738,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCX(CST control, CST target){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCPauliX(control, target);
+        if(!applyClassicalGate(getGateX(), target, control) && !scheduleGate(getGateX(), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCPauliX(qubit_map[control], qubit_map[target]);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "X", getGateX().tostr(), control, target );
+        this->writer.twoQubitGateCall( "X", getGateX().tostr(), control, target );
         #endif
     }
 
@@ -459,13 +759,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCY(CST control, CST target){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCPauliY(control, target);
+        if(!applyClassicalGate(getGateY(), target, control) && !scheduleGate(getGateY(), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCPauliY(qubit_map[control], qubit_map[target]);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "Y", getGateY().tostr(), control, target );
+        this->writer.twoQubitGateCall( "Y", getGateY().tostr(), control, target );
         #endif
     }
 
@@ -477,13 +780,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCZ(CST control, CST target){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCPauliZ(control, target);
+        if(!applyClassicalGate(getGateZ(), target, control) && !scheduleGate(getGateZ(), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCPauliZ(qubit_map[control], qubit_map[target]);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "Z", getGateZ().tostr(), control, target );
+        this->writer.twoQubitGateCall( "Z", getGateZ().tostr(), control, target );
         #endif
     }
 
@@ -495,13 +801,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCH(CST control, CST target){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCHadamard(control, target);
+        if(!applyClassicalGate(getGateH(), target, control) && !scheduleGate(getGateH(), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCHadamard(qubit_map[control], qubit_map[target]);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "H", getGateH().tostr(), control, target );
+        this->writer.twoQubitGateCall( "H", getGateH().tostr(), control, target );
         #endif
     }
 
@@ -514,16 +823,19 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCPhaseShift(double angle, unsigned int control, unsigned int target){
         TMDP U(gates[3]);
-        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+        U(1, 1) = GateType(cos(angle), sin(angle));
 
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyControlled1QubitGate(control, target, U);
+        if(!applyClassicalGate(U, target, control) && !scheduleGate(U, qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyControlled1QubitGate(qubit_map[control], qubit_map[target], stateMatrix(U));
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "CPhase", U.tostr(), control, target );
+        this->writer.twoQubitGateCall( "CPhase", U.tostr(), control, target );
         #endif
     }
 
@@ -536,13 +848,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCRotX(CST control, CST target, const double theta){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCRotationX(control, target, theta);
+        if(!applyClassicalGate(getGateRotation('X', theta), target, control) && !scheduleGate(getGateRotation('X', theta), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCRotationX(qubit_map[control], qubit_map[target], theta);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "CR_X", getGateI().tostr(), control, target );
+        this->writer.twoQubitGateCall( "CR_X", getGateI().tostr(), control, target );
         #endif
     }
 
@@ -555,13 +870,16 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCRotY(CST control, CST target, double theta){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCRotationY(control, target, theta);
+        if(!applyClassicalGate(getGateRotation('Y', theta), target, control) && !scheduleGate(getGateRotation('Y', theta), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCRotationY(qubit_map[control], qubit_map[target], theta);
+        }
         #endif
 
         gate_count_2qubit++;
+        countTargetUsage(target);
 
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "CR_Y", getGateI().tostr(), control, target );
+        this->writer.twoQubitGateCall( "CR_Y", getGateI().tostr(), control, target );
         #endif
     }
 
@@ -574,47 +892,71 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      */
     inline void applyGateCRotZ(CST control, CST target, const double theta){
         #ifndef RESOURCE_ESTIMATE
-        qubitRegister.ApplyCRotationZ(control, target, theta);
+        if(!applyClassicalGate(getGateRotation('Z', theta), target, control) && !scheduleGate(getGateRotation('Z', theta), qubit_map[target], qubit_map[control])){
+            threadedRegister()->ApplyCRotationZ(qubit_map[control], qubit_map[target], theta);
+        }
         #endif
         
         gate_count_2qubit++;
+        countTargetUsage(target);
         
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "CR_Z", getGateI().tostr(), control, target );
+        this->writer.twoQubitGateCall( "CR_Z", getGateI().tostr(), control, target );
         #endif
     }
 
     /**
-     * @brief Swap the qubits at the given indices
+     * @brief Swap the qubits at the given indices. The swap is applied as a relabelling of the logical to physical qubit map, without moving any amplitudes, unless the register has been handed out by getQubitRegister, in which case the amplitudes are permuted.
      * 
      * @param qubit_idx0 Index of qubit 0 to swap &(0 -> 1)
      * @param qubit_idx1 Index of qubit 1 to swap &(1 -> 0)
      */
     inline void applyGateSwap(CST qubit_idx0, CST qubit_idx1){
-        qubitRegister.ApplySwap(qubit_idx0, qubit_idx1);
+        #ifndef RESOURCE_ESTIMATE
+        std::swap(qubit_map[qubit_idx0], qubit_map[qubit_idx1]);
+        std::swap(classical_bits[qubit_idx0], classical_bits[qubit_idx1]);
+        std::swap(flipped_bits[qubit_idx0], flipped_bits[qubit_idx1]);
+        keepRegisterCurrent();
+        #endif
         #ifdef GATE_LOGGING
-        writer.twoQubitGateCall( "SWAP", getGateI().tostr(), qubit_idx0, qubit_idx1 );
+        this->writer.twoQubitGateCall( "SWAP", getGateI().tostr(), qubit_idx0, qubit_idx1 );
         #endif
     }
 
     /**
-     * @brief Get the Qubit Register object
+     * @brief Get the Qubit Register object. The state is materialized first (see materializeState). As the reference may be written or held across later gates, every gate is applied to the register eagerly until the register is next initialised: classical tracking and gate scheduling are suspended, relabellings of the qubit map (e.g. swaps) are applied to the amplitudes, and the register is never replaced, so qubits may not be released. Explicitly enabling classical tracking or gate scheduling ends this early. To read the state without suspending them, use the const overload.
      * 
-     * @return QubitRegister<ComplexDP>& Returns a refernce to the Qubit Register object 
+     * @return QRDP& Returns a refernce to the Qubit Register object 
      */
-    inline QubitRegister<ComplexDP>& getQubitRegister() { 
-        return this->qubitRegister; 
+    inline QRDP& getQubitRegister() { 
+        materializeState();
+        // The register may be written through the reference, so no qubit remains tracked as classical
+        untrackQubits(allQubits());
+        register_exposed = true;
+        return *this->qubitRegister; 
     }
 
     /**
-     * @brief Get the Qubit Register object
+     * @brief Get the Qubit Register object to read the current state. The state is materialized first (see materializeState), which updates only the lazily held state of the simulator; classical tracking and gate scheduling continue, so the reference is not kept current by later gates.
      * 
-     * @return const QubitRegister<ComplexDP>& Returns a refernce to the Qubit Register object  
+     * @return const QRDP& Returns a refernce to the Qubit Register object  
      */
-    inline const QubitRegister<ComplexDP>& getQubitRegister() const { 
-        return this->qubitRegister; 
+    inline const QRDP& getQubitRegister() const { 
+        // Only the mutable lazy state is updated, so the state observed through the simulator is unchanged
+        const_cast<IntelSimulatorT*>(this)->materializeState();
+        return *this->qubitRegister; 
     };
 
+    /**
+     * @brief Apply all operations held lazily to the register, such that it holds the complex amplitudes of the state indexed by the logical qubits: real amplitudes are promoted, deferred X gates and scheduled gates are applied, released qubits are allocated and the qubit map is materialized. Tracked classical qubits keep their values.
+     */
+    void materializeState(){
+        promoteToComplex();
+        applyDeferredFlips(allQubits());
+        flushScheduledGates();
+        materializeQubitMap();
+    }
+
     /**
      * @brief Get the number of Qubits
      * 
@@ -629,10 +971,32 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * 
      */
     void initRegister(){
-        this->qubitRegister.Initialize("base",0);
+        register_exposed = false;
+        scheduled_gates.clear();
+        bytes_moved = 0;
+        num_state_gates = 0;
+        // Restore the qubits factored out by releaseQubit
+        if(getNumPhysicalQubits() != numQubits){
+            replaceRegister(acquireRegister(real_amplitudes ? numQubits - 1 : numQubits));
+        }
+        this->threadedRegister()->Initialize("base",0);
+        resetQubitMap();
+        resetClassicalBits();
         this->initCaches();
         gate_count_1qubit = 0;
         gate_count_2qubit = 0;
+        std::fill(target_usage.begin(), target_usage.end(), 0);
+    }
+
+    /**
+     * @brief (Re)Initialise the register to |0....0>, and restart the measurement random stream at the given seed and shot; see setRandomSeed
+     *
+     * @param seed Seed of the stream
+     * @param shot Index of the stream under the seed
+     */
+    void initRegister(std::uint64_t seed, std::uint64_t shot=0){
+        initRegister();
+        setRandomSeed(seed, shot);
     }
 
     /**
@@ -640,7 +1004,28 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * 
      */
     inline void applyAmplitudeNorm(){
-        this->qubitRegister.Normalize();
+        const ThreadScope scope = threadScope();
+        flushScheduledGates();
+        // Real amplitudes and mixed precision states are normalized here, accumulating in double precision
+        if(real_amplitudes || !std::is_same<Type, GateType>::value){
+            RealType* state = realState();
+            const std::size_t num_reals = 2 * qubitRegister->LocalSize();
+            double norm = 0.;
+            #pragma omp parallel for simd num_threads(numThreads()) schedule(static) reduction(+:norm)
+            for(std::size_t i = 0; i < num_reals; i++){
+                norm += static_cast<double>(state[i])*state[i];
+            }
+            #ifdef ENABLE_MPI
+            MPI_Allreduce(MPI_IN_PLACE, &norm, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            #endif
+            const double scale = 1. / std::sqrt(norm);
+            #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+            for(std::size_t i = 0; i < num_reals; i++){
+                state[i] *= scale;
+            }
+            return;
+        }
+        this->threadedRegister()->Normalize();
     }
 
     /**
@@ -651,18 +1036,14 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param normalize Optional argument specifying whether amplitudes should be normalized (true) or not (false). Default value is true.
      */
     bool applyMeasurement(CST target, bool normalize=true){
-        double rand;
+        // Drawn identically on every rank, from the same stream position
+        const double rand = rng.uniform();
         bool bit_val;
 
-        #ifdef ENABLE_MPI
-            if(rank == 0){
-                rand = dist(mt);
-            }
-            MPI_Bcast(&rand, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-            MPI_Barrier(MPI_COMM_WORLD);
-        #else
-            rand = dist(mt);
-        #endif
+        // A classical qubit is measured with certainty; the draw above keeps the random stream independent of the tracking
+        if(classical_bits[target] != quantum_bit){
+            return classical_bits[target];
+        }
         collapseQubit(target, (bit_val = ( rand < getStateProbability(target) ) ) );
         if(normalize){
             applyAmplitudeNorm();
@@ -670,6 +1051,25 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
         return bit_val;
     }
 
+    /**
+     * @brief Seed the random stream used by measurements, making subsequent measurement outcomes reproducible. Measurement d after seeding draws the Philox counter-based number of (seed, shot, d), so shots of the same seed are independent streams that need no state between them.
+     *
+     * @param seed Seed of the stream
+     * @param shot Index of the stream under the seed
+     */
+    void setRandomSeed(std::uint64_t seed, std::uint64_t shot=0){
+        rng.seed(seed, shot);
+    }
+
+    /**
+     * @brief Get the seed of the measurement random stream, as given to the constructor or setRandomSeed or drawn from the system entropy source
+     *
+     * @return std::uint64_t Seed of the stream
+     */
+    std::uint64_t getRandomSeed() const {
+        return rng.getSeed();
+    }
+
     /**
      * @brief Apply measurement to a target qubit with respect to the Z-basis, collapsing to a specified value (0 or 1). Amplitudes are r-normalized afterwards. 
      * 
@@ -677,10 +1077,210 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param collapseValue The value that the register will be collapsed to (either 0 ro 1).
      */
     void collapseToBasisZ(CST target, bool collapseValue){
+        if(classical_bits[target] == static_cast<int>(collapseValue)){
+            return;
+        }
         collapseQubit(target, collapseValue);
         applyAmplitudeNorm();
     }
 
+    /**
+     * @brief Reset the target qubit to |0> as the H gate followed by collapsing the qubit to 0, in one pass folding each amplitude pair (a0 -> a0 + a1, a1 -> 0) and accumulating the norm, and a second pass renormalizing the remaining half of the amplitudes. A distributed target is first relabelled onto a local qubit.
+     *
+     * @param target The index of the qubit being reset
+     */
+    void applyReset(CST target){
+        gate_count_1qubit++;
+        countTargetUsage(target);
+        #ifndef RESOURCE_ESTIMATE
+        // A classical qubit is reset by its tracked value alone, deferring an X gate if it was set
+        if(classical_bits[target] != quantum_bit){
+            flipped_bits[target] ^= classical_bits[target];
+            classical_bits[target] = 0;
+            return;
+        }
+        flushScheduledGates();
+        makeQubitsLocal({target});
+        const std::size_t p = qubit_map[target];
+        double norm = real_amplitudes ? foldPairs(realState(), p) : foldPairs(&(*qubitRegister)[0], p);
+        #ifdef ENABLE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &norm, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        #endif
+        const double scale = 1. / std::sqrt(norm);
+        if(real_amplitudes){
+            scalePairs(realState(), p, scale);
+        }
+        else{
+            scalePairs(&(*qubitRegister)[0], p, scale);
+        }
+        num_state_gates++;
+        classical_bits[target] = isTrackingClassicalBits() ? 0 : quantum_bit;
+        keepRegisterCurrent();
+        #endif
+    }
+
+    /**
+     * @brief Release the target qubit, which must be in the state |0> (e.g. following resetQubit), factoring it out of the state-vector: the amplitudes with the qubit unset are gathered into a register of one fewer qubit, halving the memory of the state. Physical qubits above the released one are relabelled down by one. No gates may be applied to the qubit until it is allocated again; the qubit map and register are restored to all qubits by materializeQubitMap or initRegister. A state snapshot may not be held, nor may the register have been handed out by getQubitRegister.
+     *
+     * @param target The index of the qubit being released
+     */
+    void releaseQubit(CST target){
+        assert(!isQubitReleased(target));
+        assert(classical_bits[target] != 1);
+        assert(state_snapshot.empty());
+        assert(!register_exposed);
+        flushScheduledGates();
+        makeQubitsLocal({target});
+        assert(getNumLocalQubits() > 1);
+        // A real state packs two amplitudes to an element, so needs two local qubits after the release
+        if(real_amplitudes && qubitRegister->NumQubits() < 2){
+            promoteToComplex();
+        }
+        const std::size_t p = qubit_map[target];
+        // The state-vector holds the qubit at 1 if an X gate is deferred
+        const std::size_t bit = flipped_bits[target];
+
+        std::unique_ptr<QRDP> released_register = acquireRegister(qubitRegister->NumQubits() - 1);
+        if(real_amplitudes){
+            gatherPairs(realState(), reinterpret_cast<RealType*>(&(*released_register)[0]), p, bit);
+        }
+        else{
+            gatherPairs(&(*qubitRegister)[0], &(*released_register)[0], p, bit);
+        }
+        replaceRegister(std::move(released_register));
+
+        qubit_map[target] = released_qubit;
+        classical_bits[target] = isTrackingClassicalBits() ? 0 : quantum_bit;
+        flipped_bits[target] = 0;
+        for(auto& phys : qubit_map){
+            if(phys != released_qubit && phys > p){
+                phys--;
+            }
+        }
+    }
+
+    /**
+     * @brief Allocate the released target qubit in the state |0>, doubling the memory of the state. The qubit is added as the highest local physical qubit, so the current amplitudes are copied into the lower half of the new local state-vector and the upper half is zeroed; distributed qubits are relabelled up by one.
+     *
+     * @param target The index of the qubit being allocated
+     */
+    void allocateQubit(CST target){
+        const ThreadScope scope = threadScope();
+        assert(isQubitReleased(target));
+        assert(state_snapshot.empty());
+        flushScheduledGates();
+        const std::size_t p = getNumLocalQubits();
+
+        std::unique_ptr<QRDP> allocated_register = acquireRegister(qubitRegister->NumQubits() + 1);
+        // Complex amplitudes are interleaved reals, so either state is copied as reals
+        const std::size_t num_reals = 2 * qubitRegister->LocalSize();
+        const RealType* state = realState();
+        RealType* allocated_state = reinterpret_cast<RealType*>(&(*allocated_register)[0]);
+        #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < num_reals; i++){
+            allocated_state[i] = state[i];
+            allocated_state[num_reals + i] = 0.;
+        }
+        replaceRegister(std::move(allocated_register));
+
+        for(auto& phys : qubit_map){
+            if(phys != released_qubit && phys >= p){
+                phys++;
+            }
+        }
+        qubit_map[target] = p;
+        classical_bits[target] = isTrackingClassicalBits() ? 0 : quantum_bit;
+        flipped_bits[target] = 0;
+    }
+
+    /**
+     * @brief Allocate the lowest-indexed released qubit in the state |0>
+     *
+     * @return std::size_t The index of the allocated qubit
+     */
+    std::size_t allocateQubit(){
+        const std::size_t target = std::find(qubit_map.begin(), qubit_map.end(), released_qubit) - qubit_map.begin();
+        assert(target < numQubits);
+        allocateQubit(target);
+        return target;
+    }
+
+    /**
+     * @brief Check whether the target qubit has been released by releaseQubit
+     */
+    bool isQubitReleased(CST target) const {
+        return qubit_map[target] == released_qubit;
+    }
+
+    /**
+     * @brief Get the number of qubits held in the state-vector, being the number of qubits less those released
+     */
+    std::size_t getNumPhysicalQubits() const {
+        return real_amplitudes ? qubitRegister->NumQubits() + 1 : qubitRegister->NumQubits();
+    }
+
+    /**
+     * @brief Check whether the target qubit is tracked as classical, being in a computational basis state known without reading the state-vector
+     */
+    bool isClassicalQubit(CST target) const {
+        return classical_bits[target] != quantum_bit;
+    }
+
+    /**
+     * @brief Enable or disable the tracking of classical qubits. Gates acting on classical qubits only update their tracked values, deferring X gates until the qubit becomes quantum, and controlled gates with classical controls are skipped or applied uncontrolled. Tracking is enabled by default; once (re-)enabled, qubits are tracked from the next initialisation, reset or measurement. Enabling tracking also ends the eager application of gates following a call to getQubitRegister.
+     * 
+     * @param enable Whether classical qubits are tracked
+     */
+    void setClassicalTracking(bool enable){
+        #ifndef RESOURCE_ESTIMATE
+        applyDeferredFlips(allQubits());
+        #endif
+        classical_tracking = enable;
+        if(enable){
+            register_exposed = false;
+        }
+        std::fill(classical_bits.begin(), classical_bits.end(), quantum_bit);
+    }
+
+    /**
+     * @brief Get the probability of the specified qubit being in the state |1>
+     * 
+     * @param target Target qubit 
+     * @return double Probability that the target qubit is in the state |1>
+     */
+    inline double getStateProbability(CST target){
+        const ThreadScope scope = threadScope();
+        // A released qubit is in the state |0>
+        if(isQubitReleased(target)){
+            return 0.;
+        }
+        if(classical_bits[target] != quantum_bit){
+            return classical_bits[target];
+        }
+        flushScheduledGates();
+        if(real_amplitudes){
+            const RealType* state = realState();
+            const std::size_t num_local_qubits = getNumLocalQubits();
+            const std::size_t local_size = 0b1UL << num_local_qubits;
+            const std::size_t mask = 0b1UL << qubit_map[target];
+            // Amplitudes of a distributed target are either all set or all unset on this rank
+            std::size_t global_offset = 0;
+            #ifdef ENABLE_MPI
+            global_offset = static_cast<std::size_t>(rank) << num_local_qubits;
+            #endif
+            double probability = 0.;
+            #pragma omp parallel for simd num_threads(numThreads()) schedule(static) reduction(+:probability)
+            for(std::size_t i = 0; i < local_size; i++){
+                probability += ((global_offset | i) & mask) ? state[i]*state[i] : 0.;
+            }
+            #ifdef ENABLE_MPI
+            MPI_Allreduce(MPI_IN_PLACE, &probability, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            #endif
+            return probability;
+        }
+        return threadedRegister()->GetProbability(qubit_map[target]);
+    }
+
     /**
      * @brief Prints the string x and then for each state of the specified qubits in the superposition, prints each its amplitude, followed by state and then by the probability of that state. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience and debugging/testing. 
      * 
@@ -688,7 +1288,11 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @param qubits Indices of qubits in register to be printed
      */
     inline void PrintStates(std::string x, std::vector<std::size_t> qubits = {}){
-        qubitRegister.Print(x,qubits);
+        promoteToComplex();
+        applyDeferredFlips(allQubits());
+        flushScheduledGates();
+        materializeQubitMap();
+        qubitRegister->Print(x,qubits);
     }
 
     #ifdef GATE_LOGGING
@@ -698,7 +1302,7 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
      * @return GateWriter& Returns reference to the writer member in the class 
      */
     GateWriter& getGateWriter(){
-        return writer;
+        return this->writer;
     } 
     #endif
 
@@ -716,60 +1320,1930 @@ class IntelSimulator : public SimulatorGeneral<IntelSimulator> {
     }
 
     /**
-     * @brief Compute overlap between different simulators. 
-     * Number of qubits must be the same
-     *
+     * @brief Check if the state is held with real amplitudes
      */
-    inline complex<double> overlap( IntelSimulator &sim){
-        if(sim.uid != this->uid){
-            return qubitRegister.ComputeOverlap(sim.qubitRegister);
+    bool isRealAmplitudes() const {
+        return real_amplitudes;
+    }
+
+    /**
+     * @brief Promote a state held with real amplitudes to complex amplitudes, allocating the full complex register. This is done when a gate with a complex matrix, or an operation without a real kernel, is applied; the state then remains complex. No-op if the state is already complex.
+     */
+    void promoteToComplex(){
+        const ThreadScope scope = threadScope();
+        if(!real_amplitudes){
+            return;
         }
-        else{
-            return std::numeric_limits<double>::quiet_NaN();
+        #ifndef RESOURCE_ESTIMATE
+        std::unique_ptr<QRDP> complex_register = acquireRegister(getNumPhysicalQubits());
+        const RealType* state = realState();
+        Type* complex_state = &(*complex_register)[0];
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < complex_register->LocalSize(); i++){
+            complex_state[i] = Type(state[i], 0.);
         }
+        replaceRegister(std::move(complex_register));
+        #endif
+        real_amplitudes = false;
     }
 
-    private:
-    //inline static std::size_t suid = 0; //works in C++17.
-    const std::size_t uid;
+    /**
+     * @brief Get the number of gates applied with each qubit as target since the register was (re)initialised. These are counted in resource estimation builds also, and may be passed to QubitLayout to choose a qubit layout.
+     * 
+     * @return const std::vector<std::size_t>& Number of gates targeting each qubit index
+     */
+    const std::vector<std::size_t>& getQubitUsage() const {
+        return target_usage;
+    }
 
-    std::size_t numQubits = 0;
-    QRDP qubitRegister;
-    std::vector<TMDP> gates;
-    #ifdef ENABLE_MPI
-        int rank;
-    #endif
+    /**
+     * @brief Enable cache-blocked gate scheduling. Single and controlled gates acting only on the lowest block_qubits (physical) qubits are queued rather than applied; the queue is applied tile by tile over blocks of 2^block_qubits amplitudes, which stay in cache while every queued gate is applied, so a run of gates streams the state-vector from memory once. A gate acting on higher qubits is applied immediately, ahead of the queue, if its qubits are disjoint from those of every queued gate (the gates commute); otherwise the queue is applied first. The queue is also applied before any measurement, native kernel, or export of the state. A block of 2^14 amplitudes (256 KiB) suits a typical L2 cache.
+     * 
+     * @param block_qubits Number of qubits per block; 0 disables scheduling (default). Enabling scheduling also ends the eager application of gates following a call to getQubitRegister.
+     */
+    void setGateBlockQubits(std::size_t block_qubits){
+        flushScheduledGates();
+        gate_block_qubits = block_qubits;
+        if(block_qubits > 0){
+            register_exposed = false;
+        }
+    }
 
-    std::size_t gate_count_1qubit;
-    std::size_t gate_count_2qubit;
+    /**
+     * @brief Get the effective placement of the simulator: the number of OpenMP threads, the CPU each runs on, and the bytes of the local state-vector resident on each NUMA node
+     */
+    PlacementInfo getPlacement(){
+        const ThreadScope scope = threadScope();
+        PlacementInfo info;
+        info.num_threads = numThreads();
+        info.thread_cpus = getThreadCpus();
+        info.node_bytes = getNodeBytes(&(*qubitRegister)[0], sizeof(Type) * qubitRegister->LocalSize());
+        return info;
+    }
 
-    std::random_device rd; 
-    std::mt19937 mt;
-    std::uniform_real_distribution<double> dist;
+    /**
+     * @brief Get the average number of bytes of the (local) state-vector read and written per gate applied since the register was (re)initialised. Each pass over the state-vector reads and writes it once; without scheduling this is one pass per gate.
+     * 
+     * @return double Bytes moved per gate
+     */
+    double getBytesMovedPerGate(){
+        flushScheduledGates();
+        return (num_state_gates > 0) ? static_cast<double>(bytes_moved) / num_state_gates : 0.;
+    }
 
+    /**
+     * @brief Compute overlap between different simulators. 
+     * Number of qubits must be the same. The state of sim is first permuted to the qubit map of this simulator.
+     *
+     */
+    inline complex<double> overlap( IntelSimulatorT &sim){
+        if(sim.uid != this->uid){
+            promoteToComplex();
+            sim.promoteToComplex();
+            applyDeferredFlips(allQubits());
+            sim.applyDeferredFlips(sim.allQubits());
+            flushScheduledGates();
+            sim.flushScheduledGates();
+            allocateReleasedQubits();
+            sim.allocateReleasedQubits();
+            if(sim.register_exposed){
+                materializeQubitMap();
+            }
+            sim.remapQubits(qubit_map);
+            return threadedRegister()->ComputeOverlap(*sim.qubitRegister);
+        }
+        else{
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+    }
 
-    // Measurement methods
     /**
-     * @brief Collapses specified qubit in register to the collapseValue without applying normalization.
+     * @brief Apply a classical reversible function to the sub-register defined by the given qubits as a single pass over the state-vector. Sub-registers of up to max_perm_table_qubits qubits are permuted block-wise using precomputed offset tables; larger sub-registers are permuted out-of-place. If any of the qubits are distributed across MPI ranks, amplitudes are exchanged using an all-to-all communication. A sub-register of classical qubits is permuted by its tracked value, without a pass over the state-vector.
      * 
-     * @param target Index of qubit to be collapsed 
-     * @param collapseValue Value qubit is collapsed to (0 or 1)
+     * @tparam PermFunc Callable type mapping std::size_t -> std::size_t
+     * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of the sub-register value
+     * @param perm Bijection over the sub-register values [0, 2^qubits.size())
+     * @param decomposition Gate sequence implementing the permutation, counted in the gate counts and qubit usage in place of the single pass
      */
-    inline void collapseQubit(CST target, bool collapseValue){
-        qubitRegister.CollapseQubit(target, collapseValue);
+    template<class PermFunc>
+    void applyRegisterPermutation(const std::vector<std::size_t>& qubits, PermFunc perm, const OpBuffer& decomposition = OpBuffer()){
+        countOps(decomposition.data(), decomposition.size());
+        if(std::all_of(qubits.begin(), qubits.end(), [this](std::size_t q){ return classical_bits[q] != quantum_bit; })){
+            std::size_t val = 0;
+            for(std::size_t i = 0; i < qubits.size(); i++){
+                val |= static_cast<std::size_t>(classical_bits[qubits[i]]) << i;
+            }
+            setClassicalValue(qubits, perm(val));
+            return;
+        }
+        // Deferred X gates of classical qubits are folded into the permutation
+        const std::size_t flips = untrackQubits(qubits);
+        applyPhysicalPermutation(physicalQubits(qubits), [&perm, flips](std::size_t val){ return perm(val ^ flips); });
     }
 
     /**
-     * @brief Get the probability of the specified qubit being in the state |1>
+     * @brief Get the logical to physical qubit map; logical qubit q is held at bit getQubitMap()[q] of the state-vector index.
      * 
-     * @param target Target qubit 
-     * @return double Probability that the target qubit is in the state |1>
+     * @return const std::vector<std::size_t>& The qubit map
      */
-    inline double getStateProbability(CST target){
-        return qubitRegister.GetProbability(target);
+    const std::vector<std::size_t>& getQubitMap() const {
+        return qubit_map;
     }
 
+    /**
+     * @brief Permute the state-vector such that each logical qubit is held at the physical qubit of the same index, and reset the qubit map to the identity. This is a single pass over the state-vector (an all-to-all exchange if distributed qubits are moved), and is a no-op if the map is already the identity.
+     * 
+     */
+    void materializeQubitMap(){
+        allocateReleasedQubits();
+        std::vector<std::size_t> identity(numQubits);
+        std::iota(identity.begin(), identity.end(), 0);
+        remapQubits(identity);
+    }
+
+    /**
+     * @brief Apply the reflection about the uniform superposition of the sub-register defined by the given qubits, I - 2|s><s|, which is the operator implemented by the Grover diffusion gate sequence (equal to 2|s><s| - I up to a global phase). For each configuration of the remaining qubits, the first pass computes the mean amplitude over the sub-register, and the second pass applies a -> a - 2*mean. If any of the qubits are distributed across MPI ranks, the partial means are summed over the ranks sharing the remaining qubit configurations. The gates of the diffusion sequence are counted, with the last qubit as the target of its NCU(Z).
+     * 
+     * @param logical_qubits Indices of the qubits forming the sub-register
+     */
+    void applyUniformReflection(const std::vector<std::size_t>& logical_qubits){
+        // Counted as the diffusion gate sequence: H and X on each qubit before and after the NCU(Z)
+        gate_count_1qubit += 4 * logical_qubits.size();
+        for(auto q : logical_qubits){
+            countTargetUsage(q, 4);
+        }
+        countNCUDecomposition(std::vector<std::size_t>(logical_qubits.begin(), logical_qubits.end() - 1), logical_qubits.back());
+
+        const ThreadScope scope = threadScope();
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        applyDeferredFlips(logical_qubits);
+        untrackQubits(logical_qubits);
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        const std::vector<std::size_t> qubits = physicalQubits(logical_qubits);
+        flushScheduledGates();
+
+        // Local mask of the sub-register
+        std::size_t reg_mask = 0;
+        std::size_t num_reg_local = 1;
+        #ifdef ENABLE_MPI
+        std::size_t rank_mask = 0;
+        #endif
+        for(auto q : qubits){
+            if(q < num_local_qubits){
+                reg_mask |= 0b1UL << q;
+                num_reg_local <<= 1;
+            }
+            #ifdef ENABLE_MPI
+            else {
+                rank_mask |= 0b1UL << (q - num_local_qubits);
+            }
+            #else
+            assert(q < num_local_qubits);
+            #endif
+        }
+
+        std::vector<std::size_t> reg_qubits, rest_qubits;
+        for(std::size_t q = 0; q < num_local_qubits; q++){
+            if(IS_SET(reg_mask, q)){
+                reg_qubits.push_back(q);
+            }
+            else{
+                rest_qubits.push_back(q);
+            }
+        }
+        const std::size_t num_rest = 0b1UL << rest_qubits.size();
+        const std::size_t chunk = std::min(num_reg_local, static_cast<std::size_t>(4096));
+        const std::size_t num_chunks = num_reg_local / chunk;
+        const double scale = 2.0 / static_cast<double>(0b1UL << qubits.size());
+
+        #ifdef ENABLE_MPI
+        // Ranks differing only in the distributed sub-register qubits share the remaining configurations
+        const MPI_Comm reflect_comm = (rank_mask != 0) ? reflectionComm(rank_mask) : MPI_COMM_NULL;
+        #endif
+
+        // The remaining configurations are reflected in batches, bounding the memory held for the means and the size of each reduction
+        Type* state = &(*qubitRegister)[0];
+        const std::size_t batch = std::min(num_rest, max_reflection_batch);
+        std::vector<ComplexDP> mean(batch);
+        for(std::size_t b0 = 0; b0 < num_rest; b0 += batch){
+            // Pass 1: sum the sub-register amplitudes for each remaining configuration
+            if(num_rest >= num_reg_local){
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(std::size_t b = 0; b < batch; b++){
+                    const std::size_t base = depositBits(b0 + b, rest_qubits);
+                    ComplexDP sum(0.,0.);
+                    std::size_t v = 0;
+                    do {
+                        sum += state[base | v];
+                        v = (v - reg_mask) & reg_mask;
+                    } while(v != 0);
+                    mean[b] = sum;
+                }
+            }
+            else{
+                // Few large blocks: split each block into chunks, stepping through the subsets of reg_mask
+                for(std::size_t b = 0; b < batch; b++){
+                    const std::size_t base = depositBits(b0 + b, rest_qubits);
+                    double sum_re = 0., sum_im = 0.;
+                    #pragma omp parallel for num_threads(numThreads()) schedule(static) reduction(+:sum_re,sum_im)
+                    for(std::size_t c = 0; c < num_chunks; c++){
+                        std::size_t v = depositBits(c*chunk, reg_qubits);
+                        for(std::size_t j = 0; j < chunk; j++){
+                            sum_re += state[base | v].real();
+                            sum_im += state[base | v].imag();
+                            v = (v - reg_mask) & reg_mask;
+                        }
+                    }
+                    mean[b] = ComplexDP(sum_re, sum_im);
+                }
+            }
+
+            #ifdef ENABLE_MPI
+            if(rank_mask != 0){
+                MPI_Allreduce(MPI_IN_PLACE, mean.data(), static_cast<int>(2*batch), MPI_DOUBLE, MPI_SUM, reflect_comm);
+            }
+            #endif
+
+            for(auto& m : mean){
+                m *= scale;
+            }
+
+            // Pass 2: a -> a - 2*mean
+            if(num_rest >= num_reg_local){
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(std::size_t b = 0; b < batch; b++){
+                    const std::size_t base = depositBits(b0 + b, rest_qubits);
+                    std::size_t v = 0;
+                    do {
+                        state[base | v] -= mean[b];
+                        v = (v - reg_mask) & reg_mask;
+                    } while(v != 0);
+                }
+            }
+            else{
+                for(std::size_t b = 0; b < batch; b++){
+                    const std::size_t base = depositBits(b0 + b, rest_qubits);
+                    const ComplexDP m = mean[b];
+                    #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                    for(std::size_t c = 0; c < num_chunks; c++){
+                        std::size_t v = depositBits(c*chunk, reg_qubits);
+                        for(std::size_t j = 0; j < chunk; j++){
+                            state[base | v] -= m;
+                            v = (v - reg_mask) & reg_mask;
+                        }
+                    }
+                }
+            }
+        }
+        #endif
+    }
+
+    /**
+     * @brief Negate the amplitudes of all basis states for which the sub-register defined by the given qubits matches any of the given patterns, as a single pass over the state-vector. Patterns are treated as a set: bits above qubits.size() are ignored and duplicates are marked once. The gates of the phase oracle sequence are counted for each pattern, with the last qubit as the target of its NCU(Z).
+     *
+     * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of each pattern
+     * @param patterns Sub-register values to mark
+     */
+    void applyPatternPhaseFlip(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns){
+        // Counted as the phase oracle gate sequence: X on each unset bit of the pattern before and after the NCU(Z)
+        const std::size_t mask = (qubits.size() < 64) ? (0b1UL << qubits.size()) - 1 : ~0UL;
+        std::vector<std::size_t> unique_patterns;
+        for(auto pattern : patterns){
+            unique_patterns.push_back(pattern & mask);
+        }
+        std::sort(unique_patterns.begin(), unique_patterns.end());
+        unique_patterns.erase(std::unique(unique_patterns.begin(), unique_patterns.end()), unique_patterns.end());
+        const std::vector<std::size_t> ctrls(qubits.begin(), qubits.end() - 1);
+        for(auto pattern : unique_patterns){
+            for(std::size_t i = 0; i < qubits.size(); i++){
+                if(!IS_SET(pattern, i)){
+                    gate_count_1qubit += 2;
+                    countTargetUsage(qubits[i], 2);
+                }
+            }
+            countNCUDecomposition(ctrls, qubits.back());
+        }
+
+        #ifndef RESOURCE_ESTIMATE
+        reduceMarkedAmplitudes(physicalQubits(qubits), storedPatterns(qubits, patterns), [](Type& a){ a = -a; return 0.; });
+        #endif
+    }
+
+    /**
+     * @brief Get the probability of the sub-register defined by the given qubits matching any of the given patterns. Patterns are treated as a set, as for applyPatternPhaseFlip. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience.
+     *
+     * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of each pattern
+     * @param patterns Sub-register values to match
+     * @return double Probability of measuring the sub-register in any of the given patterns
+     */
+    double getPatternProbability(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns){
+        double probability = 0.;
+        #ifndef RESOURCE_ESTIMATE
+        probability = reduceMarkedAmplitudes(physicalQubits(qubits), storedPatterns(qubits, patterns), [](Type& a){ return std::norm(a); });
+        #ifdef ENABLE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &probability, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        #endif
+        #endif
+        return probability;
+    }
+
+    /**
+     * @brief Store a copy of the (local) state-vector. The stored state |psi> defines the reflection axis of applyStateReflection, allowing amplitude amplification about a prepared state without inverting its preparation circuit. Note, this doubles the memory required by the simulator until the snapshot is released.
+     * 
+     */
+    void storeStateSnapshot(){
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        applyDeferredFlips(allQubits());
+        flushScheduledGates();
+        const Type* state = &(*qubitRegister)[0];
+        state_snapshot.assign(state, state + qubitRegister->LocalSize());
+        snapshot_qubit_map = qubit_map;
+        snapshot_classical_bits = classical_bits;
+        #endif
+    }
+
+    /**
+     * @brief Overwrite the state-vector with the stored state snapshot
+     * 
+     */
+    void restoreStateSnapshot(){
+        #ifndef RESOURCE_ESTIMATE
+        assert(state_snapshot.size() == qubitRegister->LocalSize());
+        scheduled_gates.clear();
+        std::copy(state_snapshot.begin(), state_snapshot.end(), &(*qubitRegister)[0]);
+        qubit_map = snapshot_qubit_map;
+        classical_bits = snapshot_classical_bits;
+        std::fill(flipped_bits.begin(), flipped_bits.end(), 0);
+        if(register_exposed){
+            // The snapshot may have been stored with qubits tracked and relabelled
+            untrackQubits(allQubits());
+            materializeQubitMap();
+        }
+        #endif
+    }
+
+    /**
+     * @brief Release the memory held by the stored state snapshot
+     * 
+     */
+    void releaseStateSnapshot(){
+        StateBuffer().swap(state_snapshot);
+    }
+
+    /**
+     * @brief Apply the reflection about the stored state snapshot |psi>, I - 2|psi><psi|, as an overlap and an update pass over the state-vector. The state is first permuted to the qubit map of the snapshot if they differ. Under MPI the overlap is summed over all ranks.
+     * 
+     */
+    void applyStateReflection(){
+        const ThreadScope scope = threadScope();
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        assert(state_snapshot.size() == qubitRegister->LocalSize());
+        applyDeferredFlips(allQubits());
+        flushScheduledGates();
+        remapQubits(snapshot_qubit_map);
+
+        // A qubit remains classical only if it holds the same value in the snapshot
+        for(std::size_t q = 0; q < numQubits; q++){
+            if(classical_bits[q] != snapshot_classical_bits[q]){
+                classical_bits[q] = quantum_bit;
+            }
+        }
+
+        Type* state = &(*qubitRegister)[0];
+        const Type* psi = state_snapshot.data();
+        const std::size_t local_size = state_snapshot.size();
+
+        // Pass 1: <psi|state>
+        double ov_re = 0., ov_im = 0.;
+        #pragma omp parallel for num_threads(numThreads()) schedule(static) reduction(+:ov_re,ov_im)
+        for(std::size_t idx = 0; idx < local_size; idx++){
+            const Type c = std::conj(psi[idx]) * state[idx];
+            ov_re += c.real();
+            ov_im += c.imag();
+        }
+        double ov[2] = {ov_re, ov_im};
+
+        #ifdef ENABLE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, ov, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        #endif
+
+        // Pass 2: state -> state - 2<psi|state>|psi>
+        const Type scale(-2.*ov[0], -2.*ov[1]);
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t idx = 0; idx < local_size; idx++){
+            state[idx] += scale * psi[idx];
+        }
+        keepRegisterCurrent();
+        #endif
+    }
+
+    /**
+     * @brief Apply the quantum Fourier transform, |x> -> 2^(-n/2) sum_y exp(2 pi i xy/2^n) |y> (exp(-2 pi i xy/2^n) for the inverse), to the register index range [minIdx, maxIdx] as a batched radix-2 FFT over the state-vector. This is equivalent to the QFT gate sequence, including the final register inversion, and its gates are counted. If the range is not held by contiguous physical qubits, the qubit map is materialized first. If the range includes distributed qubits, it is first swapped onto the highest local qubits with an all-to-all exchange, and swapped back afterwards.
+     * 
+     * @param minIdx Lowest qubit index of the range
+     * @param maxIdx Highest qubit index of the range
+     * @param inverse Apply the inverse transform if true
+     */
+    void applyFourierTransform(std::size_t minIdx, std::size_t maxIdx, bool inverse=false){
+        // Counted as the exact QFT gate sequence: H on each qubit, and a controlled phase shift onto it from each lower qubit of the range. The register inversion relabels the qubit map, as applyGateSwap, so is not counted.
+        const std::size_t num_range = maxIdx - minIdx + 1;
+        gate_count_1qubit += num_range;
+        gate_count_2qubit += num_range * (num_range - 1) / 2;
+        for(std::size_t k = 0; k < num_range; k++){
+            countTargetUsage(minIdx + k, k + 1);
+        }
+
+        #ifndef RESOURCE_ESTIMATE
+        assert(minIdx <= maxIdx);
+        promoteToComplex();
+        std::vector<std::size_t> range(maxIdx - minIdx + 1);
+        std::iota(range.begin(), range.end(), minIdx);
+        applyDeferredFlips(range);
+        untrackQubits(range);
+        flushScheduledGates();
+
+        // The transform acts on a contiguous physical range; otherwise the qubit map is materialized first
+        for(std::size_t q = minIdx + 1; q <= maxIdx; q++){
+            if(qubit_map[q] != qubit_map[minIdx] + (q - minIdx)){
+                materializeQubitMap();
+                break;
+            }
+        }
+        maxIdx = qubit_map[minIdx] + (maxIdx - minIdx);
+        minIdx = qubit_map[minIdx];
+
+        #ifdef ENABLE_MPI
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        if(maxIdx >= num_local_qubits){
+            const std::size_t n = maxIdx - minIdx + 1;
+            assert(n <= num_local_qubits);
+            const std::size_t low = num_local_qubits - n;
+
+            // Qubits moved by the swap: the range, and the local qubits it is moved onto
+            std::vector<std::size_t> qubits;
+            for(std::size_t q = std::min(minIdx, low); q <= maxIdx; q++){
+                if(q >= minIdx || (q >= low && q < num_local_qubits)){
+                    qubits.push_back(q);
+                }
+            }
+            std::vector<std::size_t> vacated, displaced;
+            for(auto q : qubits){
+                if(q >= minIdx && (q < low || q >= num_local_qubits)){
+                    vacated.push_back(q);
+                }
+                else if(q < minIdx){
+                    displaced.push_back(q);
+                }
+            }
+
+            // Destination bit of each sub-register bit: range qubit minIdx+k -> low+k, displaced local qubits -> vacated range qubits
+            std::vector<std::size_t> dst_bit(qubits.size());
+            for(std::size_t i = 0; i < qubits.size(); i++){
+                std::size_t dst;
+                if(qubits[i] >= minIdx){
+                    dst = low + (qubits[i] - minIdx);
+                }
+                else{
+                    dst = vacated[std::find(displaced.begin(), displaced.end(), qubits[i]) - displaced.begin()];
+                }
+                dst_bit[i] = std::find(qubits.begin(), qubits.end(), dst) - qubits.begin();
+            }
+
+            applyPhysicalPermutation(qubits, [&dst_bit](std::size_t val){
+                std::size_t out = 0;
+                for(std::size_t i = 0; i < dst_bit.size(); i++){
+                    out |= ((val >> i) & 0b1UL) << dst_bit[i];
+                }
+                return out;
+            });
+            fourierLocal(low, num_local_qubits - 1, inverse);
+            applyPhysicalPermutation(qubits, [&dst_bit](std::size_t val){
+                std::size_t out = 0;
+                for(std::size_t i = 0; i < dst_bit.size(); i++){
+                    out |= ((val >> dst_bit[i]) & 0b1UL) << i;
+                }
+                return out;
+            });
+            return;
+        }
+        #else
+        assert(maxIdx < getNumLocalQubits());
+        #endif
+
+        fourierLocal(minIdx, maxIdx, inverse);
+        #endif
+    }
+
+    private:
+    //Largest sub-register for which the permutation offsets are tabulated
+    static constexpr std::size_t max_perm_table_qubits = 16;
+    //Largest number of qubits of a dense unitary gate
+    static constexpr std::size_t max_dense_gate_qubits = 5;
+    //Largest number of remaining qubit configurations reflected per batch by applyUniformReflection
+    static constexpr std::size_t max_reflection_batch = 0b1UL << 14;
+    //Largest number of amplitudes sent by a rank per all-to-all exchange of a distributed permutation
+    static constexpr std::size_t max_exchange_amplitudes = 0b1UL << 22;
+    //Largest number of columns of a Fourier transform batch gathered per buffer
+    static constexpr std::size_t max_fft_tile = 8;
+    //Largest sub-register for which matched patterns are held in a bitmap
+    static constexpr std::size_t max_pattern_bitmap_qubits = 24;
+    //Sub-register values per pattern below which only the matching amplitudes are visited
+    static constexpr std::size_t sparse_pattern_factor = 4;
+
+    //inline static std::size_t suid = 0; //works in C++17.
+    const std::size_t uid;
+
+    std::size_t numQubits = 0;
+    //Complex register, holding the packed real amplitudes in half as many complex ones if real_amplitudes. This and the other lazily held state (gate queue, qubit map and classical bits) are mutable, to be materialized by the const getQubitRegister
+    mutable std::unique_ptr<QRDP> qubitRegister;
+    mutable bool real_amplitudes;
+    bool use_fusion;
+    std::vector<TMDP> gates;
+    PlacementOptions placement;
+    #ifdef ENABLE_MPI
+        int rank;
+        //Communicators of the ranks sharing the remaining qubit configurations of applyUniformReflection, by the mask of the distributed sub-register qubits
+        std::map<std::size_t, MPI_Comm> reflect_comms;
+    #endif
+
+    std::size_t gate_count_1qubit;
+    std::size_t gate_count_2qubit;
+    //Number of gates targeting each (logical) qubit
+    std::vector<std::size_t> target_usage;
+
+    //Gate queued by the cache-blocked scheduler, on physical qubits
+    struct ScheduledGate {
+        GateType u00, u01, u10, u11;
+        std::size_t target;
+        std::size_t control_mask;
+    };
+    mutable std::vector<ScheduledGate> scheduled_gates;
+    std::size_t gate_block_qubits = 0;
+    mutable std::size_t bytes_moved = 0;
+    mutable std::size_t num_state_gates = 0;
+
+    //Physical qubit holding each logical qubit, or released_qubit if the qubit is factored out of the state
+    mutable std::vector<std::size_t> qubit_map;
+    static constexpr std::size_t released_qubit = std::numeric_limits<std::size_t>::max();
+
+    //Tracked value of each (logical) qubit in a computational basis state, or quantum_bit; flipped_bits marks classical qubits held in the state-vector with the opposite value, by a deferred X gate
+    mutable std::vector<int> classical_bits;
+    mutable std::vector<int> flipped_bits;
+    static constexpr int quantum_bit = -1;
+    bool classical_tracking = true;
+
+    //Set when the register is handed out by getQubitRegister, until the next initialisation; gates are then applied eagerly and the qubit map is held at the identity
+    bool register_exposed = false;
+
+    //Local amplitudes of the state stored by storeStateSnapshot, and the qubit map and classical bits they are held with
+    StateBuffer state_snapshot;
+    std::vector<std::size_t> snapshot_qubit_map;
+    std::vector<int> snapshot_classical_bits;
+
+    //Measurement random stream, keyed by (seed, shot, draw index)
+    PhiloxStream rng;
+
+
+    // Measurement methods
+    /**
+     * @brief Collapses specified qubit in register to the collapseValue without applying normalization.
+     * 
+     * @param target Index of qubit to be collapsed 
+     * @param collapseValue Value qubit is collapsed to (0 or 1)
+     */
+    inline void collapseQubit(CST target, bool collapseValue){
+        const ThreadScope scope = threadScope();
+        const bool stored_value = collapseValue ^ static_cast<bool>(flipped_bits[target]);
+        if(isTrackingClassicalBits()){
+            classical_bits[target] = collapseValue;
+        }
+        collapseValue = stored_value;
+        flushScheduledGates();
+        if(real_amplitudes){
+            RealType* state = realState();
+            const std::size_t num_local_qubits = getNumLocalQubits();
+            const std::size_t local_size = 0b1UL << num_local_qubits;
+            const std::size_t mask = 0b1UL << qubit_map[target];
+            const std::size_t keep = collapseValue ? mask : 0;
+            std::size_t global_offset = 0;
+            #ifdef ENABLE_MPI
+            global_offset = static_cast<std::size_t>(rank) << num_local_qubits;
+            #endif
+            #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+            for(std::size_t i = 0; i < local_size; i++){
+                state[i] = (((global_offset | i) & mask) == keep) ? state[i] : 0.;
+            }
+            return;
+        }
+        threadedRegister()->CollapseQubit(qubit_map[target], collapseValue);
+    }
+
+    /**
+     * @brief Count the given number of gates (default 1) targeting the given qubit. The counts grow with the largest index used, as resource estimation runs may address more qubits than are simulated.
+     */
+    inline void countTargetUsage(CST target, CST num_gates = 1){
+        if(target >= target_usage.size()){
+            target_usage.resize(target + 1, 0);
+        }
+        target_usage[target] += num_gates;
+    }
+
+    /**
+     * @brief Count the gates of the NCU decomposition without auxiliary qubits (see NCU::applyNQubitControl) of a gate on target controlled by ctrls, for the native kernels replacing it. For k controls the decomposition is CU(c_k-1,t), NCX(c_0..c_k-2; c_k-1), CU(c_k-1,t), NCX(c_0..c_k-2; c_k-1), NCU(c_0..c_k-2; t), with 3 controls decomposed directly into 13 gates. With no controls the gate is counted as a single qubit gate.
+     * 
+     * @param ctrls Control qubits
+     * @param target Target qubit
+     */
+    void countNCUDecomposition(const std::vector<std::size_t>& ctrls, CST target){
+        if(ctrls.empty()){
+            gate_count_1qubit++;
+            countTargetUsage(target);
+            return;
+        }
+        // Number of gates of the decomposition on k controls targeting each of c_0..c_k-1, t
+        std::vector<std::size_t> usage {0, 1};
+        for(std::size_t k = 2; k <= ctrls.size(); k++){
+            std::vector<std::size_t> next(k + 1, 0);
+            if(k == 3){
+                next = {0, 2, 4, 7};
+            }
+            else{
+                for(std::size_t i = 0; i + 1 < k; i++){
+                    next[i] = 3 * usage[i];
+                }
+                next[k-1] = 2 * usage[k-1];
+                next[k] = 2 + usage[k-1];
+            }
+            usage.swap(next);
+        }
+        for(std::size_t i = 0; i <= ctrls.size(); i++){
+            const std::size_t q = (i < ctrls.size()) ? ctrls[i] : target;
+            gate_count_2qubit += usage[i];
+            countTargetUsage(q, usage[i]);
+        }
+    }
+
+    /**
+     * @brief Count the gates of the 7 two-qubit gate CSwap decomposition (see applyGateCSwap) for the native kernels replacing it
+     * 
+     * @param qubit_swap0 Swap qubit 0
+     * @param qubit_swap1 Swap qubit 1
+     */
+    void countCSwapDecomposition(CST qubit_swap0, CST qubit_swap1){
+        gate_count_2qubit += 7;
+        for(auto q : {qubit_swap0, qubit_swap1, qubit_swap1, qubit_swap0, qubit_swap1, qubit_swap0, qubit_swap0}){
+            countTargetUsage(q);
+        }
+    }
+
+    /**
+     * @brief Count the given packed operations as applyOps would, without applying them, for the native kernels replacing them. Swaps are relabellings of the qubit map and so are not counted, as for applyGateSwap.
+     * 
+     * @param ops Pointer to the first operation
+     * @param num_ops Number of operations to count
+     */
+    void countOps(const Op* ops, std::size_t num_ops){
+        for(std::size_t i = 0; i < num_ops; i++){
+            const Op& op = ops[i];
+            const OpCode code = static_cast<OpCode>(op.code);
+            if(isSingleQubitGate(code) || code == OpCode::Reset){
+                gate_count_1qubit++;
+                countTargetUsage(op.q0);
+            }
+            else if(code == OpCode::SqrtSwap){
+                gate_count_2qubit++;
+                countTargetUsage(op.q0);
+                countTargetUsage(op.q1);
+            }
+            else if(code == OpCode::CCX){
+                countNCUDecomposition({op.q0, op.q1}, op.q2);
+            }
+            else if(code == OpCode::CSwap){
+                countCSwapDecomposition(op.q1, op.q2);
+            }
+            else if(code != OpCode::Swap){
+                gate_count_2qubit++;
+                countTargetUsage(op.q1);
+            }
+        }
+    }
+
+    /**
+     * @brief Get the gate U in the precision of the state, as taken by the underlying register
+     */
+    static inline decltype(auto) stateMatrix(const TMDP& U){
+        if constexpr (std::is_same<Type, GateType>::value){
+            return (U);
+        }
+        else{
+            qhipster::TinyMatrix<Type, 2, 2, 32> V;
+            for(std::size_t i = 0; i < 2; i++){
+                for(std::size_t j = 0; j < 2; j++){
+                    V(i,j) = Type(U(i,j));
+                }
+            }
+            return V;
+        }
+    }
+
+    /**
+     * @brief Get the matrix of the given single qubit gate operation
+     */
+    inline TMDP getOpGate(const Op& op){
+        switch(static_cast<OpCode>(op.code)){
+            case OpCode::X:             return getGateX();
+            case OpCode::Y:             return getGateY();
+            case OpCode::Z:             return getGateZ();
+            case OpCode::H:             return getGateH();
+            case OpCode::SqrtX:         return getGateSqrtX();
+            case OpCode::RotX:          return getGateRotation('X', op.param);
+            case OpCode::RotY:          return getGateRotation('Y', op.param);
+            case OpCode::RotZ:          return getGateRotation('Z', op.param);
+            case OpCode::PhaseShift:{
+                TMDP U(gates[3]);
+                U(1, 1) = GateType(cos(op.param), sin(op.param));
+                return U;
+            }
+            default:                    return getGateI();
+        }
+    }
+
+    /**
+     * @brief Get the product AB of the 2x2 matrices A and B
+     */
+    static inline TMDP matrixProduct(const TMDP& A, const TMDP& B){
+        TMDP C;
+        for(std::size_t i = 0; i < 2; i++){
+            for(std::size_t j = 0; j < 2; j++){
+                C(i,j) = A(i,0)*B(0,j) + A(i,1)*B(1,j);
+            }
+        }
+        return C;
+    }
+
+    // Real amplitudes
+    /**
+     * @brief Get the local state as reals: the real amplitudes packed into the storage of the complex register, or else the interleaved real and imaginary parts of the complex amplitudes
+     */
+    inline RealType* realState(){
+        return reinterpret_cast<RealType*>(&(*qubitRegister)[0]);
+    }
+
+    /**
+     * @brief Apply the gate U on the given physical target (and control) qubit to the real amplitudes, if U is real and the target is held locally. A distributed control is resolved by this rank's index bits.
+     * 
+     * @return true if the gate was applied, false if the state must be promoted to complex amplitudes to apply it
+     */
+    bool applyRealGate(const TMDP& U, CST target, CST control){
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        const bool is_real = U(0,0).imag() == 0. && U(0,1).imag() == 0. && U(1,0).imag() == 0. && U(1,1).imag() == 0.;
+        if(!is_real || target >= num_local_qubits){
+            return false;
+        }
+
+        std::size_t control_mask = 0;
+        if(control != std::numeric_limits<std::size_t>::max()){
+            if(control < num_local_qubits){
+                control_mask = 0b1UL << control;
+            }
+            #ifdef ENABLE_MPI
+            else if(! IS_SET(static_cast<std::size_t>(rank) << num_local_qubits, control)){
+                return true;
+            }
+            #endif
+        }
+
+        const ThreadScope scope = threadScope();
+        const GateRealType u00 = U(0,0).real(), u01 = U(0,1).real(), u10 = U(1,0).real(), u11 = U(1,1).real();
+        const std::size_t stride = 0b1UL << target;
+        RealType* state = realState();
+
+        #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < (0b1UL << (num_local_qubits - 1)); i++){
+            const std::size_t i0 = ((i >> target) << (target + 1)) | (i & (stride - 1));
+            const std::size_t i1 = i0 | stride;
+            const GateRealType a = state[i0], b = state[i1];
+            const bool apply = (i0 & control_mask) == control_mask;
+            state[i0] = apply ? u00*a + u01*b : a;
+            state[i1] = apply ? u10*a + u11*b : b;
+        }
+        return true;
+    }
+
+    // Cache-blocked gate scheduling
+    /**
+     * @brief Queue the gate U on the given physical target (and control) qubit if it acts only on the scheduled block; otherwise make way for the gate to be applied directly by the caller, applying the queue first unless the gate commutes with all queued gates. Also accounts for the bytes moved per gate.
+     * 
+     * @return true if the gate was queued (or applied to the real amplitudes), false if the caller must apply it
+     */
+    bool scheduleGate(TMDP U, CST target, CST control = std::numeric_limits<std::size_t>::max()){
+        if(real_amplitudes){
+            if(applyRealGate(U, target, control)){
+                num_state_gates++;
+                bytes_moved += 2 * sizeof(RealType) * (0b1UL << getNumLocalQubits());
+                return true;
+            }
+            promoteToComplex();
+        }
+        const bool is_controlled = (control != std::numeric_limits<std::size_t>::max());
+        const std::size_t gate_mask = (0b1UL << target) | (is_controlled ? (0b1UL << control) : 0);
+        const std::size_t block_qubits = std::min(gate_block_qubits, getNumLocalQubits());
+        num_state_gates++;
+
+        if(block_qubits > 0 && gate_mask < (0b1UL << block_qubits) && !register_exposed){
+            scheduled_gates.push_back({U(0,0), U(0,1), U(1,0), U(1,1), target, is_controlled ? (0b1UL << control) : 0});
+            return true;
+        }
+
+        for(const auto& g : scheduled_gates){
+            if( (gate_mask & ((0b1UL << g.target) | g.control_mask)) != 0 ){
+                flushScheduledGates();
+                break;
+            }
+        }
+        bytes_moved += 2 * sizeof(Type) * qubitRegister->LocalSize();
+        return false;
+    }
+
+    /**
+     * @brief Apply the queued gates tile by tile, each tile of 2^gate_block_qubits amplitudes receiving every queued gate in order, and empty the queue.
+     */
+    void flushScheduledGates(){
+        const ThreadScope scope = threadScope();
+        if(scheduled_gates.empty()){
+            return;
+        }
+        const std::size_t tile_size = 0b1UL << std::min(gate_block_qubits, getNumLocalQubits());
+        const std::size_t num_tiles = qubitRegister->LocalSize() / tile_size;
+        Type* state = &(*qubitRegister)[0];
+
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t t = 0; t < num_tiles; t++){
+            Type* tile = state + t*tile_size;
+            for(const auto& g : scheduled_gates){
+                applyTileGate(tile, tile_size, g);
+            }
+        }
+        bytes_moved += 2 * sizeof(Type) * qubitRegister->LocalSize();
+        scheduled_gates.clear();
+    }
+
+    /**
+     * @brief Apply a queued gate to the amplitude pairs of a tile differing in the target bit, with the control bit (if any) set. The innermost loop runs over the contiguous amplitudes of a half-block of the target stride.
+     */
+    static inline void applyTileGate(Type* tile, std::size_t tile_size, const ScheduledGate& g){
+        const std::size_t stride = 0b1UL << g.target;
+        const GateRealType u00_re = g.u00.real(), u00_im = g.u00.imag(), u01_re = g.u01.real(), u01_im = g.u01.imag();
+        const GateRealType u10_re = g.u10.real(), u10_im = g.u10.imag(), u11_re = g.u11.real(), u11_im = g.u11.imag();
+
+        // A control bit below the target alternates within each half-block, in runs of the control stride
+        const std::size_t run = (g.control_mask != 0 && g.control_mask < stride) ? g.control_mask : stride;
+        for(std::size_t base = 0; base < tile_size; base += 2*stride){
+            for(std::size_t start = base; start < base + stride; start += run){
+                if( (start & g.control_mask) != g.control_mask ){
+                    continue;
+                }
+                RealType* a = reinterpret_cast<RealType*>(tile + start);
+                RealType* b = reinterpret_cast<RealType*>(tile + start + stride);
+
+                #pragma omp simd
+                for(std::size_t j = 0; j < run; j++){
+                    const GateRealType a_re = a[2*j], a_im = a[2*j+1], b_re = b[2*j], b_im = b[2*j+1];
+                    a[2*j]   = u00_re*a_re - u00_im*a_im + u01_re*b_re - u01_im*b_im;
+                    a[2*j+1] = u00_re*a_im + u00_im*a_re + u01_re*b_im + u01_im*b_re;
+                    b[2*j]   = u10_re*a_re - u10_im*a_im + u11_re*b_re - u11_im*b_im;
+                    b[2*j+1] = u10_re*a_im + u10_im*a_re + u11_re*b_im + u11_im*b_re;
+                }
+            }
+        }
+    }
+
+    // Two-qubit gate helpers
+    /**
+     * @brief Relabel any of the given logical qubits held on distributed physical qubits onto the highest local physical qubits not holding any of them, updating the qubit map. No-op without MPI.
+     */
+    void makeQubitsLocal([[maybe_unused]] const std::vector<std::size_t>& qubits){
+        #ifdef ENABLE_MPI
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        std::vector<std::size_t> target_map(qubit_map);
+        std::size_t free_local = num_local_qubits;
+        for(auto q : qubits){
+            if(target_map[q] < num_local_qubits){
+                continue;
+            }
+            // Next local physical qubit not holding one of the given qubits
+            bool in_use;
+            do {
+                assert(free_local > 0);
+                free_local--;
+                in_use = std::any_of(qubits.begin(), qubits.end(), [&](std::size_t r){ return target_map[r] == free_local; });
+            } while(in_use);
+
+            const std::size_t displaced = std::find(target_map.begin(), target_map.end(), free_local) - target_map.begin();
+            std::swap(target_map[q], target_map[displaced]);
+        }
+        remapQubits(target_map);
+        #endif
+    }
+
+    /**
+     * @brief Apply the 2^K x 2^K row-major matrix U to the local physical qubits, qubits[i] holding bit i of the matrix index. The state-vector is traversed in runs of contiguous amplitudes below the lowest of the qubits; for each run, the 2^K amplitude groups are updated together, with the matrix-vector product unrolled at compile time and the loop over the run vectorised.
+     */
+    template<std::size_t K>
+    void applyKQubitMatrix(const GateType* U, const std::vector<std::size_t>& qubits){
+        const ThreadScope scope = threadScope();
+        constexpr std::size_t dim = 0b1UL << K;
+        std::vector<std::size_t> sorted(qubits);
+        std::sort(sorted.begin(), sorted.end());
+        const std::size_t run = 0b1UL << sorted[0];
+        const std::size_t num_runs = qubitRegister->LocalSize() / (dim*run);
+
+        std::size_t offset[dim];
+        GateRealType u_re[dim][dim], u_im[dim][dim];
+        for(std::size_t k = 0; k < dim; k++){
+            offset[k] = depositBits(k, qubits);
+            for(std::size_t l = 0; l < dim; l++){
+                u_re[k][l] = U[k*dim + l].real();
+                u_im[k][l] = U[k*dim + l].imag();
+            }
+        }
+        Type* state = &(*qubitRegister)[0];
+
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t r = 0; r < num_runs; r++){
+            // Index of the run with zero bits inserted at each of the qubits
+            std::size_t base = r << sorted[0];
+            for(auto q : sorted){
+                base = ((base >> q) << (q + 1)) | (base & ((0b1UL << q) - 1));
+            }
+
+            RealType* a[dim];
+            for(std::size_t k = 0; k < dim; k++){
+                a[k] = reinterpret_cast<RealType*>(state + base + offset[k]);
+            }
+
+            #pragma omp simd
+            for(std::size_t j = 0; j < run; j++){
+                GateRealType in_re[dim], in_im[dim];
+                for(std::size_t l = 0; l < dim; l++){
+                    in_re[l] = a[l][2*j];
+                    in_im[l] = a[l][2*j+1];
+                }
+                for(std::size_t k = 0; k < dim; k++){
+                    GateRealType out_re = 0., out_im = 0.;
+                    for(std::size_t l = 0; l < dim; l++){
+                        out_re += u_re[k][l]*in_re[l] - u_im[k][l]*in_im[l];
+                        out_im += u_re[k][l]*in_im[l] + u_im[k][l]*in_re[l];
+                    }
+                    a[k][2*j] = out_re;
+                    a[k][2*j+1] = out_im;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Swap the amplitudes of the basis states idx_a and idx_b of the given logical qubits, bit i of each index being the value of qubits[i], leaving all other states untouched. Applies any permutation gate exchanging a single pair of states, such as CCX and CSwap, in one pass over the touched quarter of the state-vector.
+     */
+    void applyControlledPairSwap(const std::vector<std::size_t>& qubits, std::size_t idx_a, std::size_t idx_b){
+        #ifndef RESOURCE_ESTIMATE
+        // Classical qubits holding the same bit in both states act as controls: a mismatch leaves the state untouched, a match drops the qubit from the swap
+        std::vector<std::size_t> swapped;
+        std::size_t a = 0, b = 0;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            const std::size_t bit_a = (idx_a >> i) & 0b1, bit_b = (idx_b >> i) & 0b1;
+            if(classical_bits[qubits[i]] != quantum_bit && bit_a == bit_b){
+                if(classical_bits[qubits[i]] != static_cast<int>(bit_a)){
+                    return;
+                }
+                continue;
+            }
+            a |= bit_a << swapped.size();
+            b |= bit_b << swapped.size();
+            swapped.push_back(qubits[i]);
+        }
+        if(std::all_of(swapped.begin(), swapped.end(), [this](std::size_t q){ return classical_bits[q] != quantum_bit; })){
+            std::size_t val = 0;
+            for(std::size_t i = 0; i < swapped.size(); i++){
+                val |= static_cast<std::size_t>(classical_bits[swapped[i]]) << i;
+            }
+            if(val == a || val == b){
+                setClassicalValue(swapped, val == a ? b : a);
+            }
+            return;
+        }
+        // Only two states are exchanged, so deferred X gates cannot be folded into the indices and are applied first
+        applyDeferredFlips(swapped);
+        untrackQubits(swapped);
+        idx_a = a;
+        idx_b = b;
+
+        flushScheduledGates();
+        makeQubitsLocal(swapped);
+        const std::vector<std::size_t> physical = physicalQubits(swapped);
+        if(real_amplitudes){
+            swapPairs(realState(), physical, idx_a, idx_b);
+        }
+        else{
+            swapPairs(&(*qubitRegister)[0], physical, idx_a, idx_b);
+        }
+        num_state_gates++;
+        keepRegisterCurrent();
+        #endif
+    }
+
+    /**
+     * @brief Swap the local amplitudes of the basis states idx_a and idx_b of the given physical qubits, in runs of contiguous amplitudes below the lowest of the qubits.
+     */
+    template<class AmpType>
+    void swapPairs(AmpType* state, const std::vector<std::size_t>& qubits, std::size_t idx_a, std::size_t idx_b){
+        const ThreadScope scope = threadScope();
+        std::vector<std::size_t> sorted(qubits);
+        std::sort(sorted.begin(), sorted.end());
+
+        const std::size_t local_size = 0b1UL << getNumLocalQubits();
+        const std::size_t run = 0b1UL << sorted[0];
+        const std::size_t num_runs = local_size / ((0b1UL << qubits.size()) * run);
+        const std::size_t offset_a = depositBits(idx_a, qubits);
+        const std::size_t offset_b = depositBits(idx_b, qubits);
+
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t r = 0; r < num_runs; r++){
+            std::size_t base = r << sorted[0];
+            for(auto q : sorted){
+                base = ((base >> q) << (q + 1)) | (base & ((0b1UL << q) - 1));
+            }
+            AmpType* a = state + base + offset_a;
+            AmpType* b = state + base + offset_b;
+            #pragma omp simd
+            for(std::size_t j = 0; j < run; j++){
+                const AmpType tmp = a[j];
+                a[j] = b[j];
+                b[j] = tmp;
+            }
+        }
+        bytes_moved += 4 * sizeof(AmpType) * local_size >> qubits.size();
+    }
+
+    // Qubit release helpers
+    /**
+     * @brief Apply a0 -> a0 + a1, a1 -> 0 to the local amplitude pairs differing in the physical qubit p, and return the local norm of the folded amplitudes.
+     */
+    template<class AmpType>
+    double foldPairs(AmpType* state, std::size_t p){
+        const ThreadScope scope = threadScope();
+        const std::size_t half_size = 0b1UL << (getNumLocalQubits() - 1);
+        const std::size_t stride = 0b1UL << p;
+        double norm = 0.;
+        #pragma omp parallel for simd num_threads(numThreads()) schedule(static) reduction(+:norm)
+        for(std::size_t i = 0; i < half_size; i++){
+            const std::size_t i0 = ((i >> p) << (p + 1)) | (i & (stride - 1));
+            state[i0] += state[i0 + stride];
+            state[i0 + stride] = AmpType(0.);
+            norm += static_cast<double>(std::norm(state[i0]));
+        }
+        bytes_moved += 2 * sizeof(AmpType) * 2 * half_size;
+        return norm;
+    }
+
+    /**
+     * @brief Scale the local amplitudes with the physical qubit p unset.
+     */
+    template<class AmpType>
+    void scalePairs(AmpType* state, std::size_t p, double scale){
+        const ThreadScope scope = threadScope();
+        const std::size_t half_size = 0b1UL << (getNumLocalQubits() - 1);
+        const std::size_t stride = 0b1UL << p;
+        #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < half_size; i++){
+            const std::size_t i0 = ((i >> p) << (p + 1)) | (i & (stride - 1));
+            state[i0] *= static_cast<RealType>(scale);
+        }
+        bytes_moved += 2 * sizeof(AmpType) * half_size;
+    }
+
+    /**
+     * @brief Gather the local amplitudes with the physical qubit p equal to bit into dst, which holds half as many amplitudes.
+     */
+    template<class AmpType>
+    void gatherPairs(const AmpType* state, AmpType* dst, std::size_t p, std::size_t bit){
+        const ThreadScope scope = threadScope();
+        const std::size_t half_size = 0b1UL << (getNumLocalQubits() - 1);
+        const std::size_t stride = 0b1UL << p;
+        const std::size_t offset = bit << p;
+        #pragma omp parallel for simd num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < half_size; i++){
+            dst[i] = state[(((i >> p) << (p + 1)) | (i & (stride - 1))) + offset];
+        }
+    }
+
+    /**
+     * @brief Allocate all released qubits, restoring the state-vector to all qubits.
+     */
+    void allocateReleasedQubits(){
+        for(std::size_t q = 0; q < numQubits; q++){
+            if(isQubitReleased(q)){
+                allocateQubit(q);
+            }
+        }
+    }
+
+    // Classical bit tracking
+    /**
+     * @brief Apply the gate U on the given logical target (and control) qubit to the tracked classical values. A classical control of value 0 skips the gate and of value 1 reduces it to the uncontrolled gate. A diagonal or (uncontrolled) anti-diagonal gate keeps a classical target classical, any phase being applied as a diagonal gate; otherwise the target becomes quantum.
+     * 
+     * @return true if the gate was applied, false if the caller must apply it to the state-vector
+     */
+    bool applyClassicalGate(const TMDP& U, CST target, CST control = std::numeric_limits<std::size_t>::max()){
+        if(!isTrackingClassicalBits()){
+            return false;
+        }
+        const bool is_controlled = (control != std::numeric_limits<std::size_t>::max());
+        if(is_controlled && classical_bits[control] != quantum_bit){
+            if(classical_bits[control] == 1 && !applyClassicalGate(U, target)){
+                applyPhysicalGate(U, qubit_map[target]);
+            }
+            return true;
+        }
+
+        const int value = classical_bits[target];
+        if(value == quantum_bit){
+            return false;
+        }
+        const GateType zero(0.,0.), one(1.,0.);
+        const bool is_diagonal = (U(0,1) == zero && U(1,0) == zero);
+        const bool is_antidiagonal = (U(0,0) == zero && U(1,1) == zero);
+        if(is_diagonal && is_controlled){
+            // The phase of the target value is applied to the control
+            if(U(value,value) != one){
+                TMDP P;
+                P(0,0) = one;   P(0,1) = zero;
+                P(1,0) = zero;  P(1,1) = U(value,value);
+                applyPhysicalGate(P, qubit_map[control]);
+            }
+            return true;
+        }
+        if(!is_controlled && (is_diagonal || is_antidiagonal)){
+            const int new_value = is_diagonal ? value : 1 - value;
+            const GateType phase = U(new_value, value);
+            if(phase != one){
+                TMDP P;
+                P(0,0) = phase; P(0,1) = zero;
+                P(1,0) = zero;  P(1,1) = phase;
+                applyPhysicalGate(P, qubit_map[target]);
+            }
+            flipped_bits[target] ^= (new_value != value);
+            classical_bits[target] = new_value;
+            return true;
+        }
+
+        // The target becomes quantum, and a deferred X gate is folded into an uncontrolled gate
+        classical_bits[target] = quantum_bit;
+        if(flipped_bits[target]){
+            flipped_bits[target] = 0;
+            TMDP UX;
+            UX(0,0) = U(0,1);   UX(0,1) = U(0,0);
+            UX(1,0) = U(1,1);   UX(1,1) = U(1,0);
+            if(!is_controlled){
+                applyPhysicalGate(UX, qubit_map[target]);
+                return true;
+            }
+            applyPhysicalGate(getGateX(), qubit_map[target]);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Apply the gate U on the given physical target (and control) qubit to the state-vector
+     */
+    void applyPhysicalGate(const TMDP& U, CST target, CST control = std::numeric_limits<std::size_t>::max()){
+        if(scheduleGate(U, target, control)){
+            return;
+        }
+        if(control == std::numeric_limits<std::size_t>::max()){
+            threadedRegister()->Apply1QubitGate(target, stateMatrix(U));
+        }
+        else{
+            threadedRegister()->ApplyControlled1QubitGate(control, target, stateMatrix(U));
+        }
+    }
+
+    /**
+     * @brief Apply the deferred X gates of the given logical qubits to the state-vector, as a single permutation pass if there are several. The qubits remain classical.
+     */
+    void applyDeferredFlips(const std::vector<std::size_t>& qubits){
+        std::vector<std::size_t> physical;
+        for(auto q : qubits){
+            if(flipped_bits[q] && !isQubitReleased(q)){
+                physical.push_back(qubit_map[q]);
+            }
+            flipped_bits[q] = 0;
+        }
+        if(physical.size() == 1 || (real_amplitudes && !physical.empty())){
+            for(auto p : physical){
+                applyPhysicalGate(getGateX(), p);
+            }
+        }
+        else if(physical.size() > 1){
+            const std::size_t all_set = (0b1UL << physical.size()) - 1;
+            applyPhysicalPermutation(physical, [all_set](std::size_t val){ return val ^ all_set; });
+        }
+    }
+
+    /**
+     * @brief Mark the given logical qubits as quantum, clearing their deferred X gates without applying them. The caller must fold the returned mask into the operation it applies, bit i being set if qubits[i] was held flipped.
+     */
+    std::size_t untrackQubits(const std::vector<std::size_t>& qubits){
+        std::size_t flips = 0;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            flips |= static_cast<std::size_t>(flipped_bits[qubits[i]]) << i;
+            flipped_bits[qubits[i]] = 0;
+            classical_bits[qubits[i]] = quantum_bit;
+        }
+        return flips;
+    }
+
+    /**
+     * @brief Set the tracked values of the given classical qubits to the bits of value, deferring an X gate on each changed qubit.
+     */
+    void setClassicalValue(const std::vector<std::size_t>& qubits, std::size_t value){
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            const int bit = (value >> i) & 0b1;
+            flipped_bits[qubits[i]] ^= (bit != classical_bits[qubits[i]]);
+            classical_bits[qubits[i]] = bit;
+        }
+    }
+
+    /**
+     * @brief Check whether classical qubits are tracked, being enabled and not suspended by getQubitRegister
+     */
+    inline bool isTrackingClassicalBits() const {
+        return classical_tracking && !register_exposed;
+    }
+
+    /**
+     * @brief Track all qubits as classical 0, for the register in the state |0...0>, or as quantum if tracking is disabled.
+     */
+    void resetClassicalBits(){
+        std::fill(classical_bits.begin(), classical_bits.end(), isTrackingClassicalBits() ? 0 : quantum_bit);
+        std::fill(flipped_bits.begin(), flipped_bits.end(), 0);
+    }
+
+    /**
+     * @brief Translate patterns of the sub-register of the given logical qubits to the values held in the state-vector, complementing the bits of qubits with a deferred X gate.
+     */
+    std::vector<std::size_t> storedPatterns(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns) const {
+        std::size_t flips = 0;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            flips |= static_cast<std::size_t>(flipped_bits[qubits[i]]) << i;
+        }
+        std::vector<std::size_t> stored(patterns);
+        for(auto& pattern : stored){
+            pattern ^= flips;
+        }
+        return stored;
+    }
+
+    /**
+     * @brief Get the indices of all logical qubits
+     */
+    std::vector<std::size_t> allQubits() const {
+        std::vector<std::size_t> qubits(numQubits);
+        std::iota(qubits.begin(), qubits.end(), 0);
+        return qubits;
+    }
+
+    /**
+     * @brief Get a register of the given number of qubits in the state |0>, recycled from a freed register of the same size if any (see Arena.hpp)
+     */
+    static std::unique_ptr<QRDP> acquireRegister(std::size_t num_qubits){
+        std::unique_ptr<QRDP> reg = Recycler<QRDP>::getInstance().acquire(num_qubits);
+        if(reg == nullptr){
+            return std::unique_ptr<QRDP>(new QRDP(num_qubits, "base", 0));
+        }
+        reg->Initialize("base", 0);
+        return reg;
+    }
+
+    /**
+     * @brief Retain the given register for reuse by acquireRegister, within the capacity of the arena. Registers with fusion enabled cannot be reset, so are freed.
+     */
+    void recycleRegister(std::unique_ptr<QRDP> reg){
+        if(reg != nullptr && !use_fusion){
+            const std::size_t num_qubits = reg->NumQubits(), bytes = sizeof(Type) * reg->LocalSize();
+            Recycler<QRDP>::getInstance().recycle(num_qubits, bytes, std::move(reg));
+        }
+    }
+
+    /**
+     * @brief Replace the register of the simulator with the given one, recycling the current register
+     */
+    void replaceRegister(std::unique_ptr<QRDP> reg){
+        assert(!register_exposed);
+        if(use_fusion){
+            reg->TurnOnFusion();
+        }
+        recycleRegister(std::move(qubitRegister));
+        qubitRegister = std::move(reg);
+        placeRegister();
+    }
+
+    /**
+     * @brief Advise huge pages for the local state-vector if enabled in the arena, and move its pages to the NUMA nodes selected by the placement options
+     */
+    void placeRegister(){
+        const ThreadScope scope = threadScope();
+        if(Arena::getInstance().getHugePages() != HugePages::Regular){
+            adviseHugePages(&(*qubitRegister)[0], sizeof(Type) * qubitRegister->LocalSize());
+        }
+        if(!placePages(&(*qubitRegister)[0], sizeof(Type) * qubitRegister->LocalSize(), placement.memory)){
+            std::cerr << "Warning: unable to place the state-vector pages on NUMA nodes." << std::endl;
+        }
+    }
+
+    /**
+     * @brief Get the number of OpenMP threads of the parallel regions of the simulator: the placement thread count if set, otherwise that of the calling thread
+     */
+    int numThreads() const {
+        #ifdef _OPENMP
+        return placement.num_threads > 0 ? placement.num_threads : omp_get_max_threads();
+        #else
+        return 1;
+        #endif
+    }
+
+    /**
+     * @brief Get a scope setting the placement thread count and binding of the simulator's parallel regions (see ThreadScope), to be held by each method starting a parallel region
+     */
+    ThreadScope threadScope() const {
+        return ThreadScope(placement.num_threads, placement.bind_threads);
+    }
+
+    /**
+     * @brief Register access for calls into Intel-QS, whose parallel regions take the thread count and binding of the calling thread; the placement scope is held until the end of the full-expression holding the call
+     */
+    struct ThreadedRegister {
+        ThreadScope scope;
+        QRDP* reg;
+        QRDP* operator->(){ return reg; }
+    };
+    ThreadedRegister threadedRegister(){
+        return {threadScope(), qubitRegister.get()};
+    }
+
+    // Qubit map helpers
+    /**
+     * @brief Reset the qubit map to the identity, without moving any amplitudes.
+     */
+    inline void resetQubitMap(){
+        qubit_map.resize(numQubits);
+        std::iota(qubit_map.begin(), qubit_map.end(), 0);
+    }
+
+    /**
+     * @brief Restore the qubit map to the identity following a relabelling, if the register has been handed out by getQubitRegister, so that the register remains indexed by the logical qubits
+     */
+    inline void keepRegisterCurrent(){
+        if(register_exposed){
+            materializeQubitMap();
+        }
+    }
+
+    /**
+     * @brief Translate the given logical qubits to the physical qubits holding them.
+     */
+    inline std::vector<std::size_t> physicalQubits(const std::vector<std::size_t>& qubits) const {
+        std::vector<std::size_t> physical(qubits.size());
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            physical[i] = qubit_map[qubits[i]];
+        }
+        return physical;
+    }
+
+    /**
+     * @brief Permute the state-vector from the current qubit map to target_map as a single physical permutation of the moved qubits, and adopt target_map as the qubit map.
+     */
+    void remapQubits(const std::vector<std::size_t>& target_map){
+        #ifndef RESOURCE_ESTIMATE
+        // Physical qubits whose logical qubit changes, and the sub-register bit each is moved to
+        std::vector<std::size_t> qubits;
+        for(std::size_t q = 0; q < numQubits; q++){
+            if(qubit_map[q] != target_map[q]){
+                qubits.push_back(qubit_map[q]);
+            }
+        }
+        std::vector<std::size_t> dst_bit;
+        for(std::size_t q = 0; q < numQubits; q++){
+            if(qubit_map[q] != target_map[q]){
+                dst_bit.push_back(std::find(qubits.begin(), qubits.end(), target_map[q]) - qubits.begin());
+            }
+        }
+
+        if(!qubits.empty()){
+            applyPhysicalPermutation(qubits, [&dst_bit](std::size_t val){
+                std::size_t out = 0;
+                for(std::size_t i = 0; i < dst_bit.size(); i++){
+                    out |= ((val >> i) & 0b1UL) << dst_bit[i];
+                }
+                return out;
+            });
+        }
+        #endif
+        qubit_map = target_map;
+    }
+
+    /**
+     * @brief Apply a classical reversible function to the sub-register defined by the given physical qubits; see applyRegisterPermutation.
+     */
+    template<class PermFunc>
+    void applyPhysicalPermutation(const std::vector<std::size_t>& qubits, PermFunc perm){
+        #ifndef RESOURCE_ESTIMATE
+        promoteToComplex();
+        flushScheduledGates();
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        [[maybe_unused]] const bool is_local = std::all_of(qubits.begin(), qubits.end(), [num_local_qubits](std::size_t q){ return q < num_local_qubits; });
+
+        #ifdef ENABLE_MPI
+        if(!is_local){
+            permuteDistributed(qubits, perm);
+            return;
+        }
+        #else
+        assert(is_local);
+        #endif
+
+        if(qubits.size() <= max_perm_table_qubits){
+            permuteBlocked(qubits, perm, num_local_qubits);
+        }
+        else{
+            permuteOutOfPlace(qubits, perm);
+        }
+        #endif
+    }
+
+    // Native kernel helpers
+    /**
+     * @brief Scatter the bits of val to the given qubit positions; bit i of val is placed at bit qubits[i] of the returned index.
+     */
+    static inline std::size_t depositBits(std::size_t val, const std::vector<std::size_t>& qubits){
+        std::size_t idx = 0;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            idx |= ((val >> i) & 0b1UL) << qubits[i];
+        }
+        return idx;
+    }
+
+    /**
+     * @brief Gather the bits at the given qubit positions of idx; bit qubits[i] of idx is placed at bit i of the returned value.
+     */
+    static inline std::size_t extractBits(std::size_t idx, const std::vector<std::size_t>& qubits){
+        std::size_t val = 0;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            val |= ((idx >> qubits[i]) & 0b1UL) << i;
+        }
+        return val;
+    }
+
+    /**
+     * @brief Get the number of qubits whose amplitudes are held entirely by the local process. Qubits with larger indices are distributed across MPI ranks.
+     */
+    inline std::size_t getNumLocalQubits(){
+        // Real amplitudes are packed two to a complex one
+        const std::size_t local_size = real_amplitudes ? 2 * qubitRegister->LocalSize() : qubitRegister->LocalSize();
+        std::size_t num_local_qubits = 0;
+        while( (0b1UL << (num_local_qubits + 1)) <= local_size ){
+            num_local_qubits++;
+        }
+        return num_local_qubits;
+    }
+
+    /**
+     * @brief Apply func to each local amplitude whose sub-register value matches any of the given patterns, in a single pass over the state-vector, and return the sum of the values returned by func. If few patterns are given relative to the sub-register size, only the marked amplitudes are visited; otherwise every local amplitude is looked up in a bitmap (sub-registers up to max_pattern_bitmap_qubits qubits) or hash set of the marked values.
+     *
+     * @tparam Func Callable type mapping Type& -> double
+     */
+    template<class Func>
+    double reduceMarkedAmplitudes(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns, Func func){
+        const ThreadScope scope = threadScope();
+        promoteToComplex();
+        flushScheduledGates();
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        const std::size_t local_size = 0b1UL << num_local_qubits;
+        const std::size_t local_mask = local_size - 1;
+        const std::size_t pattern_mask = (qubits.size() < 64) ? (0b1UL << qubits.size()) - 1 : ~0UL;
+
+        std::vector<std::size_t> marked;
+        marked.reserve(patterns.size());
+        for(auto p : patterns){
+            marked.push_back(p & pattern_mask);
+        }
+        std::sort(marked.begin(), marked.end());
+        marked.erase(std::unique(marked.begin(), marked.end()), marked.end());
+        if(marked.empty()){
+            return 0.;
+        }
+
+        // Offset of the local amplitudes in the global state-vector
+        std::size_t global_offset = 0;
+        #ifdef ENABLE_MPI
+        global_offset = static_cast<std::size_t>(rank) << num_local_qubits;
+        #endif
+
+        const std::size_t reg_mask = depositBits(~0UL, qubits);
+        const std::size_t reg_local_mask = reg_mask & local_mask;
+        std::size_t num_reg_local = 0;
+        std::vector<std::size_t> rest_qubits;
+        for(std::size_t q = 0; q < num_local_qubits; q++){
+            if(IS_SET(reg_local_mask, q)){
+                num_reg_local++;
+            }
+            else{
+                rest_qubits.push_back(q);
+            }
+        }
+        const std::size_t rest_mask = local_mask & ~reg_local_mask;
+        const std::size_t num_rest = 0b1UL << rest_qubits.size();
+
+        Type* state = &(*qubitRegister)[0];
+        double sum = 0.;
+
+        // Sparse marking: visit the marked amplitudes only
+        if(marked.size() * sparse_pattern_factor < (0b1UL << num_reg_local)){
+            const std::size_t chunk = std::min(num_rest, static_cast<std::size_t>(4096));
+            const std::size_t num_chunks = num_rest / chunk;
+
+            for(auto p : marked){
+                const std::size_t idx = depositBits(p, qubits);
+                // Distributed sub-register bits must match those of this rank
+                if( (idx & ~local_mask) != (global_offset & reg_mask) ){
+                    continue;
+                }
+                const std::size_t offset = idx & local_mask;
+
+                #pragma omp parallel for num_threads(numThreads()) schedule(static) reduction(+:sum)
+                for(std::size_t c = 0; c < num_chunks; c++){
+                    std::size_t v = depositBits(c*chunk, rest_qubits);
+                    for(std::size_t j = 0; j < chunk; j++){
+                        sum += func(state[offset | v]);
+                        v = (v - rest_mask) & rest_mask;
+                    }
+                }
+            }
+        }
+        // Dense marking: look up every local amplitude
+        else if(qubits.size() <= max_pattern_bitmap_qubits){
+            std::vector<char> is_marked(0b1UL << qubits.size(), 0);
+            for(auto p : marked){
+                is_marked[p] = 1;
+            }
+
+            #pragma omp parallel for num_threads(numThreads()) schedule(static) reduction(+:sum)
+            for(std::size_t idx = 0; idx < local_size; idx++){
+                if(is_marked[extractBits(global_offset | idx, qubits)]){
+                    sum += func(state[idx]);
+                }
+            }
+        }
+        else{
+            const std::unordered_set<std::size_t> marked_set(marked.begin(), marked.end());
+
+            #pragma omp parallel for num_threads(numThreads()) schedule(static) reduction(+:sum)
+            for(std::size_t idx = 0; idx < local_size; idx++){
+                if(marked_set.count(extractBits(global_offset | idx, qubits))){
+                    sum += func(state[idx]);
+                }
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Apply the (inverse) Fourier transform to the local qubit range [minIdx, maxIdx]. The state-vector is viewed as a batch of N x S matrices, with N = 2^(maxIdx-minIdx+1) the transform length and S = 2^minIdx the stride, transformed along their columns. With enough batches for all threads, tiles of up to max_fft_tile columns are gathered in bit-reversed order into thread-private buffers and transformed there; otherwise each matrix is transformed in place, with the butterflies of each stage shared among the threads. In both cases the innermost loop runs over contiguous columns.
+     */
+    void fourierLocal(std::size_t minIdx, std::size_t maxIdx, bool inverse){
+        const ThreadScope scope = threadScope();
+        const std::size_t n = maxIdx - minIdx + 1;
+        const std::size_t N = 0b1UL << n;
+        const std::size_t S = 0b1UL << minIdx;
+        const std::size_t num_high = qubitRegister->LocalSize() / (N*S);
+        const RealType norm = 1. / std::sqrt(static_cast<double>(N));
+        const double sign = inverse ? -1. : 1.;
+
+        // Twiddles and butterflies are evaluated at the gate precision
+        std::vector<GateType> twiddle(N/2);
+        for(std::size_t k = 0; k < N/2; k++){
+            const double phi = sign * 2. * M_PI * k / N;
+            twiddle[k] = GateType(std::cos(phi), std::sin(phi));
+        }
+        std::vector<std::size_t> rev(N, 0);
+        for(std::size_t x = 0; x < N; x++){
+            for(std::size_t i = 0; i < n; i++){
+                rev[x] |= ((x >> i) & 0b1UL) << (n - 1 - i);
+            }
+        }
+
+        Type* state = &(*qubitRegister)[0];
+        const std::size_t tile = std::min(S, max_fft_tile);
+        const std::size_t num_tiles = S / tile;
+        const std::size_t num_batches = num_high * num_tiles;
+
+        if(num_batches >= static_cast<std::size_t>(numThreads())){
+            #pragma omp parallel num_threads(numThreads())
+            {
+                StateBuffer buffer(N*tile);
+
+                #pragma omp for schedule(static)
+                for(std::size_t b = 0; b < num_batches; b++){
+                    Type* base = state + (b / num_tiles)*N*S + (b % num_tiles)*tile;
+                    for(std::size_t x = 0; x < N; x++){
+                        std::copy(base + x*S, base + x*S + tile, &buffer[rev[x]*tile]);
+                    }
+                    for(std::size_t len = 2; len <= N; len <<= 1){
+                        for(std::size_t p = 0; p < N/2; p++){
+                            fftButterfly(&buffer[0], p, len, tile, twiddle[(p % (len/2)) * (N/len)], tile);
+                        }
+                    }
+                    for(std::size_t x = 0; x < N; x++){
+                        for(std::size_t t = 0; t < tile; t++){
+                            base[x*S + t] = buffer[x*tile + t] * norm;
+                        }
+                    }
+                }
+            }
+        }
+        else{
+            for(std::size_t h = 0; h < num_high; h++){
+                Type* base = state + h*N*S;
+
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(std::size_t x = 0; x < N; x++){
+                    if(x < rev[x]){
+                        std::swap_ranges(base + x*S, base + (x+1)*S, base + rev[x]*S);
+                    }
+                }
+                for(std::size_t len = 2; len <= N; len <<= 1){
+                    #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                    for(std::size_t p = 0; p < N/2; p++){
+                        fftButterfly(base, p, len, S, twiddle[(p % (len/2)) * (N/len)], S);
+                    }
+                }
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(std::size_t i = 0; i < N*S; i++){
+                    base[i] *= norm;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Radix-2 decimation-in-time butterfly p of the stage with sub-transform length len, applied to width contiguous columns of rows spaced by row_stride: (u, v) -> (u + wv, u - wv).
+     */
+    static inline void fftButterfly(Type* data, std::size_t p, std::size_t len, std::size_t row_stride, const GateType& w, std::size_t width){
+        const std::size_t half = len / 2;
+        const std::size_t row = (p / half) * len + (p % half);
+        RealType* u = reinterpret_cast<RealType*>(data + row*row_stride);
+        RealType* v = reinterpret_cast<RealType*>(data + (row + half)*row_stride);
+        const GateRealType w_re = w.real(), w_im = w.imag();
+
+        #pragma omp simd
+        for(std::size_t t = 0; t < width; t++){
+            const GateRealType u_re = u[2*t], u_im = u[2*t+1], v_re = v[2*t], v_im = v[2*t+1];
+            const GateRealType x_re = v_re*w_re - v_im*w_im;
+            const GateRealType x_im = v_re*w_im + v_im*w_re;
+            v[2*t]   = u_re - x_re;
+            v[2*t+1] = u_im - x_im;
+            u[2*t]   = u_re + x_re;
+            u[2*t+1] = u_im + x_im;
+        }
+    }
+
+    /**
+     * @brief Permute the local state-vector by gathering each sub-register block (fixed values of the remaining qubits) and scattering it to the permuted offsets.
+     */
+    template<class PermFunc>
+    void permuteBlocked(const std::vector<std::size_t>& qubits, PermFunc& perm, std::size_t num_local_qubits){
+        const ThreadScope scope = threadScope();
+        const std::size_t block_size = 0b1UL << qubits.size();
+
+        std::vector<std::size_t> src_offset(block_size), dst_offset(block_size);
+        for(std::size_t val = 0; val < block_size; val++){
+            src_offset[val] = depositBits(val, qubits);
+            dst_offset[val] = depositBits(perm(val), qubits);
+        }
+
+        std::vector<std::size_t> rest_qubits;
+        for(std::size_t q = 0; q < num_local_qubits; q++){
+            if(std::find(qubits.begin(), qubits.end(), q) == qubits.end()){
+                rest_qubits.push_back(q);
+            }
+        }
+        const std::size_t num_blocks = 0b1UL << rest_qubits.size();
+        Type* state = &(*qubitRegister)[0];
+
+        #pragma omp parallel num_threads(numThreads())
+        {
+            StateBuffer block(block_size);
+
+            #pragma omp for schedule(static)
+            for(std::size_t b = 0; b < num_blocks; b++){
+                const std::size_t base = depositBits(b, rest_qubits);
+                for(std::size_t val = 0; val < block_size; val++){
+                    block[val] = state[base + src_offset[val]];
+                }
+                for(std::size_t val = 0; val < block_size; val++){
+                    state[base + dst_offset[val]] = block[val];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Permute the local state-vector out-of-place, computing the destination of each amplitude directly.
+     */
+    template<class PermFunc>
+    void permuteOutOfPlace(const std::vector<std::size_t>& qubits, PermFunc& perm){
+        const ThreadScope scope = threadScope();
+        const std::size_t local_size = qubitRegister->LocalSize();
+        const std::size_t reg_mask = depositBits(~0UL, qubits);
+        Type* state = &(*qubitRegister)[0];
+        StateBuffer buffer(local_size);
+
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t idx = 0; idx < local_size; idx++){
+            buffer[(idx & ~reg_mask) | depositBits(perm(extractBits(idx, qubits)), qubits)] = state[idx];
+        }
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t idx = 0; idx < local_size; idx++){
+            state[idx] = buffer[idx];
+        }
+    }
+
+    #ifdef ENABLE_MPI
+    /**
+     * @brief Get the communicator of the ranks differing only in the given distributed qubits (bits of the rank), as used by applyUniformReflection. Communicators are split on first use of each mask, and held until the simulator is destroyed.
+     */
+    MPI_Comm reflectionComm(std::size_t rank_mask){
+        auto it = reflect_comms.find(rank_mask);
+        if(it == reflect_comms.end()){
+            MPI_Comm comm;
+            MPI_Comm_split(MPI_COMM_WORLD, static_cast<int>(rank & ~rank_mask), rank, &comm);
+            it = reflect_comms.emplace(rank_mask, comm).first;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Permute the state-vector where the sub-register spans qubits distributed across MPI ranks. As the permutation fixes the qubits outside the sub-register, the local amplitudes sharing a value of the local sub-register qubits form a block which is moved as a whole, to a single block of a single rank. Blocks whose distributed qubits are unchanged are moved locally; the others are exchanged between the ranks differing only in the distributed sub-register qubits, in rounds of all-to-all exchanges of at most max_exchange_amplitudes amplitudes per rank. Each rank evaluates perm once for each sub-register value, so that received blocks are placed without exchanging their indices.
+     */
+    template<class PermFunc>
+    void permuteDistributed(const std::vector<std::size_t>& qubits, PermFunc& perm){
+        const ThreadScope scope = threadScope();
+        int num_ranks;
+        MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+        const std::size_t num_local_qubits = getNumLocalQubits();
+        const std::size_t local_size = qubitRegister->LocalSize();
+        const std::size_t reg_mask = depositBits(~0UL, qubits);
+        Type* state = &(*qubitRegister)[0];
+
+        // Sub-register bits held on local qubits, and on the qubits given by the rank bits
+        std::vector<std::size_t> local_bits, local_qubits, global_bits, rank_bits, rest_qubits;
+        for(std::size_t i = 0; i < qubits.size(); i++){
+            if(qubits[i] < num_local_qubits){
+                local_bits.push_back(i);
+                local_qubits.push_back(qubits[i]);
+            }
+            else{
+                global_bits.push_back(i);
+                rank_bits.push_back(qubits[i] - num_local_qubits);
+            }
+        }
+        for(std::size_t q = 0; q < num_local_qubits; q++){
+            if(!IS_SET(reg_mask, q)){
+                rest_qubits.push_back(q);
+            }
+        }
+        const std::size_t num_blocks = 0b1UL << local_bits.size();
+        const std::size_t block_size = local_size >> local_bits.size();
+        const std::size_t num_group = 0b1UL << rank_bits.size();
+        const std::size_t group_base = static_cast<std::size_t>(rank) & ~depositBits(~0UL, rank_bits);
+        const std::size_t group_idx = extractBits(rank, rank_bits);
+
+        // Blocks sent to each rank of the group, blocks kept as (source, destination) pairs, and the destination blocks received from each rank, in the order sent
+        std::vector<std::vector<std::size_t>> send_blocks(num_group), recv_blocks(num_group);
+        std::vector<std::pair<std::size_t, std::size_t>> kept_blocks;
+        std::vector<std::size_t> dst(num_blocks);
+        for(std::size_t src = 0; src < num_group; src++){
+            const std::size_t src_val = depositBits(src, global_bits);
+            #pragma omp parallel for num_threads(numThreads()) schedule(static)
+            for(std::size_t b = 0; b < num_blocks; b++){
+                dst[b] = perm(src_val | depositBits(b, local_bits));
+            }
+            for(std::size_t b = 0; b < num_blocks; b++){
+                const std::size_t dst_group = extractBits(dst[b], global_bits);
+                const std::size_t dst_block = extractBits(dst[b], local_bits);
+                if(src == group_idx && dst_group == group_idx){
+                    kept_blocks.emplace_back(b, dst_block);
+                }
+                else if(src == group_idx){
+                    send_blocks[dst_group].push_back(b);
+                }
+                else if(dst_group == group_idx){
+                    recv_blocks[src].push_back(dst_block);
+                }
+            }
+        }
+        std::vector<std::size_t>().swap(dst);
+
+        // Local index of amplitude j of the given block
+        auto localIdx = [&rest_qubits, &local_qubits](std::size_t block, std::size_t j){
+            return depositBits(j, rest_qubits) | depositBits(block, local_qubits);
+        };
+
+        StateBuffer buffer(local_size);
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t i = 0; i < kept_blocks.size() * block_size; i++){
+            const auto& [src_block, dst_block] = kept_blocks[i / block_size];
+            buffer[localIdx(dst_block, i % block_size)] = state[localIdx(src_block, i % block_size)];
+        }
+
+        // The moved blocks of each rank form a stream, exchanged in rounds of at most chunk amplitudes per pair of ranks
+        const std::size_t chunk = std::max(max_exchange_amplitudes / num_group, static_cast<std::size_t>(1));
+        std::uint64_t max_stream = 0;
+        for(std::size_t g = 0; g < num_group; g++){
+            max_stream = std::max<std::uint64_t>(max_stream, std::max(send_blocks[g].size(), recv_blocks[g].size()) * block_size);
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &max_stream, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+        const std::size_t num_rounds = (max_stream + chunk - 1) / chunk;
+
+        const MPI_Datatype real_type = std::is_same<RealType, float>::value ? MPI_FLOAT : MPI_DOUBLE;
+        MPI_Datatype amp_type;
+        MPI_Type_contiguous(2, real_type, &amp_type);
+        MPI_Type_commit(&amp_type);
+
+        StateBuffer send_amps(std::min(num_group * chunk, local_size)), recv_amps(std::min(num_group * chunk, local_size));
+        std::vector<int> send_counts(num_ranks, 0), recv_counts(num_ranks, 0), send_displs(num_ranks, 0), recv_displs(num_ranks, 0);
+        auto roundCount = [chunk](std::size_t stream_size, std::size_t round){
+            return static_cast<int>(std::min(stream_size - std::min(stream_size, round * chunk), chunk));
+        };
+        for(std::size_t round = 0; round < num_rounds; round++){
+            int send_offset = 0, recv_offset = 0;
+            for(std::size_t g = 0; g < num_group; g++){
+                const std::size_t r = group_base | depositBits(g, rank_bits);
+                send_counts[r] = roundCount(send_blocks[g].size() * block_size, round);
+                recv_counts[r] = roundCount(recv_blocks[g].size() * block_size, round);
+                send_displs[r] = send_offset;
+                recv_displs[r] = recv_offset;
+                send_offset += send_counts[r];
+                recv_offset += recv_counts[r];
+
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(int e = 0; e < send_counts[r]; e++){
+                    const std::size_t i = round * chunk + e;
+                    send_amps[send_displs[r] + e] = state[localIdx(send_blocks[g][i / block_size], i % block_size)];
+                }
+            }
+
+            MPI_Alltoallv(send_amps.data(), send_counts.data(), send_displs.data(), amp_type,
+                          recv_amps.data(), recv_counts.data(), recv_displs.data(), amp_type, MPI_COMM_WORLD);
+
+            for(std::size_t g = 0; g < num_group; g++){
+                const std::size_t r = group_base | depositBits(g, rank_bits);
+                #pragma omp parallel for num_threads(numThreads()) schedule(static)
+                for(int e = 0; e < recv_counts[r]; e++){
+                    const std::size_t i = round * chunk + e;
+                    buffer[localIdx(recv_blocks[g][i / block_size], i % block_size)] = recv_amps[recv_displs[r] + e];
+                }
+            }
+        }
+        MPI_Type_free(&amp_type);
+
+        #pragma omp parallel for num_threads(numThreads()) schedule(static)
+        for(std::size_t idx = 0; idx < local_size; idx++){
+            state[idx] = buffer[idx];
+        }
+    }
+    #endif
+
 };
 
+/**
+ * @brief Double precision simulator
+ */
+using IntelSimulator = IntelSimulatorT<ComplexDP>;
+
+/**
+ * @brief Single precision simulator, halving the memory and bandwidth of the state
+ */
+using IntelSimulatorSP = IntelSimulatorT<ComplexSP>;
+
+/**
+ * @brief Mixed precision simulator: single precision state with double precision gates and normalization
+ */
+using IntelSimulatorMP = IntelSimulatorT<ComplexSP, ComplexDP>;
+
 };
 
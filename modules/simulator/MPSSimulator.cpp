@@ -0,0 +1,1251 @@
+//##############################################################################
+/**
+ *  @file    MPSSimulator.cpp
+ *  @version 0.1
+ *
+ *  @brief Matrix product state simulator backend.
+ *
+ *  @section DESCRIPTION
+ *  This class implements the CRTP simulator interface on a matrix product
+ *  state (MPS), whose memory scales with the entanglement of the state rather
+ *  than exponentially with the number of qubits.
+ *
+ */
+//##############################################################################
+
+#include "Simulator.hpp"
+#include "GateWriter.hpp"
+#include "include/qureg.hpp"
+#include "include/tinymatrix.hpp"
+#include "Philox.hpp"
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
+
+#ifdef ENABLE_MPI
+    #include "mpi.h"
+#endif
+
+namespace QNLP{
+
+class MPSSimulator;
+
+/**
+ * @brief The MPS does not hold a state-vector, and so applies the decomposed gate sequences in place of the native kernels
+ */
+template<>
+struct HasNativeKernels<MPSSimulator> : std::false_type {};
+
+/**
+ * @brief Class definition for MPSSimulator. The state of n qubits is held as a matrix product state: a chain of n site tensors A[i] of shape (chi_i, 2, chi_{i+1}), where the bond dimensions chi are bounded by the Schmidt rank of the state across each cut. States prepared by the encoding and Hamming distance routines over m patterns have bond dimensions of O(m), so large registers may be simulated where the state-vector would not fit in memory.
+ *
+ * The MPS is kept in mixed canonical form about an orthogonality centre site. Single qubit gates are applied directly to a site tensor. Two qubit gates are applied to a pair of adjacent sites, and the result split with a singular value decomposition (SVD), truncated by a relative cutoff on the discarded weight and an optional maximum bond dimension. Gates on non-adjacent qubits are routed with SWAPs, which are tracked in a logical to physical (site) qubit map as for IntelSimulator; the routed qubits are left in place rather than swapped back, so that repeated gates between the same qubits remain adjacent.
+ *
+ * If built with MPI enabled, the MPS is replicated on every rank, and every rank draws the same random numbers in measurement and sampling from the counter-based stream, with no communication.
+ */
+class MPSSimulator : public SimulatorGeneral<MPSSimulator> {
+    public:
+    using TMDP = qhipster::TinyMatrix<ComplexDP, 2, 2, 32>;
+    using TM4DP = qhipster::TinyMatrix<ComplexDP, 4, 4, 32>;
+    using CST = const std::size_t;
+
+    /**
+     * @brief Construct a new MPS Simulator object, initialised to the state |0...0>
+     *
+     * @param numQubits Number of qubits in quantum register
+     * @param maxBondDim Maximum bond dimension kept after each SVD; 0 leaves the bond dimension unbounded (default)
+     * @param cutoff Singular values whose squared weight relative to the total falls below cutoff are discarded (default is 1e-14)
+     * @param seed Seed of the measurement random stream (default draws a seed from the system entropy source; see getRandomSeed)
+     */
+    MPSSimulator(int numQubits, std::size_t maxBondDim=0, double cutoff=1e-14, const std::optional<std::uint64_t>& seed=std::nullopt) : SimulatorGeneral<MPSSimulator>(),
+                                    numQubits(numQubits),
+                                    max_bond_dim(maxBondDim), truncation_cutoff(cutoff),
+                                    gates(5){
+        //Define Pauli X
+        gates[0](0,0) = ComplexDP(0.,0.);       gates[0](0,1) = ComplexDP(1.,0.);
+        gates[0](1,0) = ComplexDP(1.,0.);       gates[0](1,1) = ComplexDP(0.,0.);
+
+        //Define Pauli Y
+        gates[1](0,0) = ComplexDP(0.,0.);       gates[1](0,1) = -ComplexDP(0.,1.);
+        gates[1](1,0) = ComplexDP(0.,1.);       gates[1](1,1) = ComplexDP(0.,0.);
+
+        //Define Pauli Z
+        gates[2](0,0) = ComplexDP(1.,0.);       gates[2](0,1) = ComplexDP(0.,0.);
+        gates[2](1,0) = ComplexDP(0.,0.);       gates[2](1,1) = ComplexDP(-1.,0.);
+
+        //Define I
+        gates[3](0,0) = ComplexDP(1.,0.);       gates[3](0,1) = ComplexDP(0.,0.);
+        gates[3](1,0) = ComplexDP(0.,0.);       gates[3](1,1) = ComplexDP(1.,0.);
+
+        //Define Pauli H
+        double coeff = (1./sqrt(2.));
+        gates[4](0,0) = ComplexDP(coeff,0.);     gates[4](0,1) = ComplexDP(coeff,0.);
+        gates[4](1,0) = ComplexDP(coeff,0.);     gates[4](1,1) = ComplexDP(-coeff,0.);
+
+        //Ensure the cache maps are populated before use.
+        this->initCaches();
+
+        //An unseeded simulator takes the seed of rank 0, so that every rank draws the same stream
+        std::uint64_t rng_seed = seed ? *seed : PhiloxStream::randomSeed();
+        #ifdef ENABLE_MPI
+            if(!seed){
+                MPI_Bcast(&rng_seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+            }
+        #endif
+        rng.seed(rng_seed);
+
+        gate_count_1qubit = 0;
+        gate_count_2qubit = 0;
+        target_usage.assign(numQubits, 0);
+        resetState();
+    }
+
+    /**
+     * @brief Destroy the MPS Simulator object
+     *
+     */
+    ~MPSSimulator(){ }
+
+    // 1 qubit
+    /**
+     * @brief Apply arbitrary user-defined unitary gate to qubit at qubit_idx
+     *
+     * @param U User-defined unitary 2x2 matrix
+     * @param qubitIndex Index of qubit to apply gate upon
+     * @param label Label for the gate U
+     */
+    inline void applyGateU(const TMDP& U, CST qubitIndex, std::string label="U"){
+        #ifndef RESOURCE_ESTIMATE
+        applySiteMatrix(U, qubit_map[qubitIndex]);
+        #endif
+
+        gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall(label, U.tostr(), qubitIndex);
+        #endif
+    }
+
+    /**
+     * @brief Apply the Identity gate to the given qubit. The state is unchanged.
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateI(std::size_t qubitIndex){
+        gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall("I", getGateI().tostr(), qubitIndex);
+        #endif
+    }
+
+    /**
+     * @brief Apply phase shift to given Qubit; [[1 0] [0 exp(i*angle)]]
+     *
+     * @param qubit_idx Qubit index to perform phase shift upon
+     * @param angle Angle of phase shift in rads
+     */
+    inline void applyGatePhaseShift(std::size_t qubit_idx, double angle){
+        TMDP U(gates[3]);
+        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+
+        #ifndef RESOURCE_ESTIMATE
+        applySiteMatrix(U, qubit_map[qubit_idx]);
+        #endif
+
+        gate_count_1qubit++;
+        countTargetUsage(qubit_idx);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall("PShift(theta=" + std::to_string(angle) + ")", U.tostr(), qubit_idx);
+        #endif
+    }
+
+    /**
+     * @brief Apply the Pauli X gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateX(CST qubitIndex){
+        applyNamedGate(getGateX(), qubitIndex, "X");
+    }
+
+    /**
+     * @brief Apply the Pauli Y gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateY(CST qubitIndex){
+        applyNamedGate(getGateY(), qubitIndex, "Y");
+    }
+
+    /**
+     * @brief Apply the Pauli Z gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateZ(CST qubitIndex){
+        applyNamedGate(getGateZ(), qubitIndex, "Z");
+    }
+
+    /**
+     * @brief Apply the Hadamard gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateH(CST qubitIndex){
+        applyNamedGate(getGateH(), qubitIndex, "H");
+    }
+
+    /**
+     * @brief Apply the Sqrt{Pauli X} gate to the given qubit
+     *
+     * @param qubitIndex
+     */
+    inline void applyGateSqrtX(CST qubitIndex){
+        applyNamedGate(getGateSqrtX(), qubitIndex, "\\sqrt[2]{X}");
+    }
+
+    /**
+     * @brief Apply the given Rotation about X-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about X-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotX(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('X', angle), qubitIndex, "R_X(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Apply the given Rotation about Y-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about Y-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotY(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('Y', angle), qubitIndex, "R_Y(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Apply the given Rotation about Z-axis to the given qubit
+     *
+     * @param qubitIndex Index of qubit to rotate about Z-axis
+     * @param angle Rotation angle
+     */
+    inline void applyGateRotZ(CST qubitIndex, double angle){
+        applyNamedGate(getGateRotation('Z', angle), qubitIndex, "R_Z(\\theta=" + std::to_string(angle) + ")");
+    }
+
+    /**
+     * @brief Get the Pauli-X gate
+     * @return TMDP return type of Pauli-X gate
+     */
+    inline TMDP getGateX(){ return gates[0]; }
+
+    /**
+     * @brief Get the Pauli-Y gate
+     * @return TMDP return type of Pauli-Y gate
+     */
+    inline TMDP getGateY(){ return gates[1]; }
+
+    /**
+     * @brief Get the Pauli-Z gate
+     * @return TMDP return type of Pauli-Z gate
+     */
+    inline TMDP getGateZ(){ return gates[2]; }
+
+    /**
+     * @brief Get the Identity
+     * @return TMDP return type of the Identity
+     */
+    inline TMDP getGateI(){ return gates[3]; }
+
+    /**
+     * @brief Get the Hadamard gate
+     * @return TMDP return type of Hadamard gate
+     */
+    inline TMDP getGateH(){ return gates[4]; }
+
+    /**
+     * @brief Get the Sqrt{Pauli X} gate
+     * @return TMDP return type of Sqrt{Pauli X} gate
+     */
+    inline TMDP getGateSqrtX(){
+        TMDP U;
+        U(0,0) = {0.5,  0.5};   U(0,1) = {0.5, -0.5};
+        U(1,0) = {0.5, -0.5};   U(1,1) = {0.5,  0.5};
+        return U;
+    }
+
+    /**
+     * @brief Get the rotation gate exp(-i angle/2 P) about the given axis P
+     * @param axis Rotation axis; one of 'X', 'Y' or 'Z'
+     * @param angle Rotation angle
+     * @return TMDP return type of the rotation gate
+     */
+    inline TMDP getGateRotation(char axis, double angle){
+        const double c = std::cos(0.5*angle), s = std::sin(0.5*angle);
+        TMDP U;
+        switch(axis){
+            case 'X':
+                U(0,0) = {c, 0.};   U(0,1) = {0., -s};
+                U(1,0) = {0., -s};  U(1,1) = {c, 0.};
+                break;
+            case 'Y':
+                U(0,0) = {c, 0.};   U(0,1) = {-s, 0.};
+                U(1,0) = {s, 0.};   U(1,1) = {c, 0.};
+                break;
+            default:
+                U(0,0) = {c, -s};   U(0,1) = {0., 0.};
+                U(1,0) = {0., 0.};  U(1,1) = {c, s};
+                break;
+        }
+        return U;
+    }
+
+    // 2 qubit
+    /**
+     * @brief Apply arbitrary user-defined two-qubit unitary gate to the given qubits. Row and column k = 2*b1 + b0 of U correspond to the basis state with b0 the value of qubit_idx0 and b1 the value of qubit_idx1. If the qubits are not held at adjacent sites, they are first routed together with SWAPs.
+     *
+     * @param U User-defined unitary 4x4 matrix
+     * @param qubit_idx0 Index of qubit 0 (low bit of the matrix index)
+     * @param qubit_idx1 Index of qubit 1 (high bit of the matrix index)
+     * @param label Label for the gate U
+     */
+    inline void applyGate2U(const TM4DP& U, CST qubit_idx0, CST qubit_idx1, std::string label="U"){
+        assert(qubit_idx0 != qubit_idx1);
+
+        #ifndef RESOURCE_ESTIMATE
+        applyTwoQubitMatrix(U, qubit_idx0, qubit_idx1);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(qubit_idx0);
+        countTargetUsage(qubit_idx1);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( label, U.tostr(), qubit_idx0, qubit_idx1 );
+        #endif
+    }
+
+    /**
+     * @brief Performs Sqrt SWAP gate between two given qubits (half way SWAP)
+     *
+     * @param qubit_idx0 Qubit index 0
+     * @param qubit_idx1 Qubit index 1
+     */
+    inline void applyGateSqrtSwap(std::size_t qubit_idx0, std::size_t qubit_idx1){
+        TM4DP U = identity4();
+        U(1,1) = {0.5,  0.5};   U(1,2) = {0.5, -0.5};
+        U(2,1) = {0.5, -0.5};   U(2,2) = {0.5,  0.5};
+        applyGate2U(U, qubit_idx0, qubit_idx1, "\\sqrt[2]{SWAP}");
+    }
+
+    /**
+     * @brief Apply the given controlled unitary gate on target qubit
+     *
+     * @param U User-defined arbitrary 2x2 unitary gate (matrix)
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     * @param label Optional parameter to label the gate U
+     */
+    inline void applyGateCU(const TMDP& U, CST control, CST target, std::string label="U"){
+        applyNamedControlledGate(U, control, target, label);
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-X (CNOT) on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCX(CST control, CST target){
+        applyNamedControlledGate(getGateX(), control, target, "X");
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-Y on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCY(CST control, CST target){
+        applyNamedControlledGate(getGateY(), control, target, "Y");
+    }
+
+    /**
+     * @brief Apply Controlled Pauli-Z on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCZ(CST control, CST target){
+        applyNamedControlledGate(getGateZ(), control, target, "Z");
+    }
+
+    /**
+     * @brief Apply Controlled Hadamard on target qubit
+     *
+     * @param control Qubit index acting as control
+     * @param target Qubit index acting as target
+     */
+    inline void applyGateCH(CST control, CST target){
+        applyNamedControlledGate(getGateH(), control, target, "H");
+    }
+
+    /**
+     * @brief Perform controlled phase shift gate
+     *
+     * @param angle Angle of phase shift in rads
+     * @param control Index of control qubit
+     * @param target Index of target qubit
+     */
+    inline void applyGateCPhaseShift(double angle, unsigned int control, unsigned int target){
+        TMDP U(gates[3]);
+        U(1, 1) = ComplexDP(cos(angle), sin(angle));
+        applyNamedControlledGate(U, control, target, "CPhase");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about X-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about X-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotX(CST control, CST target, const double theta){
+        applyNamedControlledGate(getGateRotation('X', theta), control, target, "CR_X");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about Y-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about Y-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotY(CST control, CST target, double theta){
+        applyNamedControlledGate(getGateRotation('Y', theta), control, target, "CR_Y");
+    }
+
+    /**
+     * @brief Apply the given Controlled Rotation about Z-axis to the given qubit
+     *
+     * @param control Control qubit
+     * @param target Index of qubit to rotate about Z-axis
+     * @param theta Rotation angle
+     */
+    inline void applyGateCRotZ(CST control, CST target, const double theta){
+        applyNamedControlledGate(getGateRotation('Z', theta), control, target, "CR_Z");
+    }
+
+    /**
+     * @brief Swap the qubits at the given indices. The swap is applied as a relabelling of the logical to physical qubit map, without modifying any site tensors.
+     *
+     * @param qubit_idx0 Index of qubit 0 to swap &(0 -> 1)
+     * @param qubit_idx1 Index of qubit 1 to swap &(1 -> 0)
+     */
+    inline void applyGateSwap(CST qubit_idx0, CST qubit_idx1){
+        #ifndef RESOURCE_ESTIMATE
+        std::swap(qubit_map[qubit_idx0], qubit_map[qubit_idx1]);
+        #endif
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( "SWAP", getGateI().tostr(), qubit_idx0, qubit_idx1 );
+        #endif
+    }
+
+    // 3 qubit
+    /**
+     * @brief Controlled controlled NOT (CCNOT, CCX) gate
+     *
+     * @param ctrl_qubit0 Control qubit 0
+     * @param ctrl_qubit1 Control qubit 1
+     * @param target_qubit Target qubit
+     */
+    inline void applyGateCCX(std::size_t ctrl_qubit0, std::size_t ctrl_qubit1, std::size_t target_qubit){
+        this->applyGateNCU(this->getGateX(), std::vector<std::size_t> {ctrl_qubit0, ctrl_qubit1}, target_qubit, "X");
+    }
+
+    /**
+     * @brief Controlled SWAP gate (Controlled swap decomposition taken from arXiV:1301.3727)
+     *
+     * @param ctrl_qubit Control qubit
+     * @param qubit_swap0 Swap qubit 0
+     * @param qubit_swap1 Swap qubit 1
+     */
+    inline void applyGateCSwap(std::size_t ctrl_qubit, std::size_t qubit_swap0, std::size_t qubit_swap1){
+        //V = sqrt(X)
+        TMDP V = getGateSqrtX();
+        TMDP V_dag = this->adjointMatrix(V);
+
+        applyGateCX(qubit_swap1, qubit_swap0);
+        applyGateCU(V, qubit_swap0, qubit_swap1, "X");
+        applyGateCU(V, ctrl_qubit, qubit_swap1, "X");
+
+        applyGateCX(ctrl_qubit, qubit_swap0);
+        applyGateCU(V_dag, qubit_swap0, qubit_swap1, "X");
+        applyGateCX(qubit_swap1, qubit_swap0);
+        applyGateCX(ctrl_qubit, qubit_swap0);
+    }
+
+    /**
+     * @brief Get the number of Qubits
+     *
+     * @return std::size_t Number of qubits in register
+     */
+    std::size_t getNumQubits() {
+        return numQubits;
+    }
+
+    /**
+     * @brief (Re)Initialise the MPS to the product state |0....0>, with all bond dimensions 1
+     *
+     */
+    void initRegister(){
+        resetState();
+        this->initCaches();
+        gate_count_1qubit = 0;
+        gate_count_2qubit = 0;
+        std::fill(target_usage.begin(), target_usage.end(), 0);
+    }
+
+    /**
+     * @brief (Re)Initialise the MPS to the product state |0....0>, and restart the measurement random stream at the given seed and shot; see setRandomSeed
+     *
+     * @param seed Seed of the stream
+     * @param shot Index of the stream under the seed
+     */
+    void initRegister(std::uint64_t seed, std::uint64_t shot=0){
+        initRegister();
+        setRandomSeed(seed, shot);
+    }
+
+    /**
+     * @brief Apply normalization to the amplitudes of each state. The norm of the MPS is held in the orthogonality centre, which alone is rescaled.
+     *
+     */
+    inline void applyAmplitudeNorm(){
+        auto& A = tensors[center];
+        double norm = 0.;
+        for(const auto& a : A){
+            norm += std::norm(a);
+        }
+        const double scale = 1. / std::sqrt(norm);
+        for(auto& a : A){
+            a *= scale;
+        }
+    }
+
+    /**
+     * @brief Apply measurement to a target qubit, randomly collapsing the qubit proportional to the amplitude and returns the collapsed value.
+     *
+     * @return bool Value that qubit is randomly collapsed to
+     * @param target The index of the qubit being collapsed
+     * @param normalize Optional argument specifying whether amplitudes should be normalized (true) or not (false). Default value is true.
+     */
+    bool applyMeasurement(CST target, bool normalize=true){
+        bool bit_val;
+        collapseQubit(target, (bit_val = ( randomUniform() < getStateProbability(target) ) ) );
+        if(normalize){
+            applyAmplitudeNorm();
+        }
+        return bit_val;
+    }
+
+    /**
+     * @brief Seed the random stream used by measurements and sampling, making subsequent outcomes reproducible. Draw d after seeding is the Philox counter-based number of (seed, shot, d).
+     *
+     * @param seed Seed of the stream
+     * @param shot Index of the stream under the seed
+     */
+    void setRandomSeed(std::uint64_t seed, std::uint64_t shot=0){
+        rng.seed(seed, shot);
+    }
+
+    /**
+     * @brief Get the seed of the measurement random stream, as given to the constructor or setRandomSeed or drawn from the system entropy source
+     *
+     * @return std::uint64_t Seed of the stream
+     */
+    std::uint64_t getRandomSeed() const {
+        return rng.getSeed();
+    }
+
+    /**
+     * @brief Apply measurement to a target qubit with respect to the Z-basis, collapsing to a specified value (0 or 1). Amplitudes are r-normalized afterwards.
+     *
+     * @param target The index of the qubit being collapsed
+     * @param collapseValue The value that the register will be collapsed to (either 0 ro 1).
+     */
+    void collapseToBasisZ(CST target, bool collapseValue){
+        collapseQubit(target, collapseValue);
+        applyAmplitudeNorm();
+    }
+
+    /**
+     * @brief Get the probability of the specified qubit being in the state |1>. The orthogonality centre is first moved to the qubit's site, after which the probability is local to its tensor.
+     *
+     * @param target Target qubit
+     * @return double Probability that the target qubit is in the state |1>
+     */
+    inline double getStateProbability(CST target){
+        const std::size_t site = qubit_map[target];
+        moveCenter(site);
+        const auto& A = tensors[site];
+        const std::size_t dl = bond_dims[site], dr = bond_dims[site+1];
+        double probability = 0.;
+        for(std::size_t a = 0; a < dl; a++){
+            for(std::size_t b = 0; b < dr; b++){
+                probability += std::norm(A[(2*a + 1)*dr + b]);
+            }
+        }
+        return probability;
+    }
+
+    /**
+     * @brief Sample a basis state of the full register without collapsing the state. Each site is sampled in turn, conditioned on the values drawn for the preceding sites, in O(n chi^2) operations for bond dimension chi.
+     *
+     * @return std::vector<bool> Sampled value of each qubit, indexed by qubit
+     */
+    std::vector<bool> sample(){
+        moveCenter(0);
+
+        std::vector<double> rand(numQubits);
+        for(auto& r : rand){
+            r = randomUniform();
+        }
+
+        std::vector<bool> site_bits(numQubits);
+        std::vector<ComplexDP> left(1, ComplexDP(1.,0.));
+        for(std::size_t site = 0; site < numQubits; site++){
+            std::vector<ComplexDP> v0 = contractLeft(left, site, 0), v1 = contractLeft(left, site, 1);
+            double p0 = 0., p1 = 0.;
+            for(std::size_t b = 0; b < v0.size(); b++){
+                p0 += std::norm(v0[b]);
+                p1 += std::norm(v1[b]);
+            }
+            // Sites to the right of the centre are right-orthonormal, so the conditional probabilities are given by the norms of the partial contractions
+            site_bits[site] = rand[site] * (p0 + p1) < p1;
+            left = site_bits[site] ? std::move(v1) : std::move(v0);
+            const double scale = 1. / std::sqrt(site_bits[site] ? p1 : p0);
+            for(auto& l : left){
+                l *= scale;
+            }
+        }
+
+        std::vector<bool> bits(numQubits);
+        for(std::size_t q = 0; q < numQubits; q++){
+            bits[q] = site_bits[qubit_map[q]];
+        }
+        return bits;
+    }
+
+    /**
+     * @brief Get the amplitude of the given basis state, contracting the MPS along the chain. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience and debugging/testing.
+     *
+     * @param basis_state Basis state, with bit q the value of qubit q; requires at most 64 qubits
+     * @return ComplexDP Amplitude of the basis state
+     */
+    ComplexDP getAmplitude(std::size_t basis_state){
+        assert(numQubits <= 8*sizeof(std::size_t));
+        std::vector<ComplexDP> left(1, ComplexDP(1.,0.));
+        for(std::size_t site = 0; site < numQubits; site++){
+            left = contractLeft(left, site, IS_SET(basis_state, siteQubit(site)));
+        }
+        return left[0];
+    }
+
+    /**
+     * @brief Prints the string x and then each basis state with non-negligible probability, followed by its amplitude and probability. Basis states are enumerated depth first along the chain, pruning any prefix of negligible probability, so the output is linear in the number of qubits for a state of few patterns. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience and debugging/testing.
+     *
+     * @param x String to be printed to stdout
+     * @param qubits Indices of qubits printed in each basis state; all qubits if empty
+     */
+    inline void PrintStates(std::string x, std::vector<std::size_t> qubits = {}){
+        if(qubits.empty()){
+            qubits.resize(numQubits);
+            std::iota(qubits.begin(), qubits.end(), 0);
+        }
+        moveCenter(0);
+        std::cout << x << std::endl;
+
+        std::vector<bool> site_bits(numQubits);
+        printBranch(std::vector<ComplexDP>(1, ComplexDP(1.,0.)), 0, site_bits, qubits);
+    }
+
+    #ifdef GATE_LOGGING
+    /**
+     * @brief Get the Gate Writer object
+     *
+     * @return GateWriter& Returns reference to the writer member in the class
+     */
+    GateWriter& getGateWriter(){
+        return this->writer;
+    }
+    #endif
+
+    /**
+     * @brief Print 1 and 2 qubit gate call counts.
+     *
+     */
+    std::pair<std::size_t, std::size_t> getGateCounts(){
+        std::cout << "######### Gate counts #########" << std::endl;
+        std::cout << "1 qubit = " << gate_count_1qubit << std::endl;
+        std::cout << "2 qubit = " << gate_count_2qubit << std::endl;
+        std::cout << "total = " << gate_count_1qubit + gate_count_2qubit << std::endl;
+        std::cout << "###############################" << std::endl;
+        return std::make_pair(gate_count_1qubit, gate_count_2qubit);
+    }
+
+    /**
+     * @brief Get the number of gates applied with each qubit as target since the register was (re)initialised. These may be passed to QubitLayout to choose a qubit layout.
+     *
+     * @return const std::vector<std::size_t>& Number of gates targeting each qubit index
+     */
+    const std::vector<std::size_t>& getQubitUsage() const {
+        return target_usage;
+    }
+
+    /**
+     * @brief Get the logical to physical qubit map; qubit q is held at site getQubitMap()[q] of the MPS
+     *
+     * @return const std::vector<std::size_t>& The qubit map
+     */
+    const std::vector<std::size_t>& getQubitMap() const {
+        return qubit_map;
+    }
+
+    /**
+     * @brief Get the dimension of each bond of the MPS, between sites i and i+1
+     *
+     * @return std::vector<std::size_t> The numQubits-1 bond dimensions
+     */
+    std::vector<std::size_t> getBondDimensions() const {
+        return std::vector<std::size_t>(bond_dims.begin() + 1, bond_dims.end() - 1);
+    }
+
+    /**
+     * @brief Set the maximum bond dimension kept after each SVD. Bounding the bond dimension bounds the memory and time per gate, at the cost of a truncation error.
+     *
+     * @param maxBondDim Maximum bond dimension; 0 leaves the bond dimension unbounded
+     */
+    void setMaxBondDimension(std::size_t maxBondDim){
+        max_bond_dim = maxBondDim;
+    }
+
+    /**
+     * @brief Set the relative cutoff below which singular values are discarded
+     *
+     * @param cutoff Singular values whose squared weight relative to the total falls below cutoff are discarded
+     */
+    void setTruncationCutoff(double cutoff){
+        truncation_cutoff = cutoff;
+    }
+
+    /**
+     * @brief Get the total weight discarded by truncation since the register was (re)initialised. The sum of the discarded weights bounds the infidelity 1 - |<psi|psi_exact>|^2 of the state to first order.
+     *
+     * @return double Sum of the relative squared singular values discarded over all SVDs
+     */
+    double getTruncationError() const {
+        return truncation_error;
+    }
+
+    private:
+    std::size_t numQubits = 0;
+    std::size_t max_bond_dim;
+    double truncation_cutoff;
+    double truncation_error;
+    std::vector<TMDP> gates;
+
+    //Site tensors, with element (a, s, b) of tensor i held at index (2*a + s)*bond_dims[i+1] + b
+    std::vector<std::vector<ComplexDP>> tensors;
+    //Bond dimensions; bond_dims[i] is the dimension of the bond to the left of site i, with bond_dims[0] = bond_dims[numQubits] = 1
+    std::vector<std::size_t> bond_dims;
+    //Orthogonality centre; sites to its left are left-orthonormal, and sites to its right right-orthonormal
+    std::size_t center;
+    std::vector<std::size_t> qubit_map;
+
+    std::size_t gate_count_1qubit;
+    std::size_t gate_count_2qubit;
+    std::vector<std::size_t> target_usage;
+
+    //Measurement random stream, keyed by (seed, shot, draw index)
+    PhiloxStream rng;
+
+    //Maximum number of Jacobi sweeps per SVD
+    static constexpr std::size_t max_svd_sweeps = 64;
+
+    /**
+     * @brief Reset the MPS to the product state |0...0> and the qubit map to the identity
+     */
+    void resetState(){
+        tensors.assign(numQubits, std::vector<ComplexDP> {ComplexDP(1.,0.), ComplexDP(0.,0.)});
+        bond_dims.assign(numQubits + 1, 1);
+        center = 0;
+        qubit_map.resize(numQubits);
+        std::iota(qubit_map.begin(), qubit_map.end(), 0);
+        truncation_error = 0.;
+    }
+
+    /**
+     * @brief Add a gate targeting the given qubit to the usage counts
+     */
+    inline void countTargetUsage(std::size_t qubit){
+        target_usage[qubit]++;
+    }
+
+    /**
+     * @brief Get the qubit held at the given site
+     */
+    std::size_t siteQubit(std::size_t site) const {
+        return std::find(qubit_map.begin(), qubit_map.end(), site) - qubit_map.begin();
+    }
+
+    /**
+     * @brief Draw a uniform random number in [0,1); every rank draws the same number from the same stream position
+     */
+    double randomUniform(){
+        return rng.uniform();
+    }
+
+    /**
+     * @brief Apply a single qubit gate with the given label, counting and logging it
+     */
+    inline void applyNamedGate(const TMDP& U, CST qubitIndex, const std::string& label){
+        #ifndef RESOURCE_ESTIMATE
+        applySiteMatrix(U, qubit_map[qubitIndex]);
+        #endif
+
+        gate_count_1qubit++;
+        countTargetUsage(qubitIndex);
+
+        #ifdef GATE_LOGGING
+        this->writer.oneQubitGateCall(label, U.tostr(), qubitIndex);
+        #endif
+    }
+
+    /**
+     * @brief Apply a controlled single qubit gate with the given label, counting and logging it
+     */
+    inline void applyNamedControlledGate(const TMDP& U, CST control, CST target, const std::string& label){
+        assert(control != target);
+
+        #ifndef RESOURCE_ESTIMATE
+        // Index k = 2*b1 + b0, with b0 the target and b1 the control
+        TM4DP CU = identity4();
+        CU(2,2) = U(0,0);   CU(2,3) = U(0,1);
+        CU(3,2) = U(1,0);   CU(3,3) = U(1,1);
+        // Controlled gates are symmetric in neither qubit, so the target is passed as the low bit
+        applyTwoQubitMatrix(CU, target, control);
+        #endif
+
+        gate_count_2qubit++;
+        countTargetUsage(target);
+
+        #ifdef GATE_LOGGING
+        this->writer.twoQubitGateCall( label, U.tostr(), control, target );
+        #endif
+    }
+
+    /**
+     * @brief Get the 4x4 identity matrix
+     */
+    static TM4DP identity4(){
+        TM4DP U;
+        for(std::size_t i = 0; i < 4; i++){
+            for(std::size_t j = 0; j < 4; j++){
+                U(i,j) = ComplexDP(i == j ? 1. : 0., 0.);
+            }
+        }
+        return U;
+    }
+
+    /**
+     * @brief Apply the 2x2 matrix U to the physical index of the given site. Unitary gates preserve the canonical form.
+     */
+    void applySiteMatrix(const TMDP& U, std::size_t site){
+        auto& A = tensors[site];
+        const std::size_t dl = bond_dims[site], dr = bond_dims[site+1];
+        for(std::size_t a = 0; a < dl; a++){
+            ComplexDP* A0 = &A[(2*a)*dr];
+            ComplexDP* A1 = &A[(2*a + 1)*dr];
+            for(std::size_t b = 0; b < dr; b++){
+                const ComplexDP a0 = A0[b], a1 = A1[b];
+                A0[b] = U(0,0)*a0 + U(0,1)*a1;
+                A1[b] = U(1,0)*a0 + U(1,1)*a1;
+            }
+        }
+    }
+
+    /**
+     * @brief Apply the two qubit matrix U to the given qubits, with index k = 2*b1 + b0 for b0, b1 the values of qubit_idx0, qubit_idx1. The qubit held at the higher site is first routed down the chain with SWAPs to the site adjacent to the other qubit, and left there.
+     */
+    void applyTwoQubitMatrix(const TM4DP& U, CST qubit_idx0, CST qubit_idx1){
+        const std::size_t lo = std::min(qubit_map[qubit_idx0], qubit_map[qubit_idx1]);
+        const std::size_t hi = std::max(qubit_map[qubit_idx0], qubit_map[qubit_idx1]);
+        for(std::size_t site = hi - 1; site > lo; site--){
+            swapSites(site);
+        }
+
+        // Two-site matrices are indexed by s_lo + 2*s_hi
+        ComplexDP G[16];
+        const bool reversed = qubit_map[qubit_idx0] != lo;
+        for(std::size_t i = 0; i < 4; i++){
+            for(std::size_t j = 0; j < 4; j++){
+                G[4*i + j] = reversed ? U(swapBits(i), swapBits(j)) : U(i, j);
+            }
+        }
+        applyTwoSiteMatrix(G, lo, false);
+    }
+
+    /**
+     * @brief Exchange the bits of a two-bit index
+     */
+    static inline std::size_t swapBits(std::size_t k){
+        return ((k & 0b1) << 1) | (k >> 1);
+    }
+
+    /**
+     * @brief Swap the qubits held at sites site and site+1, updating the qubit map. The orthogonality centre is left at site, as routing proceeds down the chain.
+     */
+    void swapSites(std::size_t site){
+        static const ComplexDP swap_matrix[16] = {
+            {1.,0.}, {0.,0.}, {0.,0.}, {0.,0.},
+            {0.,0.}, {0.,0.}, {1.,0.}, {0.,0.},
+            {0.,0.}, {1.,0.}, {0.,0.}, {0.,0.},
+            {0.,0.}, {0.,0.}, {0.,0.}, {1.,0.}
+        };
+        applyTwoSiteMatrix(swap_matrix, site, true);
+        std::swap(qubit_map[siteQubit(site)], qubit_map[siteQubit(site + 1)]);
+    }
+
+    /**
+     * @brief Apply the 4x4 row-major matrix G, indexed by s_site + 2*s_{site+1}, to the adjacent sites site and site+1. The two site tensors are contracted, the matrix applied, and the result split again with a truncated SVD.
+     *
+     * @param G Two-site matrix
+     * @param site Lower of the two sites
+     * @param center_left Leave the orthogonality centre at site (true), or at site+1 (false)
+     */
+    void applyTwoSiteMatrix(const ComplexDP* G, std::size_t site, bool center_left){
+        // The centre must be within the two sites for the SVD to give the Schmidt decomposition
+        if(center < site){
+            moveCenter(site);
+        }
+        else if(center > site + 1){
+            moveCenter(site + 1);
+        }
+
+        const std::size_t dl = bond_dims[site], dm = bond_dims[site+1], dr = bond_dims[site+2];
+        std::vector<ComplexDP> theta = matmul(tensors[site], 2*dl, dm, tensors[site+1], 2*dr);
+
+        // theta is held as a (2*dl) x (2*dr) matrix, with element (2*a + s0, dr*s1 + b)
+        for(std::size_t a = 0; a < dl; a++){
+            for(std::size_t b = 0; b < dr; b++){
+                ComplexDP v[4], w[4];
+                for(std::size_t k = 0; k < 4; k++){
+                    v[k] = theta[(2*a + (k & 0b1))*2*dr + dr*(k >> 1) + b];
+                }
+                for(std::size_t i = 0; i < 4; i++){
+                    w[i] = G[4*i]*v[0] + G[4*i + 1]*v[1] + G[4*i + 2]*v[2] + G[4*i + 3]*v[3];
+                }
+                for(std::size_t k = 0; k < 4; k++){
+                    theta[(2*a + (k & 0b1))*2*dr + dr*(k >> 1) + b] = w[k];
+                }
+            }
+        }
+
+        std::vector<ComplexDP> U, Vh;
+        std::vector<double> S;
+        const std::size_t k = truncatedSVD(theta, 2*dl, 2*dr, U, S, Vh);
+        if(center_left){
+            scaleColumns(U, 2*dl, S);
+            center = site;
+        }
+        else{
+            scaleRows(Vh, 2*dr, S);
+            center = site + 1;
+        }
+        tensors[site] = std::move(U);
+        tensors[site+1] = std::move(Vh);
+        bond_dims[site+1] = k;
+    }
+
+    /**
+     * @brief Move the orthogonality centre to the given site. Each step splits the centre tensor with an SVD, keeping the orthonormal factor in place and absorbing the remainder into the neighbouring site.
+     */
+    void moveCenter(std::size_t site){
+        std::vector<ComplexDP> U, Vh;
+        std::vector<double> S;
+        while(center < site){
+            const std::size_t dl = bond_dims[center], dr = bond_dims[center+1], dr_next = bond_dims[center+2];
+            const std::size_t k = truncatedSVD(tensors[center], 2*dl, dr, U, S, Vh);
+            scaleRows(Vh, dr, S);
+            tensors[center] = std::move(U);
+            tensors[center+1] = matmul(Vh, k, dr, tensors[center+1], 2*dr_next);
+            bond_dims[center+1] = k;
+            center++;
+        }
+        while(center > site){
+            const std::size_t dl_prev = bond_dims[center-1], dl = bond_dims[center], dr = bond_dims[center+1];
+            const std::size_t k = truncatedSVD(tensors[center], dl, 2*dr, U, S, Vh);
+            scaleColumns(U, dl, S);
+            tensors[center] = std::move(Vh);
+            tensors[center-1] = matmul(tensors[center-1], 2*dl_prev, dl, U, k);
+            bond_dims[center] = k;
+            center--;
+        }
+    }
+
+    /**
+     * @brief Project the given qubit onto the given value, without normalization
+     */
+    void collapseQubit(CST target, bool collapseValue){
+        const std::size_t site = qubit_map[target];
+        moveCenter(site);
+        auto& A = tensors[site];
+        const std::size_t dl = bond_dims[site], dr = bond_dims[site+1];
+        for(std::size_t a = 0; a < dl; a++){
+            std::fill_n(&A[(2*a + !collapseValue)*dr], dr, ComplexDP(0.,0.));
+        }
+    }
+
+    /**
+     * @brief Contract the left environment vector with the given site tensor at physical index s
+     */
+    std::vector<ComplexDP> contractLeft(const std::vector<ComplexDP>& left, std::size_t site, bool s){
+        const auto& A = tensors[site];
+        const std::size_t dl = bond_dims[site], dr = bond_dims[site+1];
+        std::vector<ComplexDP> out(dr, ComplexDP(0.,0.));
+        for(std::size_t a = 0; a < dl; a++){
+            const ComplexDP* As = &A[(2*a + s)*dr];
+            for(std::size_t b = 0; b < dr; b++){
+                out[b] += left[a] * As[b];
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Print the basis states extending the given prefix of site values, depth first. Requires the orthogonality centre at site 0.
+     */
+    void printBranch(const std::vector<ComplexDP>& left, std::size_t site, std::vector<bool>& site_bits, const std::vector<std::size_t>& qubits){
+        if(site == numQubits){
+            std::string state;
+            for(auto q : qubits){
+                state += site_bits[qubit_map[q]] ? '1' : '0';
+            }
+            std::cout << left[0] << "\t|" << state << ">\t" << std::norm(left[0]) << std::endl;
+            return;
+        }
+        for(bool s : {false, true}){
+            std::vector<ComplexDP> v = contractLeft(left, site, s);
+            double p = 0.;
+            for(const auto& x : v){
+                p += std::norm(x);
+            }
+            // With the right sites orthonormal, p is the probability of the prefix
+            if(p > 1e-12){
+                site_bits[site] = s;
+                printBranch(v, site + 1, site_bits, qubits);
+            }
+        }
+    }
+
+    /**
+     * @brief Row-major product of the (rows x inner) matrix A with the (inner x cols) matrix B
+     */
+    static std::vector<ComplexDP> matmul(const std::vector<ComplexDP>& A, std::size_t rows, std::size_t inner, const std::vector<ComplexDP>& B, std::size_t cols){
+        std::vector<ComplexDP> C(rows*cols, ComplexDP(0.,0.));
+        for(std::size_t i = 0; i < rows; i++){
+            for(std::size_t k = 0; k < inner; k++){
+                const ComplexDP a = A[i*inner + k];
+                if(a == ComplexDP(0.,0.)){
+                    continue;
+                }
+                for(std::size_t j = 0; j < cols; j++){
+                    C[i*cols + j] += a * B[k*cols + j];
+                }
+            }
+        }
+        return C;
+    }
+
+    /**
+     * @brief Scale column j of the row-major (rows x S.size()) matrix U by S[j]
+     */
+    static void scaleColumns(std::vector<ComplexDP>& U, std::size_t rows, const std::vector<double>& S){
+        for(std::size_t i = 0; i < rows; i++){
+            for(std::size_t j = 0; j < S.size(); j++){
+                U[i*S.size() + j] *= S[j];
+            }
+        }
+    }
+
+    /**
+     * @brief Scale row j of the row-major (S.size() x cols) matrix Vh by S[j]
+     */
+    static void scaleRows(std::vector<ComplexDP>& Vh, std::size_t cols, const std::vector<double>& S){
+        for(std::size_t j = 0; j < S.size(); j++){
+            for(std::size_t i = 0; i < cols; i++){
+                Vh[j*cols + i] *= S[j];
+            }
+        }
+    }
+
+    /**
+     * @brief One-sided Jacobi (Hestenes) orthogonalisation of the columns of the column-major (m x n) matrix W, accumulating the rotations into the column-major (n x n) matrix V such that W_in V = W_out. On return, the columns of W are orthogonal with norms the singular values.
+     */
+    static void jacobiOrthogonalise(std::vector<ComplexDP>& W, std::size_t m, std::size_t n, std::vector<ComplexDP>& V){
+        V.assign(n*n, ComplexDP(0.,0.));
+        for(std::size_t j = 0; j < n; j++){
+            V[j*n + j] = ComplexDP(1.,0.);
+        }
+
+        const double tol = 1e-15;
+        for(std::size_t sweep = 0; sweep < max_svd_sweeps; sweep++){
+            bool rotated = false;
+            for(std::size_t p = 0; p + 1 < n; p++){
+                for(std::size_t q = p + 1; q < n; q++){
+                    ComplexDP* wp = &W[p*m];
+                    ComplexDP* wq = &W[q*m];
+                    double alpha = 0., beta = 0.;
+                    ComplexDP gamma(0.,0.);
+                    for(std::size_t i = 0; i < m; i++){
+                        alpha += std::norm(wp[i]);
+                        beta += std::norm(wq[i]);
+                        gamma += std::conj(wp[i]) * wq[i];
+                    }
+                    const double g = std::abs(gamma);
+                    if(g == 0. || g <= tol * std::sqrt(alpha * beta)){
+                        continue;
+                    }
+                    rotated = true;
+
+                    // Rotate column q by the phase of gamma, then zero the (real) inner product with a Jacobi rotation
+                    const ComplexDP phase = std::conj(gamma) / g;
+                    const double zeta = (beta - alpha) / (2. * g);
+                    const double t = (zeta >= 0. ? 1. : -1.) / (std::abs(zeta) + std::sqrt(1. + zeta*zeta));
+                    const double c = 1. / std::sqrt(1. + t*t), s = c * t;
+                    for(std::size_t i = 0; i < m; i++){
+                        const ComplexDP x = wp[i], y = wq[i] * phase;
+                        wp[i] = c*x - s*y;
+                        wq[i] = s*x + c*y;
+                    }
+                    ComplexDP* vp = &V[p*n];
+                    ComplexDP* vq = &V[q*n];
+                    for(std::size_t i = 0; i < n; i++){
+                        const ComplexDP x = vp[i], y = vq[i] * phase;
+                        vp[i] = c*x - s*y;
+                        vq[i] = s*x + c*y;
+                    }
+                }
+            }
+            if(!rotated){
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Compute the SVD M = U S Vh of the row-major (rows x cols) matrix M, keeping the k largest singular values permitted by the truncation cutoff and maximum bond dimension. The kept singular values are rescaled to preserve the norm of M, and the relative discarded weight added to the truncation error.
+     *
+     * @param M Matrix to decompose
+     * @param rows Number of rows of M
+     * @param cols Number of columns of M
+     * @param U Row-major (rows x k) matrix of left singular vectors
+     * @param S Kept singular values, in decreasing order
+     * @param Vh Row-major (k x cols) matrix of conjugated right singular vectors
+     * @return std::size_t Number of singular values k kept
+     */
+    std::size_t truncatedSVD(const std::vector<ComplexDP>& M, std::size_t rows, std::size_t cols,
+                             std::vector<ComplexDP>& U, std::vector<double>& S, std::vector<ComplexDP>& Vh){
+        // Orthogonalise the columns of M, or of M^dagger if M is wide, so that the rotations act on the shorter dimension
+        const bool wide = rows < cols;
+        const std::size_t m = wide ? cols : rows, n = wide ? rows : cols;
+        std::vector<ComplexDP> W(m*n), V;
+        for(std::size_t i = 0; i < rows; i++){
+            for(std::size_t j = 0; j < cols; j++){
+                if(wide){
+                    W[i*m + j] = std::conj(M[i*cols + j]);
+                }
+                else{
+                    W[j*m + i] = M[i*cols + j];
+                }
+            }
+        }
+        jacobiOrthogonalise(W, m, n, V);
+
+        std::vector<double> sigma(n);
+        double total = 0.;
+        for(std::size_t j = 0; j < n; j++){
+            double norm = 0.;
+            for(std::size_t i = 0; i < m; i++){
+                norm += std::norm(W[j*m + i]);
+            }
+            sigma[j] = std::sqrt(norm);
+            total += norm;
+        }
+        std::vector<std::size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sigma](std::size_t a, std::size_t b){ return sigma[a] > sigma[b]; });
+
+        std::size_t k = 0;
+        double kept = 0.;
+        while(k < n && (max_bond_dim == 0 || k < max_bond_dim)){
+            const double weight = sigma[order[k]] * sigma[order[k]];
+            if(weight == 0. || weight < truncation_cutoff * total){
+                break;
+            }
+            kept += weight;
+            k++;
+        }
+        if(k == 0){
+            // A zero matrix keeps a single (zero) singular value
+            k = 1;
+        }
+        else{
+            truncation_error += (total - kept) / total;
+        }
+        const double scale = kept > 0. ? std::sqrt(total / kept) : 1.;
+
+        // M = W V^dagger; for a wide matrix, M^dagger = W V^dagger and so M = V W^dagger
+        S.resize(k);
+        U.assign(rows*k, ComplexDP(0.,0.));
+        Vh.assign(k*cols, ComplexDP(0.,0.));
+        for(std::size_t l = 0; l < k; l++){
+            const std::size_t j = order[l];
+            S[l] = sigma[j] * scale;
+            const double inv_sigma = sigma[j] > 0. ? 1. / sigma[j] : 0.;
+            if(wide){
+                for(std::size_t i = 0; i < rows; i++){
+                    U[i*k + l] = V[j*n + i];
+                }
+                for(std::size_t i = 0; i < cols; i++){
+                    Vh[l*cols + i] = std::conj(W[j*m + i]) * inv_sigma;
+                }
+            }
+            else{
+                for(std::size_t i = 0; i < rows; i++){
+                    U[i*k + l] = W[j*m + i] * inv_sigma;
+                }
+                for(std::size_t i = 0; i < cols; i++){
+                    Vh[l*cols + i] = std::conj(V[j*n + i]);
+                }
+            }
+        }
+        return k;
+    }
+};
+
+};
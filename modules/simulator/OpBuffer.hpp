@@ -0,0 +1,157 @@
+/**
+ * @file OpBuffer.hpp
+ * @brief Packed gate buffers, submitted to a simulator as a single call with applyOps
+ * @version 0.1
+ */
+
+#ifndef QNLP_OP_BUFFER
+#define QNLP_OP_BUFFER
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace QNLP{
+    /**
+     * @brief Operation codes of the gates held in an OpBuffer
+     */
+    enum class OpCode : std::uint32_t {
+        // 1 qubit: q0 is the target, param the angle of rotation and phase shift gates
+        I, X, Y, Z, H, SqrtX, RotX, RotY, RotZ, PhaseShift,
+        // 2 qubit: q0 is the control and q1 the target, or the swapped qubits
+        CX, CY, CZ, CH, CRotX, CRotY, CRotZ, CPhaseShift, Swap, SqrtSwap,
+        // 3 qubit: q0, q1 are the controls and q2 the target of CCX; q0 is the control and q1, q2 the swapped qubits of CSwap
+        CCX, CSwap,
+        // Reset of q0 to |0>
+        Reset
+    };
+
+    /**
+     * @brief A single gate of an OpBuffer. The layout is fixed, so that buffers may be filled in place from other languages (e.g. as a numpy structured array).
+     */
+    struct Op {
+        std::uint32_t code;
+        std::uint32_t q0;
+        std::uint32_t q1;
+        std::uint32_t q2;
+        double param;
+    };
+
+    /**
+     * @brief Get the number of qubits acted upon by the given operation
+     */
+    inline std::size_t getNumOpQubits(OpCode code){
+        if(code >= OpCode::CCX && code <= OpCode::CSwap){
+            return 3;
+        }
+        if(code >= OpCode::CX && code <= OpCode::SqrtSwap){
+            return 2;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Check whether the given operation is a unitary single qubit gate
+     */
+    inline bool isSingleQubitGate(OpCode code){
+        return code <= OpCode::PhaseShift;
+    }
+
+    /**
+     * @brief Check that each of the given operations has a known code, and acts on distinct qubits of a register of num_qubits qubits
+     *
+     * @param ops Pointer to the first operation
+     * @param num_ops Number of operations
+     * @param num_qubits Number of qubits of the register
+     * @throws std::invalid_argument naming the first invalid operation
+     */
+    inline void validateOps(const Op* ops, std::size_t num_ops, std::size_t num_qubits){
+        for(std::size_t i = 0; i < num_ops; i++){
+            const Op& op = ops[i];
+            if(op.code > static_cast<std::uint32_t>(OpCode::Reset)){
+                throw std::invalid_argument("Operation " + std::to_string(i) + ": unknown operation code " + std::to_string(op.code));
+            }
+            const std::size_t num_op_qubits = getNumOpQubits(static_cast<OpCode>(op.code));
+            const std::uint32_t q[3] = {op.q0, op.q1, op.q2};
+            for(std::size_t j = 0; j < num_op_qubits; j++){
+                if(q[j] >= num_qubits){
+                    throw std::invalid_argument("Operation " + std::to_string(i) + ": qubit " + std::to_string(q[j]) + " out of range");
+                }
+                for(std::size_t k = 0; k < j; k++){
+                    if(q[k] == q[j]){
+                        throw std::invalid_argument("Operation " + std::to_string(i) + ": repeated qubit " + std::to_string(q[j]));
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Class definition of a packed buffer of gates, applied back-to-back by applyOps without a call through the simulator interface per gate.
+     */
+    class OpBuffer{
+        public:
+        /**
+         * @brief Construct a new empty OpBuffer object
+         */
+        OpBuffer(){};
+
+        /**
+         * @brief Append the given operation to the buffer
+         *
+         * @param code Operation code
+         * @param qubits Qubits of the operation, in the order q0, q1, q2
+         * @param param Angle of the operation, if any
+         * @return OpBuffer& The buffer, so that operations may be chained
+         * @throws std::invalid_argument if the number of qubits does not match the operation
+         */
+        OpBuffer& add(OpCode code, std::initializer_list<std::size_t> qubits, double param = 0.){
+            if(qubits.size() != getNumOpQubits(code)){
+                throw std::invalid_argument("Operation code " + std::to_string(static_cast<std::uint32_t>(code)) + " takes " + std::to_string(getNumOpQubits(code)) + " qubits, " + std::to_string(qubits.size()) + " given");
+            }
+            std::uint32_t q[3] = {0, 0, 0};
+            std::size_t i = 0;
+            for(auto qubit : qubits){
+                q[i++] = static_cast<std::uint32_t>(qubit);
+            }
+            ops.push_back({static_cast<std::uint32_t>(code), q[0], q[1], q[2], param});
+            return *this;
+        }
+
+        /**
+         * @brief Remove all operations from the buffer, keeping its storage for reuse
+         */
+        void clear(){
+            ops.clear();
+        }
+
+        /**
+         * @brief Reserve storage for the given number of operations
+         */
+        void reserve(std::size_t num_ops){
+            ops.reserve(num_ops);
+        }
+
+        /**
+         * @brief Get the packed operations of the buffer
+         */
+        const Op* data() const {
+            return ops.data();
+        }
+
+        /**
+         * @brief Get the number of operations in the buffer
+         */
+        std::size_t size() const {
+            return ops.size();
+        }
+
+        private:
+        std::vector<Op> ops;
+    };
+};
+
+#endif
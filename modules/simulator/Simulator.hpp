@@ -17,8 +17,13 @@
 #ifndef QNLP_SIMULATOR_H
 #define QNLP_SIMULATOR_H
 #include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <utility> //std::declval
+#include <type_traits>
 #include <vector>
+#include <stdexcept>
+#include <string>
 #include <iostream>
 
 // Include all additional modules to be used within simulator
@@ -30,7 +35,11 @@
 #include "arithmetic.hpp"
 #include "bin_into_superpos.hpp"
 #include "hamming.hpp"
+#include "amplification.hpp"
+#include "amplitude_estimation.hpp"
+#include "layout.hpp"
 #include "bit_group.hpp"
+#include "OpBuffer.hpp"
 
 #if defined(__INTEL_COMPILER) || defined(__INTEL_LLVM_COMPILER)
 //pybind11 fails to compile with icpc using cpp17 support, so fallback to 14 if necessary
@@ -47,6 +56,14 @@
 #include "mpi.h"
 #endif
 
+/*
+ * Native kernels replace composite gate sequences by direct operations on the state-vector.
+ * Gate logging and resource estimation both require the decomposed gate calls, and so disable them.
+ */
+#if defined(NATIVE_KERNELS) && !defined(GATE_LOGGING) && !defined(RESOURCE_ESTIMATE)
+#define QNLP_NATIVE_KERNELS 1
+#endif
+
 namespace QNLP{
 
     /*
@@ -57,6 +74,14 @@ namespace QNLP{
      */
     #define IS_SET(byte,bit) (((byte) & (1UL << (bit))) >> (bit))
 
+    /**
+     * @brief Trait selecting whether the native kernels may be used with the given simulator type. Simulators that do not hold a state-vector (e.g. MPSSimulator) specialise this to std::false_type, and always apply the decomposed gate sequences.
+     * 
+     * @tparam SimulatorType CRTP derived class simulator type
+     */
+    template <class SimulatorType>
+    struct HasNativeKernels : std::true_type {};
+
     /**
      * @brief CRTP defined class for simulator implementations. 
      * 
@@ -314,6 +339,33 @@ namespace QNLP{
         void applyGateSqrtSwap(std::size_t qubit_idx0, std::size_t qubit_idx1){
             static_cast<DerivedType*>(this)->applyGateSqrtSwap(qubit_idx0,qubit_idx1);
         }
+
+        /**
+         * @brief Apply arbitrary user-defined two-qubit unitary gate to the given qubits
+         * 
+         * @tparam Mat4x4Type 4x4 Matrix type of unitary gate in the format expected by the derived simulator object
+         * @param U User-defined unitary 4x4 matrix; index k = 2*b1 + b0 with b0, b1 the values of qubit_idx0, qubit_idx1
+         * @param qubit_idx0 Index of qubit 0
+         * @param qubit_idx1 Index of qubit 1
+         * @param label Optional parameter to label the gate U
+         */
+        template<class Mat4x4Type>
+        void applyGate2U(const Mat4x4Type &U, std::size_t qubit_idx0, std::size_t qubit_idx1, std::string label="U"){
+            static_cast<DerivedType*>(this)->applyGate2U(U, qubit_idx0, qubit_idx1, label);
+        }
+
+        /**
+         * @brief Apply arbitrary user-defined unitary gate on a small number of qubits (up to 5) as a single operation, such as a fused block of gates
+         * 
+         * @tparam MatType 2^k x 2^k row-major matrix type of unitary gate in the format expected by the derived simulator object
+         * @param U User-defined unitary matrix; bit i of the matrix index is the value of qubits[i]
+         * @param qubits Indices of the qubits the gate acts upon
+         * @param label Optional parameter to label the gate U
+         */
+        template<class MatType>
+        void applyGateKU(const MatType &U, const std::vector<std::size_t>& qubits, std::string label="U"){
+            static_cast<DerivedType*>(this)->applyGateKU(U, qubits, label);
+        }
         
         /**
          * @brief Apply phase shift to given Qubit; [[1 0] [0 exp(i*angle)]]
@@ -396,6 +448,201 @@ namespace QNLP{
             static_cast<DerivedType&>(*this).applyGateCRotZ(ctrl_qubit, qubit_idx, angle_rad);
         }
 
+        /**
+         * @brief Apply the operations of the buffer back-to-back, with a single call through the simulator interface. With native kernels, a simulator may fuse the operations; IntelSimulator fuses the single qubit gates acting on each qubit between multi-qubit operations into a single gate.
+         * 
+         * @param ops Buffer of operations to apply, in order
+         */
+        void applyOps(const OpBuffer& ops){
+            applyOps(ops.data(), ops.size());
+        }
+
+        /**
+         * @brief Apply num_ops packed operations back-to-back, as applyOps(const OpBuffer&). The operations are read in place, so may be held by memory not owned by an OpBuffer (e.g. a numpy array).
+         * 
+         * @param ops Pointer to the first operation
+         * @param num_ops Number of operations to apply
+         * @throws std::invalid_argument if any operation has an unknown code or invalid qubits, in which case none are applied
+         */
+        void applyOps(const Op* ops, std::size_t num_ops){
+            validateOps(ops, num_ops, getNumQubits());
+
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                static_cast<DerivedType&>(*this).applyFusedOps(ops, num_ops);
+                return;
+            }
+            #endif
+            for(std::size_t i = 0; i < num_ops; i++){
+                applyOp(ops[i]);
+            }
+        }
+
+        /**
+         * @brief Apply a single packed operation; see OpCode for the roles of its qubits. The qubits are not checked; see validateOps.
+         * 
+         * @param op The operation to apply
+         * @throws std::invalid_argument if the operation code is unknown
+         */
+        void applyOp(const Op& op){
+            auto& sim = static_cast<DerivedType&>(*this);
+            switch(static_cast<OpCode>(op.code)){
+                case OpCode::I:             sim.applyGateI(op.q0); break;
+                case OpCode::X:             sim.applyGateX(op.q0); break;
+                case OpCode::Y:             sim.applyGateY(op.q0); break;
+                case OpCode::Z:             sim.applyGateZ(op.q0); break;
+                case OpCode::H:             sim.applyGateH(op.q0); break;
+                case OpCode::SqrtX:         sim.applyGateSqrtX(op.q0); break;
+                case OpCode::RotX:          sim.applyGateRotX(op.q0, op.param); break;
+                case OpCode::RotY:          sim.applyGateRotY(op.q0, op.param); break;
+                case OpCode::RotZ:          sim.applyGateRotZ(op.q0, op.param); break;
+                case OpCode::PhaseShift:    sim.applyGatePhaseShift(op.q0, op.param); break;
+                case OpCode::CX:            sim.applyGateCX(op.q0, op.q1); break;
+                case OpCode::CY:            sim.applyGateCY(op.q0, op.q1); break;
+                case OpCode::CZ:            sim.applyGateCZ(op.q0, op.q1); break;
+                case OpCode::CH:            sim.applyGateCH(op.q0, op.q1); break;
+                case OpCode::CRotX:         sim.applyGateCRotX(op.q0, op.q1, op.param); break;
+                case OpCode::CRotY:         sim.applyGateCRotY(op.q0, op.q1, op.param); break;
+                case OpCode::CRotZ:         sim.applyGateCRotZ(op.q0, op.q1, op.param); break;
+                case OpCode::CPhaseShift:   sim.applyGateCPhaseShift(op.param, op.q0, op.q1); break;
+                case OpCode::Swap:          sim.applyGateSwap(op.q0, op.q1); break;
+                case OpCode::SqrtSwap:      sim.applyGateSqrtSwap(op.q0, op.q1); break;
+                case OpCode::CCX:           sim.applyGateCCX(op.q0, op.q1, op.q2); break;
+                case OpCode::CSwap:         sim.applyGateCSwap(op.q0, op.q1, op.q2); break;
+                case OpCode::Reset:         resetQubit(op.q0); break;
+                default:
+                    throw std::invalid_argument("Unknown operation code " + std::to_string(op.code));
+            }
+        }
+
+        /**
+         * @brief Apply a classical reversible function to the sub-register defined by the given qubits. As the operation is a permutation of the basis states, it is applied as a single pass over the state-vector.
+         * 
+         * @tparam PermFunc Callable type mapping std::size_t -> std::size_t
+         * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of the sub-register value
+         * @param perm Bijection over the sub-register values [0, 2^qubits.size())
+         * @param decomposition Gate sequence implementing the permutation, counted in place of the single pass
+         */
+        template<class PermFunc>
+        void applyRegisterPermutation(const std::vector<std::size_t>& qubits, PermFunc perm, const OpBuffer& decomposition = OpBuffer()){
+            static_cast<DerivedType*>(this)->applyRegisterPermutation(qubits, perm, decomposition);
+        }
+
+        /**
+         * @brief Apply the reflection about the uniform superposition of the sub-register defined by the given qubits (I - 2|s><s|), as a native operation on the state-vector.
+         * 
+         * @param qubits Indices of the qubits forming the sub-register
+         */
+        void applyUniformReflection(const std::vector<std::size_t>& qubits){
+            static_cast<DerivedType*>(this)->applyUniformReflection(qubits);
+        }
+
+        /**
+         * @brief Negate the amplitudes of all basis states for which the sub-register defined by qubits matches any of the given patterns
+         * 
+         * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of each pattern
+         * @param patterns Sub-register values to mark
+         */
+        void applyPatternPhaseFlip(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns){
+            static_cast<DerivedType*>(this)->applyPatternPhaseFlip(qubits, patterns);
+        }
+
+        /**
+         * @brief Apply the (inverse) quantum Fourier transform to the given register index range as a native operation on the state-vector
+         * 
+         * @param minIdx Lowest qubit index of the range
+         * @param maxIdx Highest qubit index of the range
+         * @param inverse Apply the inverse transform if true
+         */
+        void applyFourierTransform(std::size_t minIdx, std::size_t maxIdx, bool inverse=false){
+            static_cast<DerivedType*>(this)->applyFourierTransform(minIdx, maxIdx, inverse);
+        }
+
+        /**
+         * @brief Get the probability of the sub-register defined by qubits matching any of the given patterns
+         * 
+         * @param qubits Indices of the qubits forming the sub-register; qubits[i] holds bit i of each pattern
+         * @param patterns Sub-register values to match
+         * @return double Probability of measuring the sub-register in any of the given patterns
+         */
+        double getPatternProbability(const std::vector<std::size_t>& qubits, const std::vector<std::size_t>& patterns){
+            return static_cast<DerivedType*>(this)->getPatternProbability(qubits, patterns);
+        }
+
+        /**
+         * @brief Store a copy of the current state, used as the axis of applyStateReflection
+         * 
+         */
+        void storeStateSnapshot(){
+            static_cast<DerivedType*>(this)->storeStateSnapshot();
+        }
+
+        /**
+         * @brief Overwrite the current state with the stored state snapshot
+         * 
+         */
+        void restoreStateSnapshot(){
+            static_cast<DerivedType*>(this)->restoreStateSnapshot();
+        }
+
+        /**
+         * @brief Release the stored state snapshot
+         * 
+         */
+        void releaseStateSnapshot(){
+            static_cast<DerivedType*>(this)->releaseStateSnapshot();
+        }
+
+        /**
+         * @brief Apply the reflection about the stored state snapshot |psi>, I - 2|psi><psi|
+         * 
+         */
+        void applyStateReflection(){
+            static_cast<DerivedType*>(this)->applyStateReflection();
+        }
+
+        /**
+         * @brief Get the logical to physical qubit map, under which swaps and register inversions are applied as relabellings
+         * 
+         * @return decltype(auto) the qubit map
+         */
+        decltype(auto) getQubitMap(){
+            return static_cast<DerivedType*>(this)->getQubitMap();
+        }
+
+        /**
+         * @brief Permute the state such that each logical qubit is held at the physical qubit of the same index
+         * 
+         */
+        void materializeQubitMap(){
+            static_cast<DerivedType*>(this)->materializeQubitMap();
+        }
+
+        /**
+         * @brief Apply all operations held lazily to the underlying register, such that it holds the complex amplitudes of the state indexed by the logical qubits, for export of the state
+         * 
+         */
+        void materializeState(){
+            static_cast<DerivedType*>(this)->materializeState();
+        }
+
+        /**
+         * @brief Check if the state is held with real amplitudes
+         * 
+         * @return true if only real gates have been applied to a simulator created with real amplitudes
+         */
+        bool isRealAmplitudes(){
+            return static_cast<DerivedType*>(this)->isRealAmplitudes();
+        }
+
+        /**
+         * @brief Promote a state held with real amplitudes to complex amplitudes. Applying a complex gate does this implicitly.
+         * 
+         */
+        void promoteToComplex(){
+            static_cast<DerivedType*>(this)->promoteToComplex();
+        }
+
         /**
          * @brief Get the underlying qubit register object
          * 
@@ -419,9 +666,20 @@ namespace QNLP{
          * 
          * @param minIdx Lowest qubit index of the QFT range
          * @param maxIdx Highest qubit index of the QFT range
+         * @param k_max Approximate QFT cutoff; controlled rotations by 2pi/2^k with k > k_max are omitted. 0 applies the exact QFT.
          */
-        void applyQFT(std::size_t minIdx, std::size_t maxIdx){
-            QFT<decltype(static_cast<DerivedType&>(*this))>::applyQFT(static_cast<DerivedType&>(*this), minIdx, maxIdx);
+        void applyQFT(std::size_t minIdx, std::size_t maxIdx, std::size_t k_max = 0){
+            using QFTType = QFT<decltype(static_cast<DerivedType&>(*this))>;
+            #ifdef QNLP_NATIVE_KERNELS
+            // The native kernel is exact; approximate transforms use the gate sequence
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                if(! QFTType::isApproximate(maxIdx - minIdx + 1, k_max)){
+                    QFTType::applyQFTNative(static_cast<DerivedType&>(*this), minIdx, maxIdx);
+                    return;
+                }
+            }
+            #endif
+            QFTType::applyQFT(static_cast<DerivedType&>(*this), minIdx, maxIdx, k_max);
         }
 
         /**
@@ -429,24 +687,61 @@ namespace QNLP{
          * 
          * @param minIdx Lowest qubit index of the IQFT range
          * @param maxIdx Highest qubit index of the IQFT range
+         * @param k_max Approximate QFT cutoff; controlled rotations by 2pi/2^k with k > k_max are omitted. 0 applies the exact IQFT.
          */
-        void applyIQFT(std::size_t minIdx, std::size_t maxIdx){
-            QFT<decltype(static_cast<DerivedType&>(*this))>::applyIQFT(static_cast<DerivedType&>(*this), minIdx, maxIdx);
+        void applyIQFT(std::size_t minIdx, std::size_t maxIdx, std::size_t k_max = 0){
+            using QFTType = QFT<decltype(static_cast<DerivedType&>(*this))>;
+            #ifdef QNLP_NATIVE_KERNELS
+            // The native kernel is exact; approximate transforms use the gate sequence
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                if(! QFTType::isApproximate(maxIdx - minIdx + 1, k_max)){
+                    QFTType::applyIQFTNative(static_cast<DerivedType&>(*this), minIdx, maxIdx);
+                    return;
+                }
+            }
+            #endif
+            QFTType::applyIQFT(static_cast<DerivedType&>(*this), minIdx, maxIdx, k_max);
         }
 
 
         /**
-         * @brief Applies |r1>|r2> -> |r1>|r1+r2>
+         * @brief Applies |r1>|r2> -> |r1>|r1+r2>. Rotations by 2pi/2^k with k > k_max are omitted if k_max is non-zero.
          */
-        void sumReg(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx){
-            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sum_reg(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx);
+        void sumReg(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx, std::size_t k_max = 0){
+            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sum_reg(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, k_max);
         }
 
        /**
-         * @brief Applies |r1>|r2> -> |r1>|r1-r2>
+         * @brief Applies |r1>|r2> -> |r1>|r1-r2>. Rotations by 2pi/2^k with k > k_max are omitted if k_max is non-zero.
          */
-        void subReg(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx){
-            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sub_reg(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx);
+        void subReg(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx, std::size_t k_max = 0){
+            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sub_reg(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, k_max);
+        }
+
+        /**
+         * @brief Applies |r1>|r2> -> |r1>|r1+r2> using the ripple-carry adder with a single ancilla qubit (in |0>), rather than the QFT adder
+         */
+        void sumRegRipple(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx, std::size_t ancilla){
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sum_reg_native(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, ancilla);
+                return;
+            }
+            #endif
+            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sum_reg_ripple(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, ancilla);
+        }
+
+        /**
+         * @brief Applies |r1>|r2> -> |r1>|r1-r2> using the ripple-carry adder with a single ancilla qubit (in |0>), rather than the QFT adder
+         */
+        void subRegRipple(std::size_t r0_minIdx, std::size_t r0_maxIdx, std::size_t r1_minIdx, std::size_t r1_maxIdx, std::size_t ancilla){
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sub_reg_native(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, ancilla);
+                return;
+            }
+            #endif
+            Arithmetic<decltype(static_cast<DerivedType&>(*this))>::sub_reg_ripple(static_cast<DerivedType&>(*this), r0_minIdx, r0_maxIdx, r1_minIdx, r1_maxIdx, ancilla);
         }
 
         /**
@@ -527,6 +822,24 @@ namespace QNLP{
             oracle.bitStringPhaseOracle(static_cast<DerivedType&>(*this), bit_pattern, ctrlIndices, target );
         }
 
+        /**
+         * @brief Apply oracle marking each of the given binary patterns with linearly adjacent controls. Duplicate patterns are marked once.
+         * 
+         * @param bit_patterns Oracle patterns in binary
+         * @param ctrlIndices Control lines for oracle
+         * @param target Target qubit index to apply Z gate upon
+         */
+        void applyOraclePhase(const std::vector<std::size_t>& bit_patterns, const std::vector<std::size_t>& ctrlIndices, std::size_t target){
+            Oracle<DerivedType> oracle;
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                oracle.bitStringPhaseOracleNative(static_cast<DerivedType&>(*this), bit_patterns, ctrlIndices, target );
+                return;
+            }
+            #endif
+            oracle.bitStringPhaseOracle(static_cast<DerivedType&>(*this), bit_patterns, ctrlIndices, target );
+        }
+
         /**
          * @brief Apply diffusion operator on marked state. 
          * 
@@ -535,6 +848,12 @@ namespace QNLP{
          */
         void applyDiffusion(const std::vector<std::size_t>& ctrlIndices, std::size_t target){
             Diffusion<DerivedType> diffusion;
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                diffusion.applyOpDiffusionNative(static_cast<DerivedType&>(*this), ctrlIndices, target);
+                return;
+            }
+            #endif
             diffusion.applyOpDiffusion(static_cast<DerivedType&>(*this), ctrlIndices, target);
         }
 
@@ -616,9 +935,96 @@ namespace QNLP{
             // Encode test pattern to auxiliary register
             encodeToRegister(test_pattern, reg_auxiliary, len_bin_pattern);
 
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                HammingDistance<DerivedType>::computeHammingDistanceOverwriteAuxNative(static_cast<DerivedType&>(*this), reg_mem, reg_auxiliary);
+                return;
+            }
+            #endif
             HammingDistance<DerivedType>::computeHammingDistanceOverwriteAux(static_cast<DerivedType&>(*this), reg_mem, reg_auxiliary);
         }
 
+        /**
+         * @brief Amplifies the states flagged by the Hamming target qubit (second last auxiliary qubit) using Grover iterations, increasing the probability of post-selecting the target in |1>. Applied to the state prepared by the encoding and Hamming distance routines.
+         *
+         * @param reg_mem Vector containing the indices of the register qubits that contain the training patterns.
+         * @param reg_auxiliary Vector containing the indices of the auxiliary register qubits.
+         * @param patterns Vector of the training patterns encoded in the memory register.
+         * @param test_pattern The binary pattern used as the basis for the Hamming distance.
+         * @param iterations Number of Grover iterations; if 0, the optimal number is determined from the target probability of the encoded patterns.
+         * @return std::size_t Number of Grover iterations applied
+         */
+        std::size_t amplifySimilarity(const std::vector<std::size_t>& reg_mem, 
+                const std::vector<std::size_t>& reg_auxiliary,
+                const std::vector<std::size_t>& patterns,
+                std::size_t test_pattern,
+                std::size_t iterations = 0){
+            return AmplitudeAmplification<DerivedType>::amplifySimilarity(static_cast<DerivedType&>(*this), reg_mem, reg_auxiliary, patterns, test_pattern, iterations);
+        }
+
+        /**
+         * @brief Estimates the probability of post-selecting the Hamming target qubit (second last auxiliary qubit) in |1> by maximum likelihood amplitude estimation, from shots of circuits with 0, 1, 2, 4, ... Grover iterations. Applied to the state prepared by the encoding and Hamming distance routines, which is restored on return.
+         *
+         * @param reg_auxiliary Vector containing the indices of the auxiliary register qubits.
+         * @param num_powers Number of circuits, with up to 2^(num_powers-2) Grover iterations.
+         * @param shots_per_power Number of shots of each circuit.
+         * @param z_score Number of standard errors spanned by the confidence interval.
+         * @param seed Seed of the shots; if not given, the seed of the simulator's random stream is used.
+         * @return AmplitudeEstimate Estimate, confidence interval and shot budget
+         */
+        AmplitudeEstimate estimatePostSelection(const std::vector<std::size_t>& reg_auxiliary,
+                std::size_t num_powers = 6,
+                std::size_t shots_per_power = 100,
+                double z_score = 1.96,
+                const std::optional<std::uint64_t>& seed = std::nullopt){
+            AmplitudeEstimation<DerivedType> estimator(num_powers, shots_per_power, z_score, seed ? *seed : getRandomSeed());
+            return estimator.estimatePostSelection(static_cast<DerivedType&>(*this), reg_auxiliary);
+        }
+
+        /**
+         * @brief Estimates the similarity of each given training pattern, as the joint probability of the memory register holding the pattern and the Hamming target qubit being in |1>, by maximum likelihood amplitude estimation. Applied to the state prepared by the encoding and Hamming distance routines, which is restored on return.
+         *
+         * @param reg_mem Vector containing the indices of the register qubits that contain the training patterns.
+         * @param reg_auxiliary Vector containing the indices of the auxiliary register qubits.
+         * @param patterns Vector of the training patterns to estimate.
+         * @param num_powers Number of circuits, with up to 2^(num_powers-2) Grover iterations.
+         * @param shots_per_power Number of shots of each circuit.
+         * @param z_score Number of standard errors spanned by the confidence interval.
+         * @param seed Seed of the shots; if not given, the seed of the simulator's random stream is used.
+         * @return std::vector<AmplitudeEstimate> Estimate, confidence interval and shot budget of each pattern
+         */
+        std::vector<AmplitudeEstimate> estimateSimilarity(const std::vector<std::size_t>& reg_mem,
+                const std::vector<std::size_t>& reg_auxiliary,
+                const std::vector<std::size_t>& patterns,
+                std::size_t num_powers = 6,
+                std::size_t shots_per_power = 100,
+                double z_score = 1.96,
+                const std::optional<std::uint64_t>& seed = std::nullopt){
+            AmplitudeEstimation<DerivedType> estimator(num_powers, shots_per_power, z_score, seed ? *seed : getRandomSeed());
+            return estimator.estimateSimilarity(static_cast<DerivedType&>(*this), reg_mem, reg_auxiliary, patterns);
+        }
+
+        /**
+         * @brief Get the number of gates applied with each qubit as target
+         * 
+         * @return decltype(auto) the per-qubit gate counts
+         */
+        decltype(auto) getQubitUsage(){
+            return static_cast<DerivedType*>(this)->getQubitUsage();
+        }
+
+        /**
+         * @brief Remap the memory and auxiliary registers such that the qubits most used by the circuit last run on them are assigned the lowest indices, improving locality and minimising gates on distributed qubits. The circuit should then be run on the returned registers.
+         *
+         * @param reg_mem Vector containing the indices of the register qubits that contain the training patterns.
+         * @param reg_auxiliary Vector containing the indices of the auxiliary register qubits.
+         * @return std::pair<std::vector<std::size_t>, std::vector<std::size_t>> Remapped memory and auxiliary registers
+         */
+        std::pair<std::vector<std::size_t>, std::vector<std::size_t>> optimiseQubitLayout(const std::vector<std::size_t>& reg_mem, 
+                const std::vector<std::size_t>& reg_auxiliary){
+            return QubitLayout<DerivedType>::optimiseRegisters(static_cast<DerivedType&>(*this), reg_mem, reg_auxiliary);
+        }
+
         /**
          * @brief Apply measurement to a target qubit, randomly collapsing the qubit proportional to the amplitude and returns the collapsed value.
          * 
@@ -646,6 +1052,25 @@ namespace QNLP{
             return val;
         }
 
+        /**
+         * @brief Seed the counter-based random stream used by measurements, making subsequent measurement outcomes reproducible. Each measurement draws the number of (seed, shot, draw index), so distinct shots of a seed are independent streams.
+         *
+         * @param seed Seed of the stream
+         * @param shot Index of the stream under the seed
+         */
+        void setRandomSeed(std::uint64_t seed, std::uint64_t shot=0){
+            static_cast<DerivedType*>(this)->setRandomSeed(seed, shot);
+        }
+
+        /**
+         * @brief Get the seed of the random stream used by measurements
+         *
+         * @return std::uint64_t Seed of the stream
+         */
+        std::uint64_t getRandomSeed(){
+            return static_cast<DerivedType*>(this)->getRandomSeed();
+        }
+
         /**
          * @brief Group all set qubits to MSB in register (ie |010100> -> |000011>)
          * 
@@ -671,6 +1096,59 @@ namespace QNLP{
         void collapseToBasisZ(std::size_t target, bool collapseValue){
             static_cast<DerivedType*>(this)->collapseToBasisZ(target, collapseValue);
         }
+
+        /**
+         * @brief Reset the target qubit to |0>, as the H gate followed by collapsing the qubit to 0 (a0 -> a0 + a1, a1 -> 0, renormalized). Applied as a single pass over the state-vector where the simulator provides a native kernel.
+         *
+         * @param target The index of the qubit being reset
+         */
+        void resetQubit(std::size_t target){
+            #ifdef QNLP_NATIVE_KERNELS
+            if constexpr (HasNativeKernels<DerivedType>::value){
+                static_cast<DerivedType*>(this)->applyReset(target);
+                return;
+            }
+            #endif
+            applyGateH(target);
+            collapseToBasisZ(target, 0);
+        }
+
+        /**
+         * @brief Release the target qubit, which must be in the state |0>, factoring it out of the state-vector and halving its size. No gates may be applied to the qubit until it is allocated again.
+         *
+         * @param target The index of the qubit being released
+         */
+        void releaseQubit(std::size_t target){
+            static_cast<DerivedType*>(this)->releaseQubit(target);
+        }
+
+        /**
+         * @brief Allocate the released target qubit in the state |0>, doubling the size of the state-vector
+         *
+         * @param target The index of the qubit being allocated
+         */
+        void allocateQubit(std::size_t target){
+            static_cast<DerivedType*>(this)->allocateQubit(target);
+        }
+
+        /**
+         * @brief Allocate the lowest-indexed released qubit in the state |0>
+         *
+         * @return std::size_t The index of the allocated qubit
+         */
+        std::size_t allocateQubit(){
+            return static_cast<DerivedType*>(this)->allocateQubit();
+        }
+
+        /**
+         * @brief Get the probability of the specified qubit being in the state |1>. Note that this state observation method is not a permitted quantum operation, however it is provided for convenience.
+         * 
+         * @param target Target qubit
+         * @return double Probability that the target qubit is in the state |1>
+         */
+        double getStateProbability(std::size_t target){
+            return static_cast<DerivedType*>(this)->getStateProbability(target);
+        }
                 
         /**
          * @brief (Re)Initialise the underlying register of the encapsulated simulator to well-defined state (|0....0>)
@@ -680,6 +1158,16 @@ namespace QNLP{
             static_cast<DerivedType&>(*this).initRegister();
         }
 
+        /**
+         * @brief (Re)Initialise the underlying register to |0....0>, and restart the measurement random stream at the given seed and shot
+         *
+         * @param seed Seed of the stream
+         * @param shot Index of the stream under the seed
+         */
+        void initRegister(std::uint64_t seed, std::uint64_t shot=0){
+            static_cast<DerivedType&>(*this).initRegister(seed, shot);
+        }
+
         /**
          * @brief Initialise caches used in NCU operation.
          * 
@@ -728,15 +1216,17 @@ namespace QNLP{
         template<class Mat2x2Type>
         Mat2x2Type matrixSqrt(const Mat2x2Type& U){
             Mat2x2Type V(U);
-            std::complex<double> delta = U(0,0)*U(1,1) - U(0,1)*U(1,0);
-            std::complex<double> tau = U(0,0) + U(1,1);
-            std::complex<double> s = sqrt(delta);
-            std::complex<double> t = sqrt(tau + 2.0*s);
+            //Computed in the precision of the matrix elements
+            using ValueType = typename std::decay<decltype(U(0,0))>::type;
+            ValueType delta = U(0,0)*U(1,1) - U(0,1)*U(1,0);
+            ValueType tau = U(0,0) + U(1,1);
+            ValueType s = sqrt(delta);
+            ValueType t = sqrt(tau + ValueType(2.0)*s);
 
             //must be a way to vectorise these; TinyMatrix have a scale/shift option?
             V(0,0) += s;
             V(1,1) += s;
-            std::complex<double> scale_factor(1.,0.);
+            ValueType scale_factor(1.,0.);
             scale_factor/=t;
             V(0,0) *= scale_factor; //(std::complex<double>(1.,0.)/t);
             V(0,1) *= scale_factor; //(1/t);
@@ -756,7 +1246,7 @@ namespace QNLP{
         template<class Mat2x2Type>
         static Mat2x2Type adjointMatrix(const Mat2x2Type& U){
             Mat2x2Type Uadjoint(U);
-            std::complex<double> tmp;
+            typename std::decay<decltype(U(0,0))>::type tmp;
             tmp = Uadjoint(0,1);
             Uadjoint(0,1) = Uadjoint(1,0);
             Uadjoint(1,0) = tmp;
@@ -768,7 +1258,7 @@ namespace QNLP{
         }
 
         /**
-         * @brief Invert the register about the given indides: 0,1,2...n-1,n -> n,n-1,...,1,0
+         * @brief Invert the register about the given indides: 0,1,2...n-1,n -> n,n-1,...,1,0. Simulators with a qubit map apply this as a relabelling.
          * 
          * @param minIdx The lower index of the inversion
          * @param maxIdx The upper index of the inversion
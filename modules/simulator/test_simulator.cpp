@@ -12,9 +12,14 @@
 //#define CATCH_CONFIG_MAIN
 
 #include "catch2/catch.hpp"
+#include "test_states.hpp"
 #include "Simulator.hpp"
 #include "IntelSimulator.cpp"
+#include "MPSSimulator.cpp"
+#include "BatchSimulator.cpp"
+#include "Ensemble.hpp"
 #include <memory>
+#include <functional>
 
 using namespace QNLP;
 
@@ -167,6 +172,1198 @@ TEST_CASE("Measurement of qubits"){
 }
 
 
+/**
+ * @brief Test swaps and register inversions applied as relabellings of the qubit map, against swaps decomposed into CX gates
+ * 
+ */
+TEST_CASE("Virtual qubit map"){
+    std::size_t num_qubits = 6;
+    IntelSimulator sim_map(num_qubits), sim_ref(num_qubits);
+
+    auto swap_cx = [](IntelSimulator& sim, std::size_t q0, std::size_t q1){
+        sim.applyGateCX(q0, q1);
+        sim.applyGateCX(q1, q0);
+        sim.applyGateCX(q0, q1);
+    };
+    test::prepareDistinctState(sim_map);
+    test::prepareDistinctState(sim_ref);
+
+    sim_map.applyGateSwap(0, 3);
+    swap_cx(sim_ref, 0, 3);
+    sim_map.InvertRegister(1, 5);
+    swap_cx(sim_ref, 1, 5);
+    swap_cx(sim_ref, 2, 4);
+
+    REQUIRE(sim_map.getQubitMap() == std::vector<std::size_t>{3, 5, 4, 0, 2, 1});
+
+    sim_map.applyGateCX(0, 4);
+    sim_ref.applyGateCX(0, 4);
+    sim_map.applyGateH(5);
+    sim_ref.applyGateH(5);
+    sim_map.applyGateCRotY(2, 1, 0.7);
+    sim_ref.applyGateCRotY(2, 1, 0.7);
+    sim_map.applyPatternPhaseFlip({1, 2, 3}, {0b101, 0b011});
+    sim_ref.applyPatternPhaseFlip({1, 2, 3}, {0b101, 0b011});
+
+    SECTION("Qubit probabilities"){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim_map.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+        }
+    }
+    SECTION("Overlap"){
+        REQUIRE(std::abs(sim_ref.overlap(sim_map)) == Approx(1.0).margin(1e-12));
+    }
+    SECTION("Materialized state"){
+        test::requireEqualStates(sim_map, sim_ref);
+        REQUIRE(sim_map.getQubitMap() == std::vector<std::size_t>{0, 1, 2, 3, 4, 5});
+    }
+    SECTION("Measurement"){
+        sim_map.collapseToBasisZ(3, true);
+        sim_ref.collapseToBasisZ(3, true);
+        REQUIRE(std::abs(sim_ref.overlap(sim_map)) == Approx(1.0).margin(1e-12));
+    }
+    SECTION("Initialisation resets the map"){
+        sim_map.initRegister();
+        REQUIRE(sim_map.getQubitMap() == std::vector<std::size_t>{0, 1, 2, 3, 4, 5});
+        REQUIRE(std::norm(sim_map.getQubitRegister()[0]) == Approx(1.0));
+    }
+}
+
+/**
+ * @brief Test cache-blocked gate scheduling against gates applied directly; queued gates must be applied in order around gates on higher qubits, measurements and native kernels.
+ * 
+ */
+TEST_CASE("Cache-blocked gate scheduling"){
+    std::size_t num_qubits = 8;
+    IntelSimulator sim_ref(num_qubits), sim_blk(num_qubits);
+    sim_blk.setGateBlockQubits(4);
+
+    auto circuit = [num_qubits](IntelSimulator& sim){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateH(i);
+            sim.applyGateRotY(i, 0.3 + 0.2*i);
+        }
+        for(std::size_t layer = 0; layer < 3; layer++){
+            sim.applyGateRotX(0, 0.4 + layer);
+            sim.applyGateCX(0, 1);
+            sim.applyGateCRotZ(1, 2, 0.9);
+            sim.applyGateX(6);              // commutes with the queued gates
+            sim.applyGateSqrtX(3);
+            sim.applyGateCPhaseShift(0.5, 3, 2);
+            sim.applyGateCY(2, 7);          // shares qubit 2 with the queue
+            sim.applyGateCH(3, 0);
+            sim.applyGateRotZ(1, 0.7);
+            sim.applyGateCZ(5, 3);
+            sim.applyGateSwap(1, 6);        // relabels, queued gates are on physical qubits
+            sim.applyGateY(1);
+            sim.applyPatternPhaseFlip({0, 1, 2}, {0b011});
+        }
+        sim.applyGateCRotX(3, 1, 1.1);
+        sim.applyGateZ(2);
+    };
+    circuit(sim_ref);
+    circuit(sim_blk);
+
+    SECTION("State"){
+        test::requireEqualStates(sim_blk, sim_ref);
+    }
+    SECTION("Measurement"){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim_blk.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+        }
+        sim_ref.collapseToBasisZ(2, false);
+        sim_blk.collapseToBasisZ(2, false);
+        sim_ref.applyGateH(0);
+        sim_blk.applyGateH(0);
+        REQUIRE(std::abs(sim_ref.overlap(sim_blk)) == Approx(1.0).margin(1e-12));
+    }
+    SECTION("Bytes moved per gate"){
+        REQUIRE(sim_blk.getBytesMovedPerGate() < sim_ref.getBytesMovedPerGate());
+        REQUIRE(sim_ref.getBytesMovedPerGate() == Approx(2. * sizeof(ComplexDP) * (0b1UL << num_qubits)));
+    }
+}
+
+/**
+ * @brief Test the two-qubit unitary gate against equivalent single and controlled gate sequences
+ * 
+ */
+TEST_CASE("Two-qubit unitary gate"){
+    std::size_t num_qubits = 5;
+
+
+    for(auto [q0, q1] : std::vector<std::pair<std::size_t, std::size_t>>{{0, 1}, {1, 0}, {0, 4}, {3, 1}, {2, 3}}){
+        DYNAMIC_SECTION("Qubits " << q0 << ", " << q1){
+            IntelSimulator sim_2u(num_qubits), sim_ref(num_qubits);
+            test::prepareDistinctState(sim_2u);
+            test::prepareDistinctState(sim_ref);
+
+            SECTION("Product and CX"){
+                auto A = sim_ref.getGateRotation('Y', 0.7);
+                auto B = sim_ref.getGateH();
+
+                // CX(q0 -> q1) (B (x) A)
+                IntelSimulator::TM4DP U;
+                for(std::size_t k = 0; k < 4; k++){
+                    for(std::size_t l = 0; l < 4; l++){
+                        const std::size_t row = (k & 0b1) ? (k ^ 0b10) : k;
+                        U(row, l) = B(k >> 1, l >> 1) * A(k & 0b1, l & 0b1);
+                    }
+                }
+                sim_2u.applyGate2U(U, q0, q1);
+                sim_ref.applyGateU(A, q0);
+                sim_ref.applyGateU(B, q1);
+                sim_ref.applyGateCX(q0, q1);
+                test::requireEqualStates(sim_2u, sim_ref);
+            }
+            SECTION("SqrtSwap"){
+                sim_2u.applyGateSqrtSwap(q0, q1);
+                sim_2u.applyGateSqrtSwap(q0, q1);
+                sim_ref.applyGateCX(q0, q1);
+                sim_ref.applyGateCX(q1, q0);
+                sim_ref.applyGateCX(q0, q1);
+                test::requireEqualStates(sim_2u, sim_ref);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("Dense k-qubit unitary gate"){
+    std::size_t num_qubits = 6;
+
+    // Matrix of the basis state permutation perm
+    auto perm_matrix = [](std::size_t k, std::function<std::size_t(std::size_t)> perm){
+        const std::size_t dim = 0b1UL << k;
+        std::vector<ComplexDP> U(dim*dim, 0.);
+        for(std::size_t l = 0; l < dim; l++){
+            U[perm(l)*dim + l] = 1.;
+        }
+        return U;
+    };
+
+    std::vector<std::vector<std::size_t>> qubit_sets {{2}, {4, 0}, {0, 1, 2}, {5, 1, 3}, {3, 0, 5, 2}, {1, 4, 0, 5, 2}};
+    for(auto& qubits : qubit_sets){
+        const std::size_t k = qubits.size();
+        DYNAMIC_SECTION("Tensor product on " << k << " qubits, lowest " << qubits[0]){
+            IntelSimulator sim_ku(num_qubits), sim_ref(num_qubits);
+            test::prepareDistinctState(sim_ku);
+            test::prepareDistinctState(sim_ref);
+
+            // A_{k-1} (x) ... (x) A_0
+            std::vector<IntelSimulator::TMDP> A;
+            for(std::size_t i = 0; i < k; i++){
+                A.push_back(sim_ref.getGateRotation("XYZ"[i % 3], 0.4 + 0.3*i));
+            }
+            const std::size_t dim = 0b1UL << k;
+            std::vector<ComplexDP> U(dim*dim);
+            for(std::size_t r = 0; r < dim; r++){
+                for(std::size_t c = 0; c < dim; c++){
+                    ComplexDP val = 1.;
+                    for(std::size_t i = 0; i < k; i++){
+                        val *= A[i]((r >> i) & 0b1, (c >> i) & 0b1);
+                    }
+                    U[r*dim + c] = val;
+                }
+            }
+            sim_ku.applyGateKU(U, qubits);
+            for(std::size_t i = 0; i < k; i++){
+                sim_ref.applyGateU(A[i], qubits[i]);
+            }
+            test::requireEqualStates(sim_ku, sim_ref);
+        }
+    }
+
+    for(auto& qubits : std::vector<std::vector<std::size_t>>{{0, 1, 2}, {5, 1, 3}, {2, 4, 0}}){
+        DYNAMIC_SECTION("Three-qubit blocks on " << qubits[0] << ", " << qubits[1] << ", " << qubits[2]){
+            IntelSimulator sim_ku(num_qubits), sim_ref(num_qubits);
+            test::prepareDistinctState(sim_ku);
+            test::prepareDistinctState(sim_ref);
+
+            SECTION("CCX"){
+                // Flip bit 2 when bits 0 and 1 are set
+                sim_ku.applyGateKU(perm_matrix(3, [](std::size_t l){ return (l & 0b11) == 0b11 ? l ^ 0b100 : l; }), qubits);
+                sim_ref.applyGateCCX(qubits[0], qubits[1], qubits[2]);
+                test::requireEqualStates(sim_ku, sim_ref);
+            }
+            SECTION("CSwap"){
+                // Swap bits 1 and 2 when bit 0 is set
+                sim_ku.applyGateKU(perm_matrix(3, [](std::size_t l){ return ((l & 0b1) && (((l >> 1) ^ (l >> 2)) & 0b1)) ? l ^ 0b110 : l; }), qubits);
+                sim_ref.applyGateCSwap(qubits[0], qubits[1], qubits[2]);
+                test::requireEqualStates(sim_ku, sim_ref);
+            }
+        }
+    }
+}
+
+TEST_CASE("CCX and CSwap gate counts"){
+    std::size_t num_qubits = 5;
+    IntelSimulator sim(num_qubits), sim_ref(num_qubits);
+    test::prepareDistinctState(sim);
+    test::prepareDistinctState(sim_ref);
+    auto counts_before = sim.getGateCounts();
+    auto usage_before = sim.getQubitUsage();
+
+    sim.applyGateCCX(0, 3, 1);
+    sim.applyGateCSwap(4, 2, 0);
+    sim_ref.applyGateNCU(sim_ref.getGateX(), {0, 3}, 1, "X");
+    sim_ref.applyGateCX(0, 2);
+    sim_ref.applyGateCCX(4, 2, 0);
+    sim_ref.applyGateCX(0, 2);
+
+    // Counted as the decomposed 2-qubit gate sequences
+    auto counts = sim.getGateCounts();
+    REQUIRE(counts.first == counts_before.first);
+    REQUIRE(counts.second == counts_before.second + 5 + 7);
+    auto usage = sim.getQubitUsage();
+    std::vector<std::size_t> expected {3, 3, 4, 2, 0};
+    for(std::size_t i = 0; i < num_qubits; i++){
+        CAPTURE(i);
+        REQUIRE(usage[i] - usage_before[i] == expected[i]);
+    }
+
+    test::requireEqualStates(sim, sim_ref);
+}
+
+TEST_CASE("Real amplitude state"){
+    std::size_t num_qubits = 6;
+    IntelSimulator sim_real(num_qubits, false, true), sim_ref(num_qubits);
+    REQUIRE(sim_real.isRealAmplitudes());
+    REQUIRE_FALSE(sim_ref.isRealAmplitudes());
+
+    auto apply_real_gates = [num_qubits](IntelSimulator& sim){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateH(i);
+            sim.applyGateRotY(i, 0.3 + 0.2*i);
+        }
+        sim.applyGateX(2);
+        sim.applyGateCX(0, 5);
+        sim.applyGateCZ(4, 1);
+        sim.applyGateCCX(5, 1, 3);
+        sim.applyGateCSwap(2, 0, 4);
+        sim.applyGateCRotY(3, 2, 0.9);
+        sim.applyGateCU(sim.getGateRotation('Y', -1.1), 1, 4);
+        sim.applyGateSwap(0, 3);
+        sim.applyGateCH(0, 1);
+    };
+    auto require_probabilities = [num_qubits](IntelSimulator& sim0, IntelSimulator& sim1){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim0.getStateProbability(i) == Approx(sim1.getStateProbability(i)).margin(1e-12));
+        }
+    };
+
+    apply_real_gates(sim_real);
+    apply_real_gates(sim_ref);
+    // The CCX and CSwap decompositions use complex roots of X
+    #ifdef QNLP_NATIVE_KERNELS
+    REQUIRE(sim_real.isRealAmplitudes());
+    #endif
+    require_probabilities(sim_real, sim_ref);
+
+    sim_real.collapseToBasisZ(3, true);
+    sim_ref.collapseToBasisZ(3, true);
+    #ifdef QNLP_NATIVE_KERNELS
+    REQUIRE(sim_real.isRealAmplitudes());
+    #endif
+    REQUIRE(sim_real.getStateProbability(3) == Approx(1.));
+    require_probabilities(sim_real, sim_ref);
+
+    SECTION("Promotion by a complex gate"){
+        sim_real.applyGateRotZ(1, 0.7);
+        sim_ref.applyGateRotZ(1, 0.7);
+        REQUIRE_FALSE(sim_real.isRealAmplitudes());
+    }
+    SECTION("Promotion on register access"){
+        sim_real.getQubitRegister();
+        REQUIRE_FALSE(sim_real.isRealAmplitudes());
+    }
+
+    sim_real.applyGateH(1);
+    sim_ref.applyGateH(1);
+    test::requireEqualStates(sim_real, sim_ref);
+}
+
+TEST_CASE("Single and mixed precision simulators"){
+    std::size_t num_qubits = 8;
+
+    auto apply_circuit = [num_qubits](auto& sim){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateH(i);
+            sim.applyGateRotY(i, 0.3 + 0.2*i);
+            sim.applyGateRotZ(i, 0.1*i);
+        }
+        sim.applyGateCX(0, 5);
+        sim.applyGateCCX(5, 1, 3);
+        sim.applyGateCSwap(2, 0, 4);
+        sim.applyGateCRotX(3, 6, 0.9);
+        sim.applyGateNCU(sim.getGateX(), {0, 1, 2, 6}, 7, "X");
+        sim.applyGateNCU(sim.getGateZ(), {3, 4, 5}, 1, "Z");
+        sim.applyQFT(2, 6);
+        sim.collapseToBasisZ(4, true);
+    };
+
+    IntelSimulator sim_dp(num_qubits);
+    IntelSimulatorSP sim_sp(num_qubits);
+    IntelSimulatorMP sim_mp(num_qubits);
+    apply_circuit(sim_dp);
+    apply_circuit(sim_sp);
+    apply_circuit(sim_mp);
+
+    test::requireEqualStates(sim_sp, sim_dp, 1e-5);
+    test::requireEqualStates(sim_mp, sim_dp, 1e-5);
+    for(std::size_t i = 0; i < num_qubits; i++){
+        CAPTURE(i);
+        REQUIRE(sim_sp.getStateProbability(i) == Approx(sim_dp.getStateProbability(i)).margin(1e-5));
+        REQUIRE(sim_mp.getStateProbability(i) == Approx(sim_dp.getStateProbability(i)).margin(1e-5));
+    }
+}
+
+/**
+ * @brief Test the qubit reset against H and collapse, and releasing and allocating qubits against a simulator holding all qubits, with a non-identity qubit map and real amplitudes
+ *
+ */
+TEST_CASE("Qubit reset, release and allocation"){
+    std::size_t num_qubits = 7;
+
+    auto prepare = [num_qubits](IntelSimulator& sim){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateRotY(i, 0.3 + 0.2*i);
+        }
+        sim.applyGateCX(2, 0);
+        sim.applyGateCX(5, 2);
+        sim.applyGateCRotY(2, 6, 0.8);
+        sim.applyGateSwap(2, 4);
+        sim.applyGateSwap(1, 6);
+    };
+    auto reset_ref = [](IntelSimulator& sim, std::size_t target){
+        sim.applyGateH(target);
+        sim.collapseToBasisZ(target, 0);
+    };
+
+    IntelSimulator sim(num_qubits), sim_real(num_qubits, false, true), sim_ref(num_qubits);
+    prepare(sim);
+    prepare(sim_real);
+    prepare(sim_ref);
+
+    sim.resetQubit(2);
+    sim_real.resetQubit(2);
+    reset_ref(sim_ref, 2);
+    REQUIRE(sim.getStateProbability(2) == Approx(0.).margin(1e-12));
+
+    SECTION("Reset"){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+            REQUIRE(sim_real.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+        }
+        test::requireEqualStates(sim, sim_ref);
+    }
+    SECTION("Release and allocate"){
+        sim.releaseQubit(2);
+        sim_real.releaseQubit(2);
+        REQUIRE(sim.isQubitReleased(2));
+        REQUIRE(sim.getNumPhysicalQubits() == num_qubits - 1);
+        REQUIRE(sim_real.getNumPhysicalQubits() == num_qubits - 1);
+        REQUIRE(sim.getStateProbability(2) == 0.);
+
+        // Gates on the remaining qubits, including a relabelling swap
+        for(auto s : {&sim, &sim_real, &sim_ref}){
+            s->applyGateCX(0, 5);
+            s->applyGateRotY(3, 1.1);
+            s->applyGateSwap(0, 6);
+            s->applyGateCRotY(6, 4, 0.4);
+        }
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+            REQUIRE(sim_real.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-12));
+        }
+
+        REQUIRE(sim.allocateQubit() == 2);
+        REQUIRE(sim_real.allocateQubit() == 2);
+        REQUIRE_FALSE(sim.isQubitReleased(2));
+        REQUIRE(sim.getNumPhysicalQubits() == num_qubits);
+        for(auto s : {&sim, &sim_real, &sim_ref}){
+            s->applyGateH(2);
+            s->applyGateCX(2, 3);
+        }
+        test::requireEqualStates(sim, sim_ref);
+        test::requireEqualStates(sim_real, sim_ref);
+    }
+    SECTION("Released qubits are restored"){
+        sim.releaseQubit(2);
+        reset_ref(sim_ref, 5);
+        sim.resetQubit(5);
+        sim.releaseQubit(5);
+        REQUIRE(sim.getNumPhysicalQubits() == num_qubits - 2);
+
+        SECTION("Materialized state"){
+            test::requireEqualStates(sim, sim_ref);
+            REQUIRE(sim.getQubitMap() == std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6});
+        }
+        SECTION("Overlap"){
+            REQUIRE(std::abs(sim_ref.overlap(sim)) == Approx(1.0).margin(1e-12));
+        }
+        SECTION("Initialisation"){
+            sim.initRegister();
+            REQUIRE(sim.getNumPhysicalQubits() == num_qubits);
+            REQUIRE(sim.getQubitMap() == std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6});
+            REQUIRE(std::norm(sim.getQubitRegister()[0]) == Approx(1.0));
+        }
+    }
+}
+
+/**
+ * @brief Test classical bit tracking against a simulator with tracking disabled
+ * 
+ */
+TEST_CASE("Classical bit tracking"){
+    std::size_t num_qubits = 8;
+
+    auto circuit = [](IntelSimulator& sim){
+        sim.applyGateX(0);
+        sim.applyGateX(3);
+        sim.applyGateY(5);
+        sim.applyGateZ(3);
+        sim.applyGateH(1);
+        sim.applyGateRotY(2, 0.7);
+        // Classical controls
+        sim.applyGateCX(0, 4);
+        sim.applyGateCX(6, 7);
+        sim.applyGateCZ(1, 3);
+        sim.applyGateCRotY(3, 2, 0.4);
+        sim.applyGateCH(0, 6);
+        sim.applyGateCRotY(4, 5, 0.9);
+        sim.applyGateCU(sim.getGateX(), 1, 0);
+        sim.applyGateCCX(3, 4, 7);
+        sim.applyGateCCX(4, 1, 3);
+        sim.applyGateCSwap(4, 0, 7);
+        sim.applyRegisterPermutation({4, 7}, [](std::size_t val){ return (val + 1) % 4; });
+        sim.resetQubit(4);
+        sim.collapseToBasisZ(7, sim.getStateProbability(7) > 0.5);
+    };
+
+    IntelSimulator sim(num_qubits), sim_real(num_qubits, false, true), sim_ref(num_qubits);
+    sim_ref.setClassicalTracking(false);
+
+    SECTION("Tracked values"){
+        sim.applyGateX(0);
+        sim.applyGateCX(0, 4);
+        sim.applyGateCX(1, 5);
+        REQUIRE(sim.isClassicalQubit(0));
+        REQUIRE(sim.isClassicalQubit(4));
+        REQUIRE(sim.isClassicalQubit(5));
+        REQUIRE(sim.getStateProbability(4) == Approx(1.));
+        REQUIRE(sim.getStateProbability(5) == Approx(0.));
+        sim.applyGateH(1);
+        REQUIRE_FALSE(sim.isClassicalQubit(1));
+        REQUIRE_FALSE(sim_ref.isClassicalQubit(0));
+
+        // The deferred X gates are applied when the register is read
+        auto& r = sim.getQubitRegister();
+        REQUIRE(std::norm(r[0b10001]) == Approx(0.5));
+        REQUIRE(std::norm(r[0b10011]) == Approx(0.5));
+    }
+
+    SECTION("Matches untracked simulation"){
+        circuit(sim);
+        circuit(sim_real);
+        circuit(sim_ref);
+        REQUIRE(sim.isClassicalQubit(4));
+        REQUIRE(sim.isClassicalQubit(7));
+
+        test::requireEqualStates(sim, sim_ref);
+        test::requireEqualStates(sim_real, sim_ref);
+    }
+
+    SECTION("Pattern and Fourier kernels"){
+        for(auto s : {&sim, &sim_ref}){
+            s->applyGateX(0);
+            s->applyGateX(2);
+            s->applyGateH(1);
+            s->applyGateH(3);
+        }
+        std::vector<std::size_t> qubits {0, 1, 2, 3};
+        REQUIRE(sim.getPatternProbability(qubits, {0b0101, 0b1111}) == Approx(sim_ref.getPatternProbability(qubits, {0b0101, 0b1111})));
+        for(auto s : {&sim, &sim_ref}){
+            s->applyPatternPhaseFlip(qubits, {0b0111});
+            s->applyFourierTransform(0, 2, false);
+        }
+        test::requireEqualStates(sim, sim_ref);
+    }
+}
+
+/**
+ * @brief Test a reference to the register taken before a circuit against the register read after it; deferred X gates, scheduled gates and relabelling swaps must all reach the referenced register
+ * 
+ */
+TEST_CASE("Register references"){
+    std::size_t num_qubits = 8;
+
+    auto circuit = [](IntelSimulator& sim){
+        sim.applyGateX(0);
+        sim.applyGateX(6);
+        sim.applyGateH(1);
+        sim.applyGateRotY(2, 0.7);
+        sim.applyGateCX(0, 4);
+        sim.applyGateSwap(1, 5);
+        sim.applyGateCRotY(5, 3, 0.4);
+        sim.applyGateSwap(0, 7);
+        sim.resetQubit(6);
+        sim.applyGateX(6);
+        sim.applyGateCCX(7, 5, 2);
+    };
+
+    IntelSimulator sim(num_qubits), sim_real(num_qubits, false, true), sim_ref(num_qubits);
+    for(auto s : {&sim, &sim_real, &sim_ref}){
+        s->setGateBlockQubits(4);
+    }
+    auto& r = sim.getQubitRegister();
+    auto& r_real = sim_real.getQubitRegister();
+    circuit(sim);
+    circuit(sim_real);
+    circuit(sim_ref);
+
+    SECTION("Gates are applied eagerly until initialisation"){
+        REQUIRE_FALSE(sim.isClassicalQubit(4));
+        REQUIRE(sim.getQubitMap() == std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6, 7});
+        sim.initRegister();
+        sim.applyGateX(0);
+        REQUIRE(sim.isClassicalQubit(0));
+    }
+    SECTION("Tracking enabled explicitly"){
+        sim.setClassicalTracking(true);
+        sim.resetQubit(6);
+        REQUIRE(sim.isClassicalQubit(6));
+    }
+    SECTION("State"){
+        const auto& r_ref = static_cast<const IntelSimulator&>(sim_ref).getQubitRegister();
+        for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+            CAPTURE(i);
+            REQUIRE(r[i].real() == Approx(r_ref[i].real()).margin(1e-12));
+            REQUIRE(r[i].imag() == Approx(r_ref[i].imag()).margin(1e-12));
+            REQUIRE(r_real[i].real() == Approx(r_ref[i].real()).margin(1e-12));
+            REQUIRE(r_real[i].imag() == Approx(r_ref[i].imag()).margin(1e-12));
+        }
+        // Reading through the const overload keeps qubits tracked
+        REQUIRE(sim_ref.isClassicalQubit(4));
+        sim.applyGateX(4);
+        sim_ref.applyGateX(4);
+        test::requireEqualStates(sim, sim_ref);
+    }
+    SECTION("Snapshot restored"){
+        sim.storeStateSnapshot();
+        sim.applyGateSwap(2, 3);
+        sim.applyGateH(4);
+        sim.restoreStateSnapshot();
+        test::requireEqualStates(sim, sim_ref);
+        REQUIRE(&sim.getQubitRegister() == &r);
+    }
+}
+
+/**
+ * @brief Test batched operations against the same gates applied one call at a time
+ * 
+ */
+TEST_CASE("Batched operations"){
+    std::size_t num_qubits = 6;
+
+    OpBuffer ops;
+    ops.add(OpCode::H, {0})
+       .add(OpCode::RotY, {1}, 0.4)
+       .add(OpCode::RotZ, {1}, 0.7)
+       .add(OpCode::X, {2})
+       .add(OpCode::RotX, {0}, 1.1)
+       .add(OpCode::CX, {1, 3})
+       .add(OpCode::SqrtX, {3})
+       .add(OpCode::Y, {3})
+       .add(OpCode::CRotY, {0, 4}, 0.3)
+       .add(OpCode::CPhaseShift, {2, 5}, 0.9)
+       .add(OpCode::CCX, {0, 1, 5})
+       .add(OpCode::H, {5})
+       .add(OpCode::Z, {5})
+       .add(OpCode::Swap, {2, 4})
+       .add(OpCode::CSwap, {3, 1, 2})
+       .add(OpCode::Reset, {0})
+       .add(OpCode::RotY, {0}, 0.2)
+       .add(OpCode::H, {4});
+
+    auto apply_gates = [](IntelSimulator& sim){
+        sim.applyGateH(0);
+        sim.applyGateRotY(1, 0.4);
+        sim.applyGateRotZ(1, 0.7);
+        sim.applyGateX(2);
+        sim.applyGateRotX(0, 1.1);
+        sim.applyGateCX(1, 3);
+        sim.applyGateSqrtX(3);
+        sim.applyGateY(3);
+        sim.applyGateCRotY(0, 4, 0.3);
+        sim.applyGateCPhaseShift(0.9, 2, 5);
+        sim.applyGateCCX(0, 1, 5);
+        sim.applyGateH(5);
+        sim.applyGateZ(5);
+        sim.applyGateSwap(2, 4);
+        sim.applyGateCSwap(3, 1, 2);
+        sim.resetQubit(0);
+        sim.applyGateRotY(0, 0.2);
+        sim.applyGateH(4);
+    };
+
+    IntelSimulator sim(num_qubits), sim_ref(num_qubits);
+    sim.applyOps(ops);
+    apply_gates(sim_ref);
+
+    SECTION("State"){
+        test::requireEqualStates(sim, sim_ref);
+    }
+
+    SECTION("Gate counts"){
+        REQUIRE(sim.getGateCounts() == sim_ref.getGateCounts());
+        REQUIRE(sim.getQubitUsage() == sim_ref.getQubitUsage());
+    }
+
+    SECTION("MPS simulator"){
+        MPSSimulator sim_mps(num_qubits);
+        sim_mps.applyOps(ops);
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim_mps.getStateProbability(i) == Approx(sim_ref.getStateProbability(i)).margin(1e-10));
+        }
+    }
+
+    SECTION("Invalid operations"){
+        const auto counts = sim.getGateCounts();
+        const std::uint32_t n = static_cast<std::uint32_t>(num_qubits);
+        // Each buffer starts with a valid gate, which must not be applied
+        for(auto bad : std::vector<Op>{{99, 0, 0, 0, 0.}, {static_cast<std::uint32_t>(OpCode::X), n, 0, 0, 0.},
+                                       {static_cast<std::uint32_t>(OpCode::CX), 1, n + 3, 0, 0.}, {static_cast<std::uint32_t>(OpCode::CCX), 0, 2, 2, 0.}}){
+            CAPTURE(bad.code, bad.q0, bad.q1, bad.q2);
+            const Op buffer[2] = {{static_cast<std::uint32_t>(OpCode::H), 0, 0, 0, 0.}, bad};
+            REQUIRE_THROWS_AS(sim.applyOps(buffer, 2), std::invalid_argument);
+
+            MPSSimulator sim_mps(num_qubits);
+            REQUIRE_THROWS_AS(sim_mps.applyOps(buffer, 2), std::invalid_argument);
+        }
+        OpBuffer ops;
+        REQUIRE_THROWS_AS(ops.add(OpCode::CCX, {0, 1, 2, 3}), std::invalid_argument);
+        REQUIRE_THROWS_AS(ops.add(OpCode::X, {0, 1}), std::invalid_argument);
+        REQUIRE(ops.size() == 0);
+        REQUIRE(sim.getGateCounts() == counts);
+        test::requireEqualStates(sim, sim_ref);
+    }
+}
+
+/**
+ * @brief Test the thread count and NUMA placement options
+ * 
+ */
+TEST_CASE("Thread and memory placement"){
+    std::size_t num_qubits = 16;
+    int num_threads = 1;
+    #ifdef _OPENMP
+    const int default_threads = omp_get_max_threads();
+    num_threads = 2;
+    #endif
+
+    for(auto memory : {MemoryPlacement::Default, MemoryPlacement::FirstTouch, MemoryPlacement::Interleave}){
+        DYNAMIC_SECTION("Placement " << static_cast<int>(memory)){
+            IntelSimulator sim(num_qubits, false, false, PlacementOptions{num_threads, false, memory}), sim_ref(num_qubits);
+            auto info = sim.getPlacement();
+            REQUIRE(info.num_threads == num_threads);
+            REQUIRE(info.thread_cpus.size() == static_cast<std::size_t>(num_threads));
+
+            // Only the pages wholly within the state-vector are reported
+            const std::size_t state_bytes = sizeof(ComplexDP) << num_qubits;
+            if(!info.node_bytes.empty()){
+                const std::size_t resident = std::accumulate(info.node_bytes.begin(), info.node_bytes.end(), std::size_t(0));
+                REQUIRE(resident <= state_bytes);
+                REQUIRE(resident > state_bytes / 2);
+            }
+
+            for(std::size_t i = 0; i < num_qubits; i++){
+                sim.applyGateRotY(i, 0.1 + 0.1*i);
+                sim_ref.applyGateRotY(i, 0.1 + 0.1*i);
+            }
+            sim.applyGateCX(0, num_qubits - 1);
+            sim_ref.applyGateCX(0, num_qubits - 1);
+            REQUIRE(sim.overlap(sim_ref).real() == Approx(1.));
+        }
+    }
+    #ifdef _OPENMP
+    // The thread count is scoped to the simulator
+    REQUIRE(omp_get_max_threads() == default_threads);
+    #endif
+
+    #ifdef __linux__
+    SECTION("Thread binding"){
+        cpu_set_t caller_mask;
+        REQUIRE(sched_getaffinity(0, sizeof(caller_mask), &caller_mask) == 0);
+        const std::size_t num_cpus = getProcessCpus().size();
+
+        // Each bound simulator spreads its threads over the process CPUs, and unbinds them on return
+        IntelSimulator sim0(num_qubits, false, false, PlacementOptions{num_threads, true}), sim1(num_qubits, false, false, PlacementOptions{num_threads, true});
+        for(auto s : {&sim0, &sim1}){
+            auto info = s->getPlacement();
+            if(num_cpus >= static_cast<std::size_t>(num_threads)){
+                std::sort(info.thread_cpus.begin(), info.thread_cpus.end());
+                REQUIRE(std::adjacent_find(info.thread_cpus.begin(), info.thread_cpus.end()) == info.thread_cpus.end());
+            }
+            s->applyGateH(0);
+            s->applyGateCX(0, num_qubits - 1);
+        }
+        REQUIRE(sim0.overlap(sim1).real() == Approx(1.));
+
+        cpu_set_t mask;
+        REQUIRE(sched_getaffinity(0, sizeof(mask), &mask) == 0);
+        REQUIRE(CPU_EQUAL(&mask, &caller_mask));
+    }
+    #endif
+}
+
+/**
+ * @brief Test the reuse of arena buffers and of the registers of destroyed simulators
+ *
+ */
+TEST_CASE("Arena allocation and register recycling"){
+    Arena& arena = Arena::getInstance();
+    arena.release();
+    REQUIRE(arena.getStats().retained_bytes == 0);
+
+    SECTION("Buffers"){
+        for(std::size_t bytes : {std::size_t(1000), std::size_t(3) << 20}){
+            void* data = arena.allocate(bytes);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(data) % Arena::alignment == 0);
+            std::fill_n(static_cast<char*>(data), bytes, 1);
+            arena.deallocate(data, bytes);
+            REQUIRE(arena.getStats().retained_bytes >= bytes);
+
+            const std::size_t num_reused = arena.getStats().num_reused;
+            REQUIRE(arena.allocate(bytes) == data);
+            REQUIRE(arena.getStats().num_reused == num_reused + 1);
+            arena.deallocate(data, bytes);
+        }
+        arena.release();
+        REQUIRE(arena.getStats().retained_bytes == 0);
+    }
+
+    SECTION("Registers"){
+        std::size_t num_qubits = 14;
+        auto apply_circuit = [num_qubits](IntelSimulator& sim){
+            for(std::size_t i = 0; i < num_qubits; i++){
+                sim.applyGateH(i);
+                sim.applyGateRotZ(i, 0.2 + 0.1*i);
+            }
+            sim.applyGateCX(1, num_qubits - 2);
+        };
+
+        IntelSimulator sim_ref(num_qubits);
+        apply_circuit(sim_ref);
+
+        const ComplexDP* state = nullptr;
+        {
+            IntelSimulator sim(num_qubits);
+            apply_circuit(sim);
+            state = &sim.getQubitRegister()[0];
+        }
+        REQUIRE(arena.getStats().retained_bytes == sizeof(ComplexDP) << num_qubits);
+
+        // The recycled register is reset to |0>
+        IntelSimulator sim(num_qubits);
+        REQUIRE(&sim.getQubitRegister()[0] == state);
+        REQUIRE(arena.getStats().retained_bytes == 0);
+        REQUIRE(sim.getQubitRegister()[0] == ComplexDP(1., 0.));
+        apply_circuit(sim);
+        REQUIRE(sim.overlap(sim_ref).real() == Approx(1.));
+
+        // Registers are freed beyond the capacity
+        arena.setCapacity(0);
+        {
+            IntelSimulator sim_free(num_qubits);
+        }
+        REQUIRE(arena.getStats().retained_bytes == 0);
+        arena.setCapacity(Arena::default_capacity);
+    }
+}
+
+/**
+ * @brief Test the shot runner, whose histograms depend only on the run seed and not on the number of workers
+ *
+ */
+TEST_CASE("Ensemble shot runner"){
+    std::size_t num_qubits = 6;
+    std::size_t num_shots = 4000;
+    const std::vector<std::size_t> reg = {0, 1, 2};
+
+    // Outcomes 0-3 with probabilities 1/8, 1/8, 3/8, 3/8, measured on the first two qubits
+    auto circuit = [&reg](IntelSimulator& sim) -> std::size_t {
+        sim.applyGateH(0);
+        sim.applyGateRotY(1, 2.*M_PI/3.);
+        sim.applyGateCX(1, 4);
+        return sim.applyMeasurementToRegister(reg);
+    };
+
+    int max_threads = 1;
+    #ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+    #endif
+
+    Ensemble<IntelSimulator> ensemble(num_qubits, 3);
+    auto result = ensemble.run(circuit, num_shots, 42);
+    REQUIRE(result.num_shots == num_shots);
+    REQUIRE(result.shots_per_second > 0.);
+
+    std::size_t total = 0;
+    for(auto& count : result.counts){
+        REQUIRE(count.first < 4);
+        total += count.second;
+    }
+    REQUIRE(total == num_shots);
+    REQUIRE(result.counts[0] / static_cast<double>(num_shots) == Approx(0.125).margin(0.03));
+    REQUIRE(result.counts[3] / static_cast<double>(num_shots) == Approx(0.375).margin(0.03));
+
+    // Reproducible for any number of workers, and independent of the seed otherwise
+    Ensemble<IntelSimulator> ensemble_single(num_qubits, 1);
+    REQUIRE(ensemble_single.run(circuit, num_shots, 42).counts == result.counts);
+    REQUIRE(ensemble.run(circuit, num_shots, 42).counts == result.counts);
+    REQUIRE(ensemble.run(circuit, num_shots, 43).counts != result.counts);
+
+    #ifdef _OPENMP
+    REQUIRE(omp_get_max_threads() == max_threads);
+    #endif
+}
+
+/**
+ * @brief Test the MPS simulator against the state-vector simulator, with gates between non-adjacent qubits, and with the encoding and Hamming distance routines
+ * 
+ */
+TEST_CASE("MPS simulator"){
+    SECTION("Gates on adjacent and non-adjacent qubits"){
+        std::size_t num_qubits = 7;
+
+        auto apply_circuit = [num_qubits](auto& sim){
+            for(std::size_t i = 0; i < num_qubits; i++){
+                sim.applyGateH(i);
+                sim.applyGateRotY(i, 0.3 + 0.2*i);
+                sim.applyGateRotZ(i, 0.1*i);
+            }
+            sim.applyGateCX(0, 5);
+            sim.applyGateCZ(6, 1);
+            sim.applyGateCCX(5, 1, 3);
+            sim.applyGateCSwap(2, 0, 4);
+            sim.applyGateCRotX(3, 6, 0.9);
+            sim.applyGateCPhaseShift(0.7, 4, 2);
+            sim.applyGateSqrtSwap(6, 0);
+            sim.applyGateSwap(1, 5);
+            sim.applyGateSqrtX(2);
+            sim.applyGatePhaseShift(3, 1.1);
+            sim.applyGateNCU(sim.getGateX(), {0, 1, 2, 6}, 5, "X");
+            sim.applyQFT(1, 5);
+            sim.collapseToBasisZ(4, true);
+        };
+
+        IntelSimulator sim_sv(num_qubits);
+        MPSSimulator sim_mps(num_qubits);
+        apply_circuit(sim_sv);
+        apply_circuit(sim_mps);
+
+        auto& r_sv = sim_sv.getQubitRegister();
+        for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+            CAPTURE(i);
+            REQUIRE(sim_mps.getAmplitude(i).real() == Approx(r_sv[i].real()).margin(1e-10));
+            REQUIRE(sim_mps.getAmplitude(i).imag() == Approx(r_sv[i].imag()).margin(1e-10));
+        }
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim_mps.getStateProbability(i) == Approx(sim_sv.getStateProbability(i)).margin(1e-10));
+        }
+        REQUIRE(sim_mps.getTruncationError() == Approx(0.).margin(1e-12));
+    }
+
+    SECTION("Encoding and Hamming distance"){
+        std::size_t len_bin_pattern = 4;
+        std::vector<std::size_t> reg_mem {0, 1, 2, 3};
+        std::vector<std::size_t> reg_auxiliary {4, 5, 6, 7, 8, 9};
+        std::vector<std::size_t> bin_patterns {0b0011, 0b1010, 0b1111};
+
+        auto apply_circuit = [&](auto& sim){
+            sim.encodeBinToSuperpos_unique(reg_mem, reg_auxiliary, bin_patterns, len_bin_pattern);
+            sim.applyHammingDistanceOverwrite(0b0110, reg_mem, reg_auxiliary, len_bin_pattern);
+        };
+
+        IntelSimulator sim_sv(reg_mem.size() + reg_auxiliary.size());
+        MPSSimulator sim_mps(reg_mem.size() + reg_auxiliary.size());
+        apply_circuit(sim_sv);
+        apply_circuit(sim_mps);
+
+        for(std::size_t i = 0; i < sim_sv.getNumQubits(); i++){
+            CAPTURE(i);
+            REQUIRE(sim_mps.getStateProbability(i) == Approx(sim_sv.getStateProbability(i)).margin(1e-10));
+        }
+        // The encoded state is a superposition of 3 patterns, so no bond exceeds dimension 3
+        auto bond_dims = sim_mps.getBondDimensions();
+        REQUIRE(*std::max_element(bond_dims.begin(), bond_dims.end()) <= bin_patterns.size());
+    }
+
+    SECTION("Large register sampling and measurement"){
+        std::size_t num_qubits = 80;
+        MPSSimulator sim(num_qubits);
+
+        // GHZ state over all qubits
+        sim.applyGateH(0);
+        for(std::size_t i = 1; i < num_qubits; i++){
+            sim.applyGateCX(0, i);
+        }
+        auto bond_dims = sim.getBondDimensions();
+        REQUIRE(bond_dims.size() == num_qubits - 1);
+        REQUIRE(*std::max_element(bond_dims.begin(), bond_dims.end()) == 2);
+        for(std::size_t i = 0; i < num_qubits; i++){
+            REQUIRE(sim.getStateProbability(i) == Approx(0.5));
+        }
+
+        std::size_t num_ones = 0;
+        for(std::size_t shot = 0; shot < 100; shot++){
+            auto bits = sim.sample();
+            REQUIRE(bits.size() == num_qubits);
+            REQUIRE(static_cast<std::size_t>(std::count(bits.begin(), bits.end(), bits[0])) == num_qubits);
+            num_ones += bits[0];
+        }
+        REQUIRE(num_ones > 0);
+        REQUIRE(num_ones < 100);
+
+        bool val = sim.applyMeasurement(num_qubits / 2);
+        for(std::size_t i = 0; i < num_qubits; i++){
+            REQUIRE(sim.getStateProbability(i) == Approx(val ? 1. : 0.).margin(1e-12));
+        }
+
+        sim.initRegister();
+        for(std::size_t i = 0; i < num_qubits; i++){
+            REQUIRE(sim.getStateProbability(i) == Approx(0.).margin(1e-12));
+        }
+    }
+
+    SECTION("Bond dimension truncation"){
+        MPSSimulator sim(4);
+        sim.setMaxBondDimension(1);
+        sim.applyGateRotY(1, 0.5);
+        sim.applyGateCX(1, 2);
+        sim.applyGateRotY(0, 1.0);
+        sim.applyGateCX(0, 3);
+
+        // Each CX truncates the smaller Schmidt coefficient, sin^2(angle/2)
+        REQUIRE(sim.getTruncationError() == Approx(std::pow(std::sin(0.25), 2) + std::pow(std::sin(0.5), 2)));
+        auto bond_dims = sim.getBondDimensions();
+        REQUIRE(*std::max_element(bond_dims.begin(), bond_dims.end()) == 1);
+        for(std::size_t i = 0; i < 4; i++){
+            REQUIRE(sim.getStateProbability(i) == Approx(0.).margin(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Test the batched simulator against per-state Intel-QS simulations, for identical states, per-state test patterns and per-state measurement outcomes
+ */
+TEST_CASE("Batch simulator"){
+    SECTION("Gates applied to every state"){
+        std::size_t num_qubits = 6;
+        std::size_t num_states = 5;
+
+        auto apply_circuit = [num_qubits](auto& sim){
+            for(std::size_t i = 0; i < num_qubits; i++){
+                sim.applyGateH(i);
+                sim.applyGateRotY(i, 0.3 + 0.2*i);
+                sim.applyGateRotZ(i, 0.1*i);
+            }
+            sim.applyGateCX(0, 5);
+            sim.applyGateCZ(4, 1);
+            sim.applyGateCCX(5, 1, 3);
+            sim.applyGateCSwap(2, 0, 4);
+            sim.applyGateCRotX(3, 1, 0.9);
+            sim.applyGateCPhaseShift(0.7, 4, 2);
+            sim.applyGateSqrtSwap(5, 0);
+            sim.applyGateSwap(1, 4);
+            sim.applyGateSqrtX(2);
+            sim.applyGatePhaseShift(3, 1.1);
+            sim.applyGateNCU(sim.getGateX(), {0, 1, 2}, 5, "X");
+            sim.applyQFT(1, 4);
+            sim.collapseToBasisZ(4, true);
+        };
+
+        IntelSimulator sim_sv(num_qubits);
+        BatchSimulator sim_batch(num_qubits, num_states);
+        apply_circuit(sim_sv);
+        apply_circuit(sim_batch);
+
+        auto& r_sv = sim_sv.getQubitRegister();
+        for(std::size_t k = 0; k < num_states; k++){
+            for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+                CAPTURE(k, i);
+                REQUIRE(sim_batch.getAmplitude(i, k).real() == Approx(r_sv[i].real()).margin(1e-10));
+                REQUIRE(sim_batch.getAmplitude(i, k).imag() == Approx(r_sv[i].imag()).margin(1e-10));
+            }
+        }
+        for(std::size_t i = 0; i < num_qubits; i++){
+            CAPTURE(i);
+            REQUIRE(sim_batch.getStateProbability(i) == Approx(sim_sv.getStateProbability(i)).margin(1e-10));
+        }
+    }
+
+    SECTION("Test pattern sweep"){
+        std::size_t len_bin_pattern = 4;
+        std::vector<std::size_t> reg_mem {0, 1, 2, 3};
+        std::vector<std::size_t> reg_auxiliary {4, 5, 6, 7, 8, 9};
+        std::vector<std::size_t> bin_patterns {0b0011, 0b1010, 0b1111};
+        std::vector<std::size_t> test_patterns;
+        for(std::size_t pattern = 0; pattern < (0b1UL << len_bin_pattern); pattern++){
+            test_patterns.push_back(pattern);
+        }
+
+        BatchSimulator sim_batch(reg_mem.size() + reg_auxiliary.size(), test_patterns.size());
+        sim_batch.encodeBinToSuperpos_unique(reg_mem, reg_auxiliary, bin_patterns, len_bin_pattern);
+        sim_batch.applyHammingDistanceRotY(test_patterns, reg_mem, reg_auxiliary, len_bin_pattern);
+
+        for(std::size_t k = 0; k < test_patterns.size(); k++){
+            IntelSimulator sim_sv(reg_mem.size() + reg_auxiliary.size());
+            sim_sv.encodeBinToSuperpos_unique(reg_mem, reg_auxiliary, bin_patterns, len_bin_pattern);
+            sim_sv.applyHammingDistanceRotY(test_patterns[k], reg_mem, reg_auxiliary, len_bin_pattern);
+
+            auto& r_sv = sim_sv.getQubitRegister();
+            for(std::size_t i = 0; i < (0b1UL << sim_sv.getNumQubits()); i++){
+                CAPTURE(k, i);
+                REQUIRE(sim_batch.getAmplitude(i, k).real() == Approx(r_sv[i].real()).margin(1e-10));
+                REQUIRE(sim_batch.getAmplitude(i, k).imag() == Approx(r_sv[i].imag()).margin(1e-10));
+            }
+        }
+    }
+
+    SECTION("Per-state measurement"){
+        std::size_t num_qubits = 3;
+        std::size_t num_states = 4000;
+        BatchSimulator sim(num_qubits, num_states);
+        sim.setRandomSeed(42);
+
+        // P(q0 = 1) = 1/4; q1 follows q0
+        sim.applyGateRotY(0, 2.*std::asin(0.5));
+        sim.applyGateCX(0, 1);
+        sim.applyGateH(2);
+
+        auto vals = sim.applyMeasurementToRegisterBatch({0, 1});
+        REQUIRE(vals.size() == num_states);
+        std::size_t num_ones = 0;
+        for(std::size_t k = 0; k < num_states; k++){
+            CAPTURE(k);
+            // Both qubits collapse together, leaving each state normalised on its own outcome
+            REQUIRE((vals[k] == 0b00 || vals[k] == 0b11));
+            num_ones += (vals[k] == 0b11);
+            double norm = 0.;
+            for(std::size_t i = 0; i < (0b1UL << num_qubits); i++){
+                norm += std::norm(sim.getAmplitude(i, k));
+                if((i & 0b11) != vals[k]){
+                    REQUIRE(std::norm(sim.getAmplitude(i, k)) == Approx(0.).margin(1e-12));
+                }
+            }
+            REQUIRE(norm == Approx(1.));
+        }
+        REQUIRE(num_ones == Approx(num_states / 4).margin(5*std::sqrt(num_states * 3. / 16)));
+
+        auto probs = sim.getStateProbabilities(2);
+        for(auto p : probs){
+            REQUIRE(p == Approx(0.5));
+        }
+
+        sim.initRegister();
+        sim.setRandomSeed(42);
+        sim.applyGateRotY(0, 2.*std::asin(0.5));
+        sim.applyGateCX(0, 1);
+        REQUIRE(sim.applyMeasurementToRegisterBatch({0, 1}) == vals);
+    }
+}
+
+/**
+ * @brief Test the counter-based measurement random streams: known answers of the generator, seeding through the constructor, setRandomSeed and initRegister, and agreement of the streams across backends
+ */
+TEST_CASE("Counter-based random streams"){
+    SECTION("Philox4x32-10 known answers"){
+        using Block = PhiloxStream::Block;
+        REQUIRE(PhiloxStream::philox4x32({0, 0, 0, 0}, {0, 0}) == Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+        REQUIRE(PhiloxStream::philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) == Block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+        REQUIRE(PhiloxStream::philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) == Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+        PhiloxStream rng(11, 3);
+        std::vector<double> draws;
+        for(std::size_t d = 0; d < 8; d++){
+            draws.push_back(rng.uniform());
+            REQUIRE(draws.back() == PhiloxStream::uniform(11, 3, d));
+            REQUIRE(draws.back() >= 0.);
+            REQUIRE(draws.back() < 1.);
+        }
+        rng.setDrawIndex(5);
+        REQUIRE(rng.uniform() == draws[5]);
+        REQUIRE(PhiloxStream::uniform(11, 4, 0) != draws[0]);
+        REQUIRE(PhiloxStream::uniform(12, 3, 0) != draws[0]);
+    }
+
+    std::size_t num_qubits = 4;
+    std::vector<std::size_t> reg(num_qubits);
+    std::iota(reg.begin(), reg.end(), 0);
+    auto apply_circuit = [&](auto& sim){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateH(i);
+        }
+        sim.applyGateCRotY(0, 1, 0.4);
+        std::size_t val = sim.applyMeasurementToRegister(reg);
+        return (val << num_qubits) | sim.applyMeasurementToRegister(reg);
+    };
+
+    SECTION("Seeding through the constructor, setRandomSeed and initRegister"){
+        std::vector<std::size_t> vals;
+        for(std::size_t shot = 0; shot < 32; shot++){
+            IntelSimulator sim(num_qubits, false, false, PlacementOptions(), 5);
+            sim.setRandomSeed(5, shot);
+            vals.push_back(apply_circuit(sim));
+        }
+        REQUIRE(static_cast<std::size_t>(std::count(vals.begin(), vals.end(), vals[0])) < vals.size());
+
+        IntelSimulator sim(num_qubits, false, false, PlacementOptions(), 5);
+        REQUIRE(sim.getRandomSeed() == 5);
+        REQUIRE(apply_circuit(sim) == vals[0]);
+        for(std::size_t shot = 0; shot < vals.size(); shot++){
+            CAPTURE(shot);
+            sim.initRegister(5, shot);
+            REQUIRE(apply_circuit(sim) == vals[shot]);
+        }
+
+        // An unseeded simulator reports its seed, from which its run may be reproduced
+        IntelSimulator sim_unseeded(num_qubits);
+        std::size_t val = apply_circuit(sim_unseeded);
+        sim.initRegister(sim_unseeded.getRandomSeed());
+        REQUIRE(apply_circuit(sim) == val);
+    }
+
+    SECTION("Shots agree across backends"){
+        std::size_t num_states = 20;
+        BatchSimulator sim_batch(num_qubits, num_states, 9);
+        sim_batch.setRandomSeed(9, 100);
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim_batch.applyGateH(i);
+        }
+        sim_batch.applyGateCRotY(0, 1, 0.4);
+        auto vals_hi = sim_batch.applyMeasurementToRegisterBatch(reg);
+        auto vals_lo = sim_batch.applyMeasurementToRegisterBatch(reg);
+
+        IntelSimulator sim_sv(num_qubits);
+        MPSSimulator sim_mps(num_qubits);
+        for(std::size_t k = 0; k < num_states; k++){
+            CAPTURE(k);
+            sim_sv.initRegister(9, 100 + k);
+            sim_mps.initRegister(9, 100 + k);
+            std::size_t val = apply_circuit(sim_sv);
+            REQUIRE(val == ((vals_hi[k] << num_qubits) | vals_lo[k]));
+            REQUIRE(apply_circuit(sim_mps) == val);
+        }
+    }
+}
 
 /**
  * @brief Test the encoding of binary patterns into a superposition of states into an even distribution
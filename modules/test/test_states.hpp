@@ -0,0 +1,60 @@
+/**
+ * @file test_states.hpp
+ * @brief Shared fixtures for tests comparing simulator states, such as a native kernel against its gate decomposition.
+ * @version 0.1
+ */
+
+#ifndef QNLP_TEST_STATES
+#define QNLP_TEST_STATES
+
+#include "catch2/catch.hpp"
+#include <cstddef>
+
+namespace QNLP{
+namespace test{
+    /**
+     * @brief Prepare a product state with a distinct amplitude, and phase, on every basis state of the low qubits, by a Y rotation of 0.3 + 0.2*i and Z rotation of 0.1*i on each qubit i. The remaining qubits are left in the state |0>, e.g. as ancillas.
+     *
+     * @param sim Simulator, in the state |0...0>
+     * @param num_qubits Number of low qubits prepared
+     */
+    template<class SimulatorType>
+    void prepareDistinctState(SimulatorType& sim, std::size_t num_qubits){
+        for(std::size_t i = 0; i < num_qubits; i++){
+            sim.applyGateRotY(i, 0.3 + 0.2*i);
+            sim.applyGateRotZ(i, 0.1*i);
+        }
+    }
+
+    /**
+     * @brief Prepare a product state with a distinct amplitude, and phase, on every basis state of the register
+     *
+     * @param sim Simulator, in the state |0...0>
+     */
+    template<class SimulatorType>
+    void prepareDistinctState(SimulatorType& sim){
+        prepareDistinctState(sim, sim.getNumQubits());
+    }
+
+    /**
+     * @brief Require the amplitudes of the registers of two simulators of the same number of qubits to agree
+     *
+     * @param sim0 Simulator
+     * @param sim1 Reference simulator
+     * @param margin Absolute tolerance of the real and imaginary parts of each amplitude
+     */
+    template<class SimulatorType0, class SimulatorType1>
+    void requireEqualStates(SimulatorType0& sim0, SimulatorType1& sim1, double margin = 1e-12){
+        REQUIRE(sim0.getNumQubits() == sim1.getNumQubits());
+        const auto& r0 = sim0.getQubitRegister();
+        const auto& r1 = sim1.getQubitRegister();
+        for(std::size_t i = 0; i < (0b1UL << sim0.getNumQubits()); i++){
+            CAPTURE(i);
+            REQUIRE(r0[i].real() == Approx(r1[i].real()).margin(margin));
+            REQUIRE(r0[i].imag() == Approx(r1[i].imag()).margin(margin));
+        }
+    }
+};
+};
+
+#endif
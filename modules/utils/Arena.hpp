@@ -0,0 +1,438 @@
+/**
+ * @file Arena.hpp
+ * @brief Pooled, aligned and huge-page backed allocation of state-vector sized buffers. Freed buffers and recycled objects are retained by size for reuse, up to the capacity of the arena. Huge pages are only used on Linux; elsewhere, or where none are available, buffers fall back to regular pages.
+ * @version 0.1
+ */
+
+#ifndef QNLP_ARENA
+#define QNLP_ARENA
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif
+
+namespace QNLP{
+    /**
+     * @brief Page size backing the buffers of the arena
+     */
+    enum class HugePages {
+        Regular,     ///< Regular pages
+        Transparent, ///< Regular pages advised as transparent huge page candidates (madvise)
+        Huge2MB,     ///< Explicit 2 MB huge pages, falling back to Transparent if none are reserved
+        Huge1GB      ///< Explicit 1 GB huge pages for buffers of at least 1 GB, falling back to Huge2MB
+    };
+
+    /**
+     * @brief Allocation statistics of the arena
+     */
+    struct ArenaStats {
+        std::size_t num_allocated = 0;  ///< Buffers allocated from the OS
+        std::size_t num_reused = 0;     ///< Buffers and objects served from those retained
+        std::size_t retained_bytes = 0; ///< Bytes of freed buffers and recycled objects retained for reuse
+        std::size_t huge_bytes = 0;     ///< Bytes of the buffers mapped with explicit huge pages
+    };
+
+    /**
+     * @brief Advise the OS to back the pages wholly within the given memory with transparent huge pages. Memory already touched is collapsed into huge pages in the background.
+     *
+     * @return true if the advice was accepted
+     */
+    inline bool adviseHugePages(void* data, std::size_t bytes){
+        #if defined(__linux__) && defined(MADV_HUGEPAGE)
+        constexpr std::uintptr_t huge_page = 1UL << 21;
+        const std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + huge_page - 1) / huge_page * huge_page;
+        const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / huge_page * huge_page;
+        if(end <= begin){
+            return true;
+        }
+        return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+        #else
+        return false;
+        #endif
+    }
+
+    /**
+     * @brief Class definition of the process-wide arena of aligned buffers. Follows the Meyers singleton pattern; see Singleton.hpp.
+     */
+    class Arena{
+        public:
+        //Alignment of all buffers, being that of the Intel-QS state-vector
+        static constexpr std::size_t alignment = 256;
+        //Buffers of at least this size are mapped directly, and may be backed by huge pages
+        static constexpr std::size_t mapped_threshold = 1UL << 21;
+        //Default bound of the memory retained for reuse
+        static constexpr std::size_t default_capacity = 1UL << 32;
+
+        Arena(const Arena&) = delete;
+        Arena(Arena&&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        Arena& operator=(Arena&&) = delete;
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return Arena& Process-wide arena
+         */
+        static Arena& getInstance(){
+            static Arena arena;
+            return arena;
+        }
+
+        /**
+         * @brief Allocate a buffer of the given size, reusing a retained buffer of the same size if any
+         *
+         * @param bytes Size of the buffer in bytes
+         * @return void* Buffer aligned to Arena::alignment
+         */
+        void* allocate(std::size_t bytes){
+            const std::size_t size = roundUp(bytes, alignment);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                auto it = pool.find(size);
+                if(it != pool.end()){
+                    void* data = it->second;
+                    pool.erase(it);
+                    stats.retained_bytes -= size;
+                    stats.num_reused++;
+                    return data;
+                }
+                stats.num_allocated++;
+            }
+            void* data = (size < mapped_threshold) ? std::aligned_alloc(alignment, size) : mapBuffer(size);
+            if(data == nullptr){
+                throw std::bad_alloc();
+            }
+            return data;
+        }
+
+        /**
+         * @brief Free a buffer allocated by the arena, retaining it for reuse if within the capacity
+         *
+         * @param data Buffer
+         * @param bytes Size of the buffer in bytes, as allocated
+         */
+        void deallocate(void* data, std::size_t bytes){
+            const std::size_t size = roundUp(bytes, alignment);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if(stats.retained_bytes + size <= capacity){
+                    pool.emplace(size, data);
+                    stats.retained_bytes += size;
+                    return;
+                }
+            }
+            freeBuffer(data, size);
+        }
+
+        /**
+         * @brief Account for an object of the given size retained for reuse outside the arena (see Recycler)
+         *
+         * @return true if the object is within the capacity, and so may be retained
+         */
+        bool retain(std::size_t bytes){
+            std::lock_guard<std::mutex> lock(mtx);
+            if(stats.retained_bytes + bytes > capacity){
+                return false;
+            }
+            stats.retained_bytes += bytes;
+            return true;
+        }
+
+        /**
+         * @brief Account for an object retained by retain, being reused or freed
+         *
+         * @param bytes Size of the object in bytes
+         * @param reused Whether the object is reused
+         */
+        void unretain(std::size_t bytes, bool reused){
+            std::lock_guard<std::mutex> lock(mtx);
+            stats.retained_bytes -= bytes;
+            if(reused){
+                stats.num_reused++;
+            }
+        }
+
+        /**
+         * @brief Register a function freeing the objects retained outside the arena, called by release
+         */
+        void addReleaseHook(std::function<void()> hook){
+            std::lock_guard<std::mutex> lock(mtx);
+            release_hooks.push_back(hook);
+        }
+
+        /**
+         * @brief Return all retained buffers and objects to the OS
+         */
+        void release(){
+            std::vector<std::function<void()>> hooks;
+            std::multimap<std::size_t, void*> released;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                hooks = release_hooks;
+                released.swap(pool);
+                for(auto& buffer : released){
+                    stats.retained_bytes -= buffer.first;
+                }
+            }
+            for(auto& buffer : released){
+                freeBuffer(buffer.second, buffer.first);
+            }
+            for(auto& hook : hooks){
+                hook();
+            }
+        }
+
+        /**
+         * @brief Set the page size backing buffers allocated from the OS from now on
+         */
+        void setHugePages(HugePages pages){
+            std::lock_guard<std::mutex> lock(mtx);
+            huge_pages = pages;
+        }
+
+        /**
+         * @brief Get the page size backing buffers allocated from the OS
+         */
+        HugePages getHugePages(){
+            std::lock_guard<std::mutex> lock(mtx);
+            return huge_pages;
+        }
+
+        /**
+         * @brief Set the bound of the memory retained for reuse. Memory already retained above the bound is kept until release.
+         *
+         * @param bytes Capacity in bytes; 0 disables reuse
+         */
+        void setCapacity(std::size_t bytes){
+            std::lock_guard<std::mutex> lock(mtx);
+            capacity = bytes;
+        }
+
+        /**
+         * @brief Get the bound of the memory retained for reuse
+         */
+        std::size_t getCapacity(){
+            std::lock_guard<std::mutex> lock(mtx);
+            return capacity;
+        }
+
+        /**
+         * @brief Get the allocation statistics of the arena
+         */
+        ArenaStats getStats(){
+            std::lock_guard<std::mutex> lock(mtx);
+            return stats;
+        }
+
+        private:
+        Arena() = default;
+
+        ~Arena(){
+            for(auto& buffer : pool){
+                freeBuffer(buffer.second, buffer.first);
+            }
+        }
+
+        static std::size_t roundUp(std::size_t bytes, std::size_t multiple){
+            return (std::max<std::size_t>(bytes, 1) + multiple - 1) / multiple * multiple;
+        }
+
+        /**
+         * @brief Map a buffer with the largest huge pages allowed by the mode and size, falling back to smaller pages
+         */
+        void* mapBuffer(std::size_t size){
+            #ifdef __linux__
+            const HugePages pages = getHugePages();
+            #ifdef MAP_HUGETLB
+            //Page size encodings of mmap, from <linux/mman.h>
+            constexpr int huge_2mb = 21 << 26, huge_1gb = 30 << 26;
+            if(pages == HugePages::Huge2MB || pages == HugePages::Huge1GB){
+                void* data = MAP_FAILED;
+                std::size_t length = 0;
+                if(pages == HugePages::Huge1GB && size >= (1UL << 30)){
+                    length = roundUp(size, 1UL << 30);
+                    data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge_1gb, -1, 0);
+                }
+                if(data == MAP_FAILED){
+                    length = roundUp(size, 1UL << 21);
+                    data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge_2mb, -1, 0);
+                }
+                if(data != MAP_FAILED){
+                    std::lock_guard<std::mutex> lock(mtx);
+                    huge_lengths[data] = length;
+                    stats.huge_bytes += length;
+                    return data;
+                }
+            }
+            #endif
+            void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(data == MAP_FAILED){
+                return nullptr;
+            }
+            if(pages != HugePages::Regular){
+                adviseHugePages(data, size);
+            }
+            return data;
+            #else
+            return std::aligned_alloc(alignment, size);
+            #endif
+        }
+
+        /**
+         * @brief Return a buffer to the OS
+         */
+        void freeBuffer(void* data, std::size_t size){
+            if(size < mapped_threshold){
+                std::free(data);
+                return;
+            }
+            #ifdef __linux__
+            std::size_t length = size;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                auto it = huge_lengths.find(data);
+                if(it != huge_lengths.end()){
+                    length = it->second;
+                    stats.huge_bytes -= length;
+                    huge_lengths.erase(it);
+                }
+            }
+            munmap(data, length);
+            #else
+            std::free(data);
+            #endif
+        }
+
+        std::mutex mtx;
+        HugePages huge_pages = HugePages::Transparent;
+        std::size_t capacity = default_capacity;
+        ArenaStats stats;
+        //Retained buffers by size
+        std::multimap<std::size_t, void*> pool;
+        //Mapped length of the buffers backed by explicit huge pages
+        std::unordered_map<void*, std::size_t> huge_lengths;
+        std::vector<std::function<void()>> release_hooks;
+    };
+
+    /**
+     * @brief Standard allocator of the arena, for containers of state-vector sized buffers
+     *
+     * @tparam T Element type
+     */
+    template<class T>
+    struct ArenaAllocator {
+        using value_type = T;
+
+        ArenaAllocator() = default;
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>&){}
+
+        T* allocate(std::size_t n){
+            return static_cast<T*>(Arena::getInstance().allocate(n * sizeof(T)));
+        }
+        void deallocate(T* data, std::size_t n){
+            Arena::getInstance().deallocate(data, n * sizeof(T));
+        }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U>&) const { return true; }
+        template<class U>
+        bool operator!=(const ArenaAllocator<U>&) const { return false; }
+    };
+
+    /**
+     * @brief Class definition of a pool of freed objects of the given type, recycled by size. Retained objects count towards the capacity of the arena, and are freed by Arena::release.
+     *
+     * @tparam T Type of the recycled objects
+     */
+    template<class T>
+    class Recycler{
+        public:
+        /**
+         * @brief Get the Instance object
+         *
+         * @return Recycler& Process-wide pool of objects of type T
+         */
+        static Recycler& getInstance(){
+            static Recycler recycler;
+            return recycler;
+        }
+
+        /**
+         * @brief Take a retained object of the given key, if any
+         *
+         * @param key Size of the object, e.g. its number of qubits
+         * @return std::unique_ptr<T> The object, or null if none is retained
+         */
+        std::unique_ptr<T> acquire(std::size_t key){
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = pool.find(key);
+            if(it == pool.end()){
+                return nullptr;
+            }
+            std::unique_ptr<T> object = std::move(it->second.object);
+            Arena::getInstance().unretain(it->second.bytes, true);
+            pool.erase(it);
+            return object;
+        }
+
+        /**
+         * @brief Retain the given object for reuse if within the capacity of the arena, freeing it otherwise
+         *
+         * @param key Size of the object, e.g. its number of qubits
+         * @param bytes Memory held by the object in bytes
+         * @param object The object
+         */
+        void recycle(std::size_t key, std::size_t bytes, std::unique_ptr<T> object){
+            if(object == nullptr || !Arena::getInstance().retain(bytes)){
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            pool.emplace(key, Entry{bytes, std::move(object)});
+        }
+
+        /**
+         * @brief Free all retained objects
+         */
+        void clear(){
+            std::multimap<std::size_t, Entry> released;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                released.swap(pool);
+            }
+            for(auto& entry : released){
+                Arena::getInstance().unretain(entry.second.bytes, false);
+            }
+        }
+
+        private:
+        Recycler(){
+            Arena::getInstance().addReleaseHook([]{ Recycler<T>::getInstance().clear(); });
+        }
+
+        ~Recycler(){
+            clear();
+        }
+
+        struct Entry {
+            std::size_t bytes;
+            std::unique_ptr<T> object;
+        };
+        std::mutex mtx;
+        std::multimap<std::size_t, Entry> pool;
+    };
+};
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file Philox.hpp
+ * @brief Counter-based random numbers by the Philox4x32-10 generator of Salmon et al., "Parallel random numbers: as easy as 1, 2, 3" (SC'11). Each number is a pure function of a (seed, stream, draw index) triple, so a stream may be started, skipped ahead or reproduced at any point, on any thread or rank, without shared state.
+ * @version 0.1
+ */
+
+#ifndef QNLP_PHILOX
+#define QNLP_PHILOX
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+namespace QNLP{
+    /**
+     * @brief Class definition of a stream of uniform random numbers in [0,1). Draw d of stream s under seed k is the Philox4x32-10 block of counter (d, s) and key k, so streams of distinct (seed, stream) pairs are independent, and the d-th draw of a stream is the same whatever was drawn before it.
+     */
+    class PhiloxStream{
+        public:
+        using Block = std::array<std::uint32_t, 4>;
+        using Key = std::array<std::uint32_t, 2>;
+
+        /**
+         * @brief Construct a new Philox Stream object at the first draw of the given stream
+         *
+         * @param seed Seed of the stream
+         * @param stream Index of the stream under the seed, e.g. a shot index
+         */
+        PhiloxStream(std::uint64_t seed = 0, std::uint64_t stream = 0){
+            this->seed(seed, stream);
+        }
+
+        /**
+         * @brief Restart at the first draw of the given stream
+         *
+         * @param seed Seed of the stream
+         * @param stream Index of the stream under the seed, e.g. a shot index
+         */
+        void seed(std::uint64_t seed, std::uint64_t stream = 0){
+            rng_seed = seed;
+            rng_stream = stream;
+            draw = 0;
+        }
+
+        /**
+         * @brief Draw the next uniform random number in [0,1) of the stream
+         */
+        double uniform(){
+            return uniform(rng_seed, rng_stream, draw++);
+        }
+
+        /**
+         * @brief Get the uniform random number in [0,1) of the given draw of a stream, as drawn by uniform() on a stream of the same seed and index
+         *
+         * @param seed Seed of the stream
+         * @param stream Index of the stream under the seed
+         * @param draw Index of the draw in the stream
+         */
+        static double uniform(std::uint64_t seed, std::uint64_t stream, std::uint64_t draw){
+            const Block x = philox4x32({lo(draw), hi(draw), lo(stream), hi(stream)}, {lo(seed), hi(seed)});
+            // The top 53 bits of the first 64 output bits fill the mantissa of a double
+            const std::uint64_t bits = (static_cast<std::uint64_t>(x[1]) << 32) | x[0];
+            return static_cast<double>(bits >> 11) * 0x1.0p-53;
+        }
+
+        /**
+         * @brief Get the Philox4x32-10 block of the given counter and key
+         */
+        static Block philox4x32(Block ctr, Key key){
+            ctr = round(ctr, key);
+            for(int r = 1; r < 10; r++){
+                key[0] += 0x9E3779B9;
+                key[1] += 0xBB67AE85;
+                ctr = round(ctr, key);
+            }
+            return ctr;
+        }
+
+        /**
+         * @brief Get a seed from the system entropy source, for streams not seeded by the user
+         */
+        static std::uint64_t randomSeed(){
+            std::random_device rd;
+            return (static_cast<std::uint64_t>(rd()) << 32) | rd();
+        }
+
+        /**
+         * @brief Get the seed of the stream
+         */
+        std::uint64_t getSeed() const {
+            return rng_seed;
+        }
+
+        /**
+         * @brief Get the index of the stream under its seed
+         */
+        std::uint64_t getStream() const {
+            return rng_stream;
+        }
+
+        /**
+         * @brief Get the index of the next draw of the stream
+         */
+        std::uint64_t getDrawIndex() const {
+            return draw;
+        }
+
+        /**
+         * @brief Move the stream to the given draw, skipping ahead or back without drawing
+         */
+        void setDrawIndex(std::uint64_t index){
+            draw = index;
+        }
+
+        private:
+        std::uint64_t rng_seed;
+        std::uint64_t rng_stream;
+        std::uint64_t draw;
+
+        static std::uint32_t lo(std::uint64_t x){ return static_cast<std::uint32_t>(x); }
+        static std::uint32_t hi(std::uint64_t x){ return static_cast<std::uint32_t>(x >> 32); }
+
+        static Block round(const Block& ctr, const Key& key){
+            const std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53) * ctr[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57) * ctr[2];
+            return {hi(p1) ^ ctr[1] ^ key[0], lo(p1), hi(p0) ^ ctr[3] ^ key[1], lo(p0)};
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file Placement.hpp
+ * @brief Thread binding and NUMA page placement of state-vectors. Placement is only applied on Linux; elsewhere, or where the system calls are unavailable, memory and threads are left as placed by the OS.
+ * @version 0.1
+ */
+
+#ifndef QNLP_PLACEMENT
+#define QNLP_PLACEMENT
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#ifdef __linux__
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+
+namespace QNLP{
+    /**
+     * @brief NUMA placement of the pages of a state-vector
+     */
+    enum class MemoryPlacement {
+        Default,    ///< As first touched by the register initialisation
+        FirstTouch, ///< Each page on the node of the OpenMP thread which owns it under a static schedule, as if first touched by that thread
+        Interleave  ///< Pages interleaved round-robin over all nodes
+    };
+
+    /**
+     * @brief Threading and memory placement options of a simulator
+     */
+    struct PlacementOptions {
+        int num_threads = 0;        ///< Number of OpenMP threads of the simulator's parallel regions; 0 keeps the OpenMP default of the calling thread
+        bool bind_threads = false;  ///< Bind each OpenMP thread to a distinct CPU of the process affinity mask for the duration of the simulator's parallel regions
+        MemoryPlacement memory = MemoryPlacement::Default;
+    };
+
+    /**
+     * @brief Effective placement of a simulator, as reported by the OS
+     */
+    struct PlacementInfo {
+        int num_threads = 1;                ///< Number of OpenMP threads
+        std::vector<int> thread_cpus;       ///< CPU each OpenMP thread runs on
+        std::vector<std::size_t> node_bytes;///< Bytes of the state-vector resident on each NUMA node; empty if unknown
+    };
+
+    /**
+     * @brief Get the number of NUMA nodes of the system, being 1 if unknown
+     */
+    inline int getNumNumaNodes(){
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string nodes;
+        if(!(online >> nodes)){
+            return 1;
+        }
+        // The online nodes are listed as ranges, e.g. "0-1" or "0,2-3"; the highest node bounds the count
+        const std::size_t last = nodes.find_last_of(",-");
+        return std::stoi(last == std::string::npos ? nodes : nodes.substr(last + 1)) + 1;
+    }
+
+    /**
+     * @brief Get the CPUs of the process affinity mask, being that of the process' main thread when first called. It is read once, so that threads bound by a simulator do not narrow the CPUs available to later ones.
+     */
+    inline const std::vector<int>& getProcessCpus(){
+        static const std::vector<int> cpus = [](){
+            std::vector<int> allowed_cpus;
+            #ifdef __linux__
+            cpu_set_t allowed;
+            if(sched_getaffinity(getpid(), sizeof(allowed), &allowed) == 0){
+                for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                    if(CPU_ISSET(cpu, &allowed)){
+                        allowed_cpus.push_back(cpu);
+                    }
+                }
+            }
+            #endif
+            return allowed_cpus;
+        }();
+        return cpus;
+    }
+
+    /**
+     * @brief Sets the number of OpenMP threads of the parallel regions started by the calling thread for the lifetime of the scope, and optionally binds each thread of that team to a distinct CPU of the process affinity mask (see getProcessCpus), cycling over the CPUs if there are more threads. On exit the previous number of threads and the previous affinity mask of each bound thread are restored, so that a simulator's placement does not leak into its caller. Scopes nested within a binding scope of the same thread keep its binding.
+     */
+    class ThreadScope {
+        public:
+        /**
+         * @brief Construct a new Thread Scope object
+         *
+         * @param num_threads Number of OpenMP threads; 0 keeps the current number
+         * @param bind Whether to bind the threads to CPUs
+         */
+        explicit ThreadScope(int num_threads, bool bind = false){
+            #ifdef _OPENMP
+            if(num_threads > 0){
+                saved_threads = omp_get_max_threads();
+                omp_set_num_threads(num_threads);
+            }
+            #endif
+            if(bind){
+                binding = true;
+                bound = (bindDepth()++ > 0) || bindTeam();
+            }
+        }
+
+        /**
+         * @brief Destroy the Thread Scope object, restoring the previous number of threads and affinity masks
+         */
+        ~ThreadScope(){
+            #ifdef __linux__
+            if(!saved_masks.empty()){
+                #pragma omp parallel num_threads(static_cast<int>(saved_masks.size()))
+                {
+                    int tid = 0;
+                    #ifdef _OPENMP
+                    tid = omp_get_thread_num();
+                    #endif
+                    sched_setaffinity(0, sizeof(cpu_set_t), &saved_masks[tid]);
+                }
+            }
+            #endif
+            if(binding){
+                bindDepth()--;
+            }
+            #ifdef _OPENMP
+            if(saved_threads > 0){
+                omp_set_num_threads(saved_threads);
+            }
+            #endif
+        }
+
+        ThreadScope(const ThreadScope&) = delete;
+        ThreadScope& operator=(const ThreadScope&) = delete;
+
+        /**
+         * @brief Check whether the threads are bound to CPUs within the scope
+         */
+        bool isBound() const {
+            return bound;
+        }
+
+        private:
+        int saved_threads = 0;
+        bool binding = false;
+        bool bound = false;
+        #ifdef __linux__
+        std::vector<cpu_set_t> saved_masks;
+        #endif
+
+        /**
+         * @brief Number of binding scopes open on the calling thread
+         */
+        static int& bindDepth(){
+            thread_local int depth = 0;
+            return depth;
+        }
+
+        /**
+         * @brief Save the affinity mask of each thread of the team of the calling thread, and bind it to its CPU
+         *
+         * @return true if all threads were bound
+         */
+        bool bindTeam(){
+            #ifdef __linux__
+            const std::vector<int>& cpus = getProcessCpus();
+            if(cpus.empty()){
+                return false;
+            }
+            int num_threads = 1;
+            #ifdef _OPENMP
+            num_threads = omp_get_max_threads();
+            #endif
+            saved_masks.resize(num_threads);
+            bool all_bound = true;
+            #pragma omp parallel num_threads(num_threads) reduction(&&:all_bound)
+            {
+                int tid = 0;
+                #ifdef _OPENMP
+                tid = omp_get_thread_num();
+                #endif
+                cpu_set_t cpu;
+                CPU_ZERO(&cpu);
+                CPU_SET(cpus[tid % cpus.size()], &cpu);
+                all_bound = (sched_getaffinity(0, sizeof(cpu_set_t), &saved_masks[tid]) == 0);
+                all_bound = all_bound && (sched_setaffinity(0, sizeof(cpu), &cpu) == 0);
+            }
+            return all_bound;
+            #else
+            return false;
+            #endif
+        }
+    };
+
+    /**
+     * @brief Get the CPU each thread of the OpenMP team of the calling thread runs on, or -1 if unknown
+     */
+    inline std::vector<int> getThreadCpus(){
+        int num_threads = 1;
+        #ifdef _OPENMP
+        num_threads = omp_get_max_threads();
+        #endif
+        std::vector<int> cpus(num_threads, -1);
+        #ifdef __linux__
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int tid = 0;
+            #ifdef _OPENMP
+            tid = omp_get_thread_num();
+            #endif
+            cpus[tid] = sched_getcpu();
+        }
+        #endif
+        return cpus;
+    }
+
+    /**
+     * @brief Move the pages of the given memory to the NUMA nodes selected by placement. Only pages wholly within the memory are moved.
+     *
+     * @param data Start of the memory
+     * @param bytes Size of the memory in bytes
+     * @param placement Placement of the pages; MemoryPlacement::Default leaves them in place
+     * @return true if the pages were placed
+     */
+    inline bool placePages(void* data, std::size_t bytes, MemoryPlacement placement){
+        #if defined(__linux__) && defined(SYS_mbind)
+        // From <numaif.h>, which is only shipped with libnuma
+        constexpr int mpol_preferred = 1, mpol_interleave = 3;
+        constexpr unsigned mpol_mf_move = (1 << 1);
+
+        const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+        const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+        const int num_nodes = getNumNumaNodes();
+        if(placement == MemoryPlacement::Default || end <= begin || num_nodes > 64){
+            return placement == MemoryPlacement::Default;
+        }
+
+        if(placement == MemoryPlacement::Interleave){
+            const unsigned long nodes = (num_nodes == 64) ? ~0UL : (1UL << num_nodes) - 1;
+            return syscall(SYS_mbind, begin, end - begin, mpol_interleave, &nodes, num_nodes + 1, mpol_mf_move) == 0;
+        }
+
+        // Each thread moves the pages of its static share of the memory to its own node
+        bool placed = true;
+        #pragma omp parallel reduction(&&:placed)
+        {
+            int tid = 0, num_threads = 1;
+            #ifdef _OPENMP
+            tid = omp_get_thread_num();
+            num_threads = omp_get_num_threads();
+            #endif
+            const std::size_t num_pages = (end - begin) / page;
+            const std::size_t chunk = (num_pages + num_threads - 1) / num_threads;
+            const std::size_t first = std::min(num_pages, tid * chunk), last = std::min(num_pages, first + chunk);
+            unsigned cpu = 0, node = 0;
+            if(first < last && syscall(SYS_getcpu, &cpu, &node, nullptr) == 0){
+                const unsigned long nodes = 1UL << node;
+                placed = syscall(SYS_mbind, begin + first*page, (last - first)*page, mpol_preferred, &nodes, num_nodes + 1, mpol_mf_move) == 0;
+            }
+        }
+        return placed;
+        #else
+        return placement == MemoryPlacement::Default;
+        #endif
+    }
+
+    /**
+     * @brief Get the number of bytes of the given memory resident on each NUMA node, counting only the pages wholly within it
+     *
+     * @return std::vector<std::size_t> Bytes per node; empty if the placement cannot be queried
+     */
+    inline std::vector<std::size_t> getNodeBytes(const void* data, std::size_t bytes){
+        std::vector<std::size_t> node_bytes;
+        #if defined(__linux__) && defined(SYS_move_pages)
+        const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+        const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+        if(end <= begin){
+            return node_bytes;
+        }
+        // With no target nodes, move_pages only reports the node of each page
+        std::vector<void*> pages((end - begin) / page);
+        std::vector<int> status(pages.size());
+        for(std::size_t i = 0; i < pages.size(); i++){
+            pages[i] = reinterpret_cast<void*>(begin + i*page);
+        }
+        if(syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0){
+            return node_bytes;
+        }
+        node_bytes.assign(getNumNumaNodes(), 0);
+        for(auto node : status){
+            if(node >= 0 && node < static_cast<int>(node_bytes.size())){
+                node_bytes[node] += page;
+            }
+        }
+        #endif
+        return node_bytes;
+    }
+};
+
+#endif
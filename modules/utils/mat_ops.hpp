@@ -11,6 +11,7 @@
 #define QNLP_MAT_OPS
 
 #include <complex>
+#include <type_traits>
 #include <vector>
 #include <iostream>
 
@@ -25,15 +26,17 @@ namespace QNLP{
     template <class Mat2x2Type>            
     const Mat2x2Type matrixSqrt(const Mat2x2Type& U){
         Mat2x2Type V(U);
-        std::complex<double> delta = U(0,0)*U(1,1) - U(0,1)*U(1,0);
-        std::complex<double> tau = U(0,0) + U(1,1);
-        std::complex<double> s = sqrt(delta);
-        std::complex<double> t = sqrt(tau + 2.0*s);
+        //Computed in the precision of the matrix elements
+        using ValueType = typename std::decay<decltype(U(0,0))>::type;
+        ValueType delta = U(0,0)*U(1,1) - U(0,1)*U(1,0);
+        ValueType tau = U(0,0) + U(1,1);
+        ValueType s = sqrt(delta);
+        ValueType t = sqrt(tau + ValueType(2.0)*s);
 
         //must be a way to vectorise these; TinyMatrix have a scale/shift option?
         V(0,0) += s;
         V(1,1) += s;
-        std::complex<double> scale_factor(1.,0.);
+        ValueType scale_factor(1.,0.);
         scale_factor /= t;
         V(0,0) *= scale_factor; //(std::complex<double>(1.,0.)/t);
         V(0,1) *= scale_factor; //(1/t);
@@ -53,7 +56,7 @@ namespace QNLP{
     template <class Mat2x2Type>            
     Mat2x2Type adjointMatrix(const Mat2x2Type& U){
         Mat2x2Type Uadjoint(U);
-        std::complex<double> tmp;
+        typename std::decay<decltype(U(0,0))>::type tmp;
         tmp = Uadjoint(0,1);
         Uadjoint(0,1) = Uadjoint(1,0);
         Uadjoint(1,0) = tmp;